@@ -0,0 +1,468 @@
+#include "FileAsyncEngine.h"
+#include "FileWorkerPool.h"
+
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define FH_ASYNC_URING
+#endif
+
+#if defined(__unix__)||defined(__unix)||defined(__linux__)||defined(__APPLE__)||defined(__MACH__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#define FH_ASYNC_POSIX
+#endif
+
+#define ASYNC_WAKE_TAG				(~0ULL)
+
+namespace FileObj
+{
+	/*
+		The function runs one request right away on the calling thread and returns its result.
+	*/
+	static long _runRequest(const async_request& request) noexcept
+	{
+#if defined(FH_ASYNC_POSIX)
+		const size_t count = std::min(request.count, (size_t)MAX_ASYNC_REQUEST_SIZE);
+		ssize_t done = 0;
+
+		if (request.op == asyncOp::stat)
+		{
+#if defined(STATX_BASIC_STATS)
+			return statx(AT_FDCWD, request.buffer, AT_STATX_SYNC_AS_STAT, STATX_BASIC_STATS, (struct statx*)request.result) ? -(long)errno : 0;
+#else
+			return -(long)ENOSYS;
+#endif
+		}
+		else if (request.op == asyncOp::read)
+		{
+			done = request.offset < 0 ? read(request.fd, request.buffer, count) : pread(request.fd, request.buffer, count, (off_t)request.offset);
+		}
+		else
+		{
+			done = request.offset < 0 ? write(request.fd, request.buffer, count) : pwrite(request.fd, request.buffer, count, (off_t)request.offset);
+		}
+
+		return done < 0 ? -(long)errno : (long)done;
+#else
+		(void)request;
+		return -(long)ENOSYS;
+#endif
+	}
+
+	/*
+		The function constructs the engine, and sets up its io_uring with place for queue_depth requests.
+		@ If use_ring is false or the io_uring can't be set up, the requests run on the shared worker pool.
+	*/
+	FileAsyncEngine::FileAsyncEngine(unsigned int queue_depth, const bool use_ring) : ring_fd(NON_WORK_RING), ring_entries(0),
+		sq_ring(nullptr), cq_ring(nullptr), sqes(nullptr), sq_ring_size(0), cq_ring_size(0), sqes_size(0),
+		sq_head(nullptr), sq_tail(nullptr), sq_mask(nullptr), sq_array(nullptr), cq_head(nullptr), cq_tail(nullptr), cq_mask(nullptr), cqes(nullptr),
+		ring_stat(false), in_flight(0), callbacks(), free_slots(), stopping(false), submit_mutex(), space_cv(), reaper()
+	{
+		if (queue_depth == 0) { queue_depth = DFLT_ASYNC_QUEUE_DEPTH; }
+
+		if (!use_ring || !this->setupRing(queue_depth)) { return; }
+
+		try
+		{
+			this->callbacks.resize(this->ring_entries);
+			this->free_slots.reserve(this->ring_entries);
+			for (unsigned int slot = this->ring_entries; slot > 0; slot--) { this->free_slots.push_back(slot - 1); }
+
+			this->reaper = thread(&FileAsyncEngine::reaperLoop, this);
+		}
+		catch (...)
+		{
+			this->closeRing();
+			this->callbacks.clear();
+			this->free_slots.clear();
+		}
+	}
+
+	/*
+		The function waits for all the requests in flight to end and closes the engine.
+	*/
+	FileAsyncEngine::~FileAsyncEngine()
+	{
+		if (!this->isUsingRing()) { return; }
+
+		{
+			unique_lock<mutex> lock(this->submit_mutex);
+			this->stopping = true;
+
+			async_request wake_request = { asyncOp::read, NON_WORK_RING, nullptr, 0, 0, nullptr, nullptr };
+			if (this->pushRequest(wake_request, ASYNC_WAKE_TAG)) { this->enterRing(1, 0, 0); } // The nop wakes the reaper if it is waiting
+		}
+
+		if (this->reaper.joinable()) { this->reaper.join(); }
+
+		this->closeRing();
+	}
+
+	/*
+		The function sets up the io_uring and maps its rings.
+		@ It fails if the kernel has no io_uring or it can't do plain reads and writes.
+	*/
+	bool FileAsyncEngine::setupRing(unsigned int entries) noexcept
+	{
+#if defined(FH_ASYNC_URING)
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+		if (fd < 0) { return false; }
+
+		this->ring_fd = fd;
+
+		// IORING_OP_READ and IORING_OP_WRITE came after io_uring itself, so they are probed first
+		char probe_data[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)] = { 0 };
+		io_uring_probe* probe = (io_uring_probe*)probe_data;
+
+		if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+			probe->last_op < IORING_OP_WRITE ||
+			!(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) ||
+			!(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED))
+		{
+			this->closeRing();
+			return false;
+		}
+
+		// IORING_OP_STATX came later, without it the stat requests run on the calling thread
+		this->ring_stat = probe->last_op >= IORING_OP_STATX && (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+
+		this->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		this->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		this->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+		const bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_map) { this->sq_ring_size = this->cq_ring_size = std::max(this->sq_ring_size, this->cq_ring_size); }
+
+		void* map = mmap(nullptr, this->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (map == MAP_FAILED) { this->closeRing(); return false; }
+		this->sq_ring = map;
+
+		if (single_map) { this->cq_ring = this->sq_ring; }
+		else
+		{
+			map = mmap(nullptr, this->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+			if (map == MAP_FAILED) { this->closeRing(); return false; }
+			this->cq_ring = map;
+		}
+
+		map = mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (map == MAP_FAILED) { this->closeRing(); return false; }
+		this->sqes = map;
+
+		char* sq_base = (char*)this->sq_ring;
+		char* cq_base = (char*)this->cq_ring;
+
+		this->sq_head = (unsigned int*)(sq_base + params.sq_off.head);
+		this->sq_tail = (unsigned int*)(sq_base + params.sq_off.tail);
+		this->sq_mask = (unsigned int*)(sq_base + params.sq_off.ring_mask);
+		this->sq_array = (unsigned int*)(sq_base + params.sq_off.array);
+		this->cq_head = (unsigned int*)(cq_base + params.cq_off.head);
+		this->cq_tail = (unsigned int*)(cq_base + params.cq_off.tail);
+		this->cq_mask = (unsigned int*)(cq_base + params.cq_off.ring_mask);
+		this->cqes = cq_base + params.cq_off.cqes;
+
+		// One place is kept for the nop that wakes the reaper at the end
+		this->ring_entries = std::min(params.sq_entries, params.cq_entries) - 1;
+
+		return true;
+#else
+		(void)entries;
+		return false;
+#endif
+	}
+
+	/*
+		The function unmaps the rings and closes the io_uring.
+	*/
+	void FileAsyncEngine::closeRing() noexcept
+	{
+#if defined(FH_ASYNC_URING)
+		if (this->sqes) { munmap(this->sqes, this->sqes_size); }
+		if (this->cq_ring && this->cq_ring != this->sq_ring) { munmap(this->cq_ring, this->cq_ring_size); }
+		if (this->sq_ring) { munmap(this->sq_ring, this->sq_ring_size); }
+		if (this->ring_fd >= 0) { close(this->ring_fd); }
+#endif
+
+		this->sqes = this->cq_ring = this->sq_ring = nullptr;
+		this->ring_fd = NON_WORK_RING;
+		this->ring_entries = 0;
+	}
+
+	/*
+		The function puts one request in the submission ring, without telling the kernel about it yet.
+		@ The wake tag puts a nop, which only wakes the reaper.
+		--> submit_mutex must be locked!
+	*/
+	bool FileAsyncEngine::pushRequest(async_request& request, unsigned long long user_data) noexcept
+	{
+#if defined(FH_ASYNC_URING)
+		const unsigned int tail = *this->sq_tail;
+		const unsigned int head = __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE);
+
+		if (tail - head > *this->sq_mask) { return false; }
+
+		const unsigned int index = tail & *this->sq_mask;
+		io_uring_sqe* sqe = (io_uring_sqe*)this->sqes + index;
+		memset(sqe, 0, sizeof(io_uring_sqe));
+
+		if (user_data == ASYNC_WAKE_TAG) { sqe->opcode = IORING_OP_NOP; }
+		else if (request.op == asyncOp::stat)
+		{
+			sqe->opcode = IORING_OP_STATX;
+			sqe->fd = AT_FDCWD;
+			sqe->addr = (unsigned long long)(uintptr_t)request.buffer;
+			sqe->len = STATX_BASIC_STATS;
+			sqe->off = (unsigned long long)(uintptr_t)request.result;
+			sqe->statx_flags = AT_STATX_SYNC_AS_STAT;
+		}
+		else
+		{
+			sqe->opcode = request.op == asyncOp::read ? IORING_OP_READ : IORING_OP_WRITE;
+			sqe->fd = request.fd;
+			sqe->addr = (unsigned long long)(uintptr_t)request.buffer;
+			sqe->len = (unsigned int)std::min(request.count, (size_t)MAX_ASYNC_REQUEST_SIZE);
+			sqe->off = request.offset < 0 ? (unsigned long long)-1 : (unsigned long long)request.offset; // -1 means the position of the file
+		}
+
+		sqe->user_data = user_data;
+		this->sq_array[index] = index;
+		__atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+		return true;
+#else
+		(void)request;
+		(void)user_data;
+		return false;
+#endif
+	}
+
+	/*
+		The function tells the kernel about the new requests and waits for min_complete requests to end.
+		@ Returns the amount of requests that were taken by the kernel, or -errno.
+	*/
+	int FileAsyncEngine::enterRing(unsigned int to_submit, unsigned int min_complete, unsigned int flags) noexcept
+	{
+#if defined(FH_ASYNC_URING)
+		long taken = syscall(__NR_io_uring_enter, this->ring_fd, to_submit, min_complete, flags, nullptr, 0);
+		return taken < 0 ? -errno : (int)taken;
+#else
+		(void)to_submit;
+		(void)min_complete;
+		(void)flags;
+		return -ENOSYS;
+#endif
+	}
+
+	/*
+		The function is the loop of the reaper thread, it takes the ended requests and calls their callbacks.
+		@ It ends after the engine is stopped and all the requests in flight ended.
+	*/
+	void FileAsyncEngine::reaperLoop() noexcept
+	{
+#if defined(FH_ASYNC_URING)
+		vector<std::pair<function<void(long)>, long>> done;
+		bool woken = false;
+
+		while (true)
+		{
+			{
+				unique_lock<mutex> lock(this->submit_mutex);
+				unsigned int head = *this->cq_head;
+				const unsigned int tail = __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE);
+
+				for (; head != tail; head++)
+				{
+					const io_uring_cqe* cqe = (const io_uring_cqe*)this->cqes + (head & *this->cq_mask);
+
+					if (cqe->user_data == ASYNC_WAKE_TAG) { woken = true; continue; }
+
+					const unsigned int slot = (unsigned int)cqe->user_data;
+					done.emplace_back(std::move(this->callbacks[slot]), (long)cqe->res);
+					this->callbacks[slot] = nullptr;
+					this->free_slots.push_back(slot);
+					this->in_flight--;
+				}
+
+				__atomic_store_n(this->cq_head, head, __ATOMIC_RELEASE);
+			}
+
+			if (!done.empty())
+			{
+				this->space_cv.notify_all();
+
+				for (auto& [callback, result] : done)
+				{
+					try { if (callback) { callback(result); } }
+					catch (...) {} // A callback that throws can't be allowed to kill the reaper
+				}
+
+				done.clear();
+			}
+
+			{
+				unique_lock<mutex> lock(this->submit_mutex);
+				if (this->stopping && woken && this->in_flight == 0) { return; }
+			}
+
+			int waited = this->enterRing(0, 1, IORING_ENTER_GETEVENTS);
+			if (waited < 0 && waited != -EINTR && waited != -EAGAIN && waited != -EBUSY) { return; }
+		}
+#endif
+	}
+
+	/*
+		The function submits a group of requests, with one system call when the io_uring is used.
+		@ The callbacks are moved out of the requests, and each one is called once its request ends
+			(from the engine's thread, or from a worker of the shared pool).
+		@ If there are more requests than places in the ring, it waits for places to free up.
+		@ Returns the amount of requests that were taken, they are always the first ones. The requests after them are left
+			as they were (with their callbacks), and nothing is called for them.
+		--> The buffers must live until the callbacks are called!
+	*/
+	size_t FileAsyncEngine::submit(async_request* requests, size_t count) noexcept
+	{
+		if (!requests || count == 0) { return 0; }
+
+		if (!this->isUsingRing())
+		{
+			FileWorkerPool& pool = FileWorkerPool::getSharedPool();
+
+			for (size_t i = 0; i < count; i++)
+			{
+				bool added = pool.addTask([request = requests[i]]()
+				{
+					long result = _runRequest(request);
+					if (request.callback) { request.callback(result); }
+				});
+
+				if (!added) { return i; }
+
+				requests[i].callback = nullptr;
+			}
+
+			return count;
+		}
+
+		size_t next = 0;
+
+		try
+		{
+			unique_lock<mutex> lock(this->submit_mutex);
+			if (this->stopping) { return 0; }
+
+			while (next < count)
+			{
+				if ((this->free_slots.empty() && std::this_thread::get_id() == this->reaper.get_id()) ||
+					(requests[next].op == asyncOp::stat && !this->ring_stat))
+				{
+					// Called from a callback, and the reaper can't wait for itself to free a place, so the request runs right here
+					// (and so does a stat that the io_uring can't do)
+					async_request request = std::move(requests[next++]);
+
+					lock.unlock();
+					long result = _runRequest(request);
+					try { if (request.callback) { request.callback(result); } }
+					catch (...) {}
+					lock.lock();
+
+					continue;
+				}
+
+				this->space_cv.wait(lock, [this]() { return !this->free_slots.empty(); });
+
+				unsigned int pushed = 0;
+
+				while (next < count && !this->free_slots.empty())
+				{
+					const unsigned int slot = this->free_slots.back();
+
+					if (!this->pushRequest(requests[next], slot)) { break; }
+
+					this->free_slots.pop_back();
+					this->callbacks[slot] = std::move(requests[next].callback);
+					this->in_flight++;
+					pushed++;
+					next++;
+				}
+
+				while (pushed > 0) // The kernel may take only a part of them when it is busy
+				{
+					int taken = this->enterRing(pushed, 0, 0);
+
+					if (taken < 0)
+					{
+						if (taken == -EINTR || taken == -EAGAIN || taken == -EBUSY) { std::this_thread::yield(); continue; }
+
+						next -= pushed;
+						this->unpushRequests(requests + next, pushed);
+						return next;
+					}
+
+					pushed -= (unsigned int)taken;
+				}
+			}
+		}
+		catch (...) {}
+
+		return next;
+	}
+
+	/*
+		The function takes the last count requests that weren't given to the kernel out of the submission ring.
+		@ Their slots are freed and their callbacks are moved back into the requests, which are in the order they were pushed.
+		--> submit_mutex must be locked!
+	*/
+	void FileAsyncEngine::unpushRequests(async_request* requests, unsigned int count) noexcept
+	{
+#if defined(FH_ASYNC_URING)
+		const unsigned int tail = *this->sq_tail - count;
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const io_uring_sqe* sqe = (const io_uring_sqe*)this->sqes + this->sq_array[(tail + i) & *this->sq_mask];
+			const unsigned int slot = (unsigned int)sqe->user_data;
+
+			requests[i].callback = std::move(this->callbacks[slot]);
+			this->callbacks[slot] = nullptr;
+			this->free_slots.push_back(slot);
+			this->in_flight--;
+		}
+
+		__atomic_store_n(this->sq_tail, tail, __ATOMIC_RELEASE);
+#else
+		(void)requests;
+		(void)count;
+#endif
+	}
+
+	/*
+		The function returns if the requests go through an io_uring (or else through the shared worker pool).
+	*/
+	bool FileAsyncEngine::isUsingRing() const noexcept { return this->ring_fd >= 0; }
+
+	/*
+		The function returns if the stat requests go through the io_uring too (or else they run on the calling thread).
+	*/
+	bool FileAsyncEngine::isStatInRing() const noexcept { return this->isUsingRing() && this->ring_stat; }
+
+	/*
+		The function returns the engine that is shared by all the file handlers.
+		@ It is a static function.
+	*/
+	FileAsyncEngine& FileAsyncEngine::getSharedEngine()
+	{
+		static FileAsyncEngine shared_engine;
+		return shared_engine;
+	}
+}
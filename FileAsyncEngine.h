@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using std::vector;
+using std::function;
+using std::thread;
+using std::mutex;
+using std::unique_lock;
+using std::condition_variable;
+
+#define DFLT_ASYNC_QUEUE_DEPTH		256
+#define MAX_ASYNC_REQUEST_SIZE		0x7FFFF000
+#define NON_WORK_RING				-1
+
+namespace FileObj
+{
+	/*
+		The operation of an asynchronous request.
+		stat --> Gets the metadata of the path in buffer (a C string) into result (a struct statx), the count and offset aren't used.
+	*/
+	enum class asyncOp
+	{
+		read, write, stat
+	};
+
+	typedef struct async_request // One asynchronous request
+	{
+		asyncOp op;
+		int fd;
+		char* buffer; // The place to read into or the data to write, it must live until the callback is called
+		size_t count; // Up to MAX_ASYNC_REQUEST_SIZE bytes are done by one request
+		long offset; // A negative offset means the position of the file (so the end of it for an append file)
+		function<void(long)> callback; // Gets the amount of bytes done, or -errno on faliure
+		void* result; // Where a stat request puts the metadata, it must live until the callback is called
+	} async_request;
+
+	/*
+		Runs read and write requests on files without waiting for them, and calls their callback when they are done.
+		@ On Linux the requests go through an io_uring, so many requests are in flight without a thread for each one,
+			and a group of requests is submitted with one system call. Elsewhere, or if io_uring can't be used,
+			the requests run on the shared worker pool.
+		--> The callbacks are called from the engine's thread, so they should be short!
+	*/
+	class FileAsyncEngine
+	{
+	private:
+		int ring_fd;
+		unsigned int ring_entries;
+		void* sq_ring;
+		void* cq_ring;
+		void* sqes;
+		size_t sq_ring_size;
+		size_t cq_ring_size;
+		size_t sqes_size;
+		unsigned int* sq_head; // The fields of the rings, inside their mappings
+		unsigned int* sq_tail;
+		unsigned int* sq_mask;
+		unsigned int* sq_array;
+		unsigned int* cq_head;
+		unsigned int* cq_tail;
+		unsigned int* cq_mask;
+		void* cqes;
+
+		bool ring_stat; // The io_uring can do statx
+
+		unsigned int in_flight;
+		vector<function<void(long)>> callbacks; // Callbacks of the requests in flight, by their slot
+		vector<unsigned int> free_slots;
+		bool stopping;
+		mutex submit_mutex;
+		condition_variable space_cv;
+		thread reaper;
+
+		bool setupRing(unsigned int entries) noexcept;
+		void closeRing() noexcept;
+		bool pushRequest(async_request& request, unsigned long long user_data) noexcept;
+		void unpushRequests(async_request* requests, unsigned int count) noexcept;
+		int enterRing(unsigned int to_submit, unsigned int min_complete, unsigned int flags) noexcept;
+		void reaperLoop() noexcept;
+
+	public:
+		FileAsyncEngine(unsigned int queue_depth = DFLT_ASYNC_QUEUE_DEPTH, const bool use_ring = true);
+		~FileAsyncEngine();
+
+		FileAsyncEngine(const FileAsyncEngine& other) = delete;
+		FileAsyncEngine(FileAsyncEngine&& other) = delete;
+		FileAsyncEngine& operator=(const FileAsyncEngine& other) = delete;
+		FileAsyncEngine& operator=(FileAsyncEngine&& other) = delete;
+
+		size_t submit(async_request* requests, size_t count) noexcept;
+		bool submit(async_request&& request) noexcept { return this->submit(&request, 1) == 1; }
+		bool isUsingRing() const noexcept;
+		bool isStatInRing() const noexcept;
+
+		static FileAsyncEngine& getSharedEngine();
+	};
+}
@@ -0,0 +1,196 @@
+#include "FileBufferPool.h"
+
+#include <new>
+
+namespace FileObj
+{
+	static inline int _getSizeClass(size_t size) noexcept
+	{
+		size_t class_size = BUFFER_POOL_MIN_CLASS;
+
+		for (int size_class = 0; size_class < BUFFER_POOL_CLASSES; size_class++, class_size <<= 1)
+		{
+			if (size <= class_size) { return size_class; }
+		}
+
+		return -1;
+	}
+
+	static inline char* _allocBuffer(size_t size) noexcept
+	{
+		return (char*)::operator new[](size, std::align_val_t(BUFFER_POOL_ALIGN), std::nothrow);
+	}
+
+	static inline void _freeBuffer(char* buffer) noexcept
+	{
+		::operator delete[](buffer, std::align_val_t(BUFFER_POOL_ALIGN));
+	}
+
+	/*
+		The buffers that a thread keeps for itself, they are used only with the shared pool.
+		@ When the thread ends they are given back to the shared pool.
+	*/
+	struct thread_buffer_cache
+	{
+		vector<char*> buffers[BUFFER_POOL_CLASSES];
+		size_t bytes = 0;
+
+		~thread_buffer_cache();
+	};
+
+	static thread_local thread_buffer_cache _thread_cache;
+	static thread_local bool _thread_cache_closed = false; // Handlers destroyed at the exit of the thread may come after the cache
+
+	thread_buffer_cache::~thread_buffer_cache()
+	{
+		_thread_cache_closed = true;
+
+		FileBufferPool& pool = FileBufferPool::getSharedPool();
+
+		for (unsigned int size_class = 0; size_class < BUFFER_POOL_CLASSES; size_class++)
+		{
+			for (char* buffer : this->buffers[size_class])
+			{
+				if (!pool.keepBuffer(buffer, size_class)) { _freeBuffer(buffer); }
+			}
+		}
+	}
+
+	/*
+		The function constructs the pool.
+		@ max_pooled_bytes - The most bytes of free buffers the pool keeps, buffers given back above it are freed.
+	*/
+	FileBufferPool::FileBufferPool(size_t max_pooled_bytes) : pooled_bytes(0), max_pooled_bytes(max_pooled_bytes) {}
+
+	/*
+		The function frees all the buffers that are kept in the pool.
+	*/
+	FileBufferPool::~FileBufferPool()
+	{
+		lock_guard<mutex> lock(this->pool_mutex);
+
+		for (vector<char*>& buffers : this->free_buffers)
+		{
+			for (char* buffer : buffers) { _freeBuffer(buffer); }
+			buffers.clear();
+		}
+
+		this->pooled_bytes = 0;
+	}
+
+	/*
+		The function keeps a free buffer of the given class in the pool.
+		@ Returns false if the pool is full, then the buffer should be freed.
+	*/
+	bool FileBufferPool::keepBuffer(char* buffer, unsigned int size_class) noexcept
+	{
+		const size_t class_size = (size_t)BUFFER_POOL_MIN_CLASS << size_class;
+
+		try
+		{
+			lock_guard<mutex> lock(this->pool_mutex);
+
+			if (this->pooled_bytes + class_size > this->max_pooled_bytes) { return false; }
+
+			this->free_buffers[size_class].push_back(buffer);
+			this->pooled_bytes += class_size;
+		}
+		catch (...) { return false; }
+
+		return true;
+	}
+
+	/*
+		The function borrows a page aligned buffer of at least size bytes.
+		@ Returns nullptr if the allocation failed.
+		--> The buffer must be given back with release and the same size!
+	*/
+	char* FileBufferPool::acquire(size_t size) noexcept
+	{
+		const int size_class = _getSizeClass(size);
+		if (size_class < 0) { return _allocBuffer(size); }
+
+		if (this == &FileBufferPool::getSharedPool() && !_thread_cache_closed && !_thread_cache.buffers[size_class].empty())
+		{
+			char* buffer = _thread_cache.buffers[size_class].back();
+			_thread_cache.buffers[size_class].pop_back();
+			_thread_cache.bytes -= (size_t)BUFFER_POOL_MIN_CLASS << size_class;
+
+			return buffer;
+		}
+
+		{
+			lock_guard<mutex> lock(this->pool_mutex);
+
+			if (!this->free_buffers[size_class].empty())
+			{
+				char* buffer = this->free_buffers[size_class].back();
+				this->free_buffers[size_class].pop_back();
+				this->pooled_bytes -= (size_t)BUFFER_POOL_MIN_CLASS << size_class;
+
+				return buffer;
+			}
+		}
+
+		return _allocBuffer((size_t)BUFFER_POOL_MIN_CLASS << size_class);
+	}
+
+	/*
+		The function gives back a buffer that was borrowed with acquire.
+		@ The buffer is kept by the thread first, then by the pool, and freed only if both are full.
+	*/
+	void FileBufferPool::release(char* buffer, size_t size) noexcept
+	{
+		if (buffer == nullptr) { return; }
+
+		const int size_class = _getSizeClass(size);
+		if (size_class < 0) { _freeBuffer(buffer); return; }
+
+		const size_t class_size = (size_t)BUFFER_POOL_MIN_CLASS << size_class;
+
+		if (this == &FileBufferPool::getSharedPool() && !_thread_cache_closed && _thread_cache.buffers[size_class].size() < BUFFER_CACHE_PER_CLASS &&
+			_thread_cache.bytes + class_size <= BUFFER_CACHE_MAX_BYTES)
+		{
+			try
+			{
+				_thread_cache.buffers[size_class].push_back(buffer);
+				_thread_cache.bytes += class_size;
+				return;
+			}
+			catch (...) {}
+		}
+
+		if (!this->keepBuffer(buffer, (unsigned int)size_class)) { _freeBuffer(buffer); }
+	}
+
+	/*
+		The function returns the amount of bytes of the free buffers kept in the pool (without the threads' buffers).
+	*/
+	size_t FileBufferPool::getPooledBytes() noexcept
+	{
+		lock_guard<mutex> lock(this->pool_mutex);
+		return this->pooled_bytes;
+	}
+
+	/*
+		The function returns the size of the buffers of the class that the given size belongs to.
+		@ Sizes above the biggest class are returned as they are.
+		@ It is a static function.
+	*/
+	size_t FileBufferPool::getClassSize(size_t size) noexcept
+	{
+		const int size_class = _getSizeClass(size);
+		return size_class < 0 ? size : (size_t)BUFFER_POOL_MIN_CLASS << size_class;
+	}
+
+	/*
+		The function returns the pool that is shared by all the file handlers.
+		@ It is never destroyed, so handlers that are destroyed at the exit of the program can still give back their buffers.
+		@ It is a static function.
+	*/
+	FileBufferPool& FileBufferPool::getSharedPool()
+	{
+		static FileBufferPool* shared_pool = new FileBufferPool();
+		return *shared_pool;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <mutex>
+
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+
+#define BUFFER_POOL_ALIGN			4096
+#define BUFFER_POOL_MIN_CLASS		4096
+#define BUFFER_POOL_CLASSES			12 // 4 KB, 8 KB, ... 8 MB
+#define DFLT_BUFFER_POOL_BYTES		67108864
+#define BUFFER_CACHE_PER_CLASS		2
+#define BUFFER_CACHE_MAX_BYTES		8388608
+
+namespace FileObj
+{
+	/*
+		A pool of page aligned I/O buffers that the file handlers borrow and give back, instead of allocating a buffer for every opened file.
+		@ The buffers are kept by size classes (powers of 2 from BUFFER_POOL_MIN_CLASS), a wanted size gets the buffer of its class.
+		@ Every thread keeps a few buffers of every class for itself, so most borrows don't take the pool's lock.
+		--> Sizes above the biggest class are allocated and freed as they are, without the pool.
+	*/
+	class FileBufferPool
+	{
+	private:
+		vector<char*> free_buffers[BUFFER_POOL_CLASSES];
+		size_t pooled_bytes;
+		size_t max_pooled_bytes;
+		mutex pool_mutex;
+
+		friend struct thread_buffer_cache;
+
+		bool keepBuffer(char* buffer, unsigned int size_class) noexcept;
+
+	public:
+		FileBufferPool(size_t max_pooled_bytes = DFLT_BUFFER_POOL_BYTES);
+		~FileBufferPool();
+
+		FileBufferPool(const FileBufferPool& other) = delete;
+		FileBufferPool(FileBufferPool&& other) = delete;
+		FileBufferPool& operator=(const FileBufferPool& other) = delete;
+		FileBufferPool& operator=(FileBufferPool&& other) = delete;
+
+		char* acquire(size_t size) noexcept;
+		void release(char* buffer, size_t size) noexcept;
+		size_t getPooledBytes() noexcept;
+
+		static size_t getClassSize(size_t size) noexcept;
+		static FileBufferPool& getSharedPool();
+	};
+}
@@ -0,0 +1,781 @@
+#include "FileCodec.h"
+
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <algorithm>
+
+#if defined(__GLIBC__)
+#include <sys/types.h>
+#define FH_CODEC_COOKIE
+#elif defined(__APPLE__) || defined(__MACH__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#define FH_CODEC_FUNOPEN
+#endif
+
+#if defined(FH_CODEC_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(FH_CODEC_ZSTD)
+#include <zstd.h>
+#endif
+
+#define GZIP_MAGIC_FIRST			0x1F
+#define GZIP_MAGIC_SECOND			0x8B
+#define ZSTD_MAGIC_NUMBER			0xFD2FB528U
+#define GZIP_WINDOW_BITS			(15 + 16)
+
+namespace FileObj
+{
+	struct codec_state // The state of the codec, kept out of the header so the codec libraries are needed only here
+	{
+#if defined(FH_CODEC_ZLIB)
+		z_stream zlib_stream;
+		bool zlib_ready = false;
+#endif
+#if defined(FH_CODEC_ZSTD)
+		ZSTD_CCtx* zstd_compress = nullptr;
+		ZSTD_DCtx* zstd_decompress = nullptr;
+#endif
+	};
+
+	/*
+		The function constructs a FileCodec object over the opened compressed file, the codec is set by setupState.
+	*/
+	FileCodec::FileCodec(FILE* raw, const bool& for_write, const bool& background) noexcept : raw(raw), for_write(for_write), type(codecType::none),
+		background(background), state(nullptr), in_begin(0), in_end(0), input_ended(false), member_ended(false), stream_ended(false), window_start(0),
+		window_pos(0), written_size(0), failed(false), stopping(false), worker_ended(false)
+	{
+	}
+
+	/*
+		The function destructs the FileCodec object, the thread must be stopped and the file closed before (see closeStream).
+	*/
+	FileCodec::~FileCodec()
+	{
+		if (this->state == nullptr) { return; }
+
+#if defined(FH_CODEC_ZLIB)
+		if (this->state->zlib_ready)
+		{
+			if (this->for_write) { deflateEnd(&this->state->zlib_stream); }
+			else { inflateEnd(&this->state->zlib_stream); }
+		}
+#endif
+#if defined(FH_CODEC_ZSTD)
+		ZSTD_freeCCtx(this->state->zstd_compress);
+		ZSTD_freeDCtx(this->state->zstd_decompress);
+#endif
+
+		delete this->state;
+		this->state = nullptr;
+	}
+
+	/*
+		The function makes the compressor or the decompressor of the codec.
+	*/
+	bool FileCodec::setupState(const int& level) noexcept
+	{
+		(void)level; // Not used when no codec is built in
+
+		this->state = new (std::nothrow) codec_state();
+		if (this->state == nullptr) { return false; }
+
+		switch (this->type)
+		{
+		case codecType::none: { return true; }
+#if defined(FH_CODEC_ZLIB)
+		case codecType::gzip:
+		{
+			z_stream& stream = this->state->zlib_stream;
+			memset(&stream, 0, sizeof(stream));
+
+			int val = this->for_write ? deflateInit2(&stream, level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9), Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) :
+				inflateInit2(&stream, GZIP_WINDOW_BITS);
+
+			this->state->zlib_ready = val == Z_OK;
+			return this->state->zlib_ready;
+		}
+#endif
+#if defined(FH_CODEC_ZSTD)
+		case codecType::zstd:
+		{
+			if (!this->for_write) { return (this->state->zstd_decompress = ZSTD_createDCtx()) != nullptr; }
+
+			this->state->zstd_compress = ZSTD_createCCtx();
+			if (this->state->zstd_compress == nullptr) { return false; }
+
+			return level < 0 || !ZSTD_isError(ZSTD_CCtx_setParameter(this->state->zstd_compress, ZSTD_c_compressionLevel, std::min(level, ZSTD_maxCLevel())));
+		}
+#endif
+		default:
+			return false;
+		}
+	}
+
+	/*
+		The function reads the next block of the compressed file, if all the read data was used.
+		@ Returns false if nothing is left to use.
+	*/
+	bool FileCodec::fillInput() noexcept
+	{
+		if (this->in_begin < this->in_end) { return true; }
+		if (this->input_ended) { return false; }
+
+		this->in_begin = 0;
+		this->in_end = fread(this->io_block.data(), sizeof(char), this->io_block.size(), this->raw);
+
+		if (this->in_end < this->io_block.size())
+		{
+			if (ferror(this->raw)) { this->failed = true; }
+			this->input_ended = true;
+		}
+
+		return this->in_end > 0;
+	}
+
+	/*
+		The function decompresses up to size bytes of the file into the data.
+		@ Returns the amount of bytes made, 0 at the end of the data, or -1 if the file is broken (or cut before its end).
+		@ Bytes after the last gzip member that don't start another one are ignored, like gzip does.
+	*/
+	long FileCodec::decodeBlock(char* data, size_t size) noexcept
+	{
+		size_t done = 0;
+
+		while (done < size && !this->stream_ended && !this->failed)
+		{
+			const bool has_input = this->fillInput();
+			if (this->failed) { return -1; }
+
+			switch (this->type)
+			{
+			case codecType::none:
+			{
+				if (!has_input) { this->stream_ended = true; break; }
+
+				const size_t count = std::min(size - done, this->in_end - this->in_begin);
+				memcpy(data + done, this->io_block.data() + this->in_begin, count);
+
+				this->in_begin += count;
+				done += count;
+				break;
+			}
+#if defined(FH_CODEC_ZLIB)
+			case codecType::gzip:
+			{
+				z_stream& stream = this->state->zlib_stream;
+
+				if (this->member_ended)
+				{
+					if (!has_input || (unsigned char)this->io_block[this->in_begin] != GZIP_MAGIC_FIRST) { this->stream_ended = true; break; }
+					if (inflateReset(&stream) != Z_OK) { return -1; }
+
+					this->member_ended = false;
+				}
+
+				stream.next_in = (Bytef*)this->io_block.data() + this->in_begin;
+				stream.avail_in = (uInt)(this->in_end - this->in_begin);
+				stream.next_out = (Bytef*)data + done;
+				stream.avail_out = (uInt)std::min(size - done, (size_t)UINT32_MAX);
+
+				const uInt in_size = stream.avail_in, out_size = stream.avail_out;
+				const int val = inflate(&stream, Z_NO_FLUSH);
+
+				this->in_begin += in_size - stream.avail_in;
+				done += out_size - stream.avail_out;
+
+				if (val == Z_STREAM_END) { this->member_ended = true; break; }
+				if (val != Z_OK && val != Z_BUF_ERROR) { return -1; }
+				if (!has_input && in_size == stream.avail_in && out_size == stream.avail_out) { return -1; } // The last member was cut
+
+				break;
+			}
+#endif
+#if defined(FH_CODEC_ZSTD)
+			case codecType::zstd:
+			{
+				ZSTD_inBuffer in = { this->io_block.data() + this->in_begin, this->in_end - this->in_begin, 0 };
+				ZSTD_outBuffer out = { data + done, size - done, 0 };
+
+				const size_t val = ZSTD_decompressStream(this->state->zstd_decompress, &out, &in);
+				if (ZSTD_isError(val)) { return -1; }
+
+				this->in_begin += in.pos;
+				done += out.pos;
+				if (in.pos > 0 || out.pos > 0) { this->member_ended = val == 0; } // Without progress it only hints the size of the next frame
+
+				if (!has_input && out.pos == 0) // Nothing is left inside the decompressor
+				{
+					if (!this->member_ended) { return -1; } // The last frame was cut
+					this->stream_ended = true;
+				}
+
+				break;
+			}
+#endif
+			default:
+				return -1;
+			}
+		}
+
+		return this->failed ? -1 : (long)done;
+	}
+
+	/*
+		The function compresses the data and writes it into the file, finish ends the stream (the gzip member or the zstd frame).
+	*/
+	bool FileCodec::encodeData(const char* data, size_t size, const bool& finish) noexcept
+	{
+		if (size == 0 && !finish) { return true; }
+
+		switch (this->type)
+		{
+		case codecType::none: { return fwrite(data, sizeof(char), size, this->raw) == size; }
+#if defined(FH_CODEC_ZLIB)
+		case codecType::gzip:
+		{
+			z_stream& stream = this->state->zlib_stream;
+
+			while (true) // A piece above the limit of zlib is given in parts, the last one finishes
+			{
+				const size_t piece = std::min(size, (size_t)UINT32_MAX);
+				const bool last = piece == size;
+
+				stream.next_in = (Bytef*)data;
+				stream.avail_in = (uInt)piece;
+
+				int val = Z_OK;
+
+				do
+				{
+					stream.next_out = (Bytef*)this->io_block.data();
+					stream.avail_out = (uInt)this->io_block.size();
+
+					val = deflate(&stream, (finish && last) ? Z_FINISH : Z_NO_FLUSH);
+					if (val == Z_STREAM_ERROR) { return false; }
+
+					const size_t made = this->io_block.size() - stream.avail_out;
+					if (made > 0 && fwrite(this->io_block.data(), sizeof(char), made, this->raw) != made) { return false; }
+				} while ((finish && last) ? val != Z_STREAM_END : stream.avail_out == 0);
+
+				if (last) { return true; }
+
+				data += piece;
+				size -= piece;
+			}
+		}
+#endif
+#if defined(FH_CODEC_ZSTD)
+		case codecType::zstd:
+		{
+			ZSTD_inBuffer in = { data, size, 0 };
+
+			while (true)
+			{
+				ZSTD_outBuffer out = { this->io_block.data(), this->io_block.size(), 0 };
+
+				const size_t left = ZSTD_compressStream2(this->state->zstd_compress, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+				if (ZSTD_isError(left)) { return false; }
+				if (out.pos > 0 && fwrite(this->io_block.data(), sizeof(char), out.pos, this->raw) != out.pos) { return false; }
+
+				if (finish ? left == 0 : in.pos == in.size) { return true; }
+			}
+		}
+#endif
+		default:
+			return false;
+		}
+	}
+
+	/*
+		The function adds the next decompressed block into the window, and drops the data that is more than CODEC_KEEP_SIZE bytes before the cursor.
+		@ Returns false at the end of the data or on faliure.
+	*/
+	bool FileCodec::fillWindow() noexcept
+	{
+		if (this->window_pos > CODEC_KEEP_SIZE)
+		{
+			const size_t drop = this->window_pos - CODEC_KEEP_SIZE;
+
+			this->window.erase(this->window.begin(), this->window.begin() + drop);
+			this->window_start += (long long)drop;
+			this->window_pos -= drop;
+		}
+
+		const size_t kept = this->window.size();
+
+		try
+		{
+			if (this->background)
+			{
+				unique_lock<mutex> lock(this->queue_mutex);
+				this->queue_cv.wait(lock, [this]() { return !this->queue.empty() || this->worker_ended; });
+
+				if (this->queue.empty()) { return false; }
+
+				this->window.insert(this->window.end(), this->queue.front().begin(), this->queue.front().end());
+				this->queue.pop_front();
+				this->queue_cv.notify_all();
+
+				return true;
+			}
+
+			this->window.resize(kept + CODEC_BLOCK_SIZE);
+		}
+		catch (...) { this->failed = true; return false; }
+
+		long made = this->decodeBlock(this->window.data() + kept, CODEC_BLOCK_SIZE);
+		if (made < 0) { this->failed = true; }
+
+		this->window.resize(kept + (size_t)std::max(made, 0L));
+
+		return made > 0;
+	}
+
+	/*
+		The function starts decompressing the file again from its start, for a seek before the kept data.
+	*/
+	bool FileCodec::restart() noexcept
+	{
+		this->stopWorker();
+
+		if (fseek(this->raw, 0, SEEK_SET)) { return false; }
+
+		switch (this->type)
+		{
+#if defined(FH_CODEC_ZLIB)
+		case codecType::gzip: { if (inflateReset(&this->state->zlib_stream) != Z_OK) { return false; } break; }
+#endif
+#if defined(FH_CODEC_ZSTD)
+		case codecType::zstd: { if (ZSTD_isError(ZSTD_DCtx_reset(this->state->zstd_decompress, ZSTD_reset_session_only))) { return false; } break; }
+#endif
+		default:
+			break;
+		}
+
+		this->in_begin = this->in_end = 0;
+		this->input_ended = false;
+		this->member_ended = false;
+		this->stream_ended = false;
+		this->failed = false;
+		this->window.clear();
+		this->window_start = 0;
+		this->window_pos = 0;
+
+		this->startWorker();
+
+		return true;
+	}
+
+	/*
+		The function starts the thread of the stream, if the stream works in the background.
+		--> If the thread can't be started, the stream works without it.
+	*/
+	void FileCodec::startWorker() noexcept
+	{
+		if (!this->background) { return; }
+
+		this->stopping = false;
+		this->worker_ended = false;
+
+		try { this->worker = thread(this->for_write ? &FileCodec::writeLoop : &FileCodec::readLoop, this); }
+		catch (...) { this->background = false; }
+	}
+
+	/*
+		The function stops the thread of the stream and waits for it.
+		@ A writing thread compresses all the queued blocks before it ends, a reading thread drops the blocks it made.
+	*/
+	void FileCodec::stopWorker() noexcept
+	{
+		if (!this->worker.joinable()) { return; }
+
+		{
+			lock_guard<mutex> lock(this->queue_mutex);
+			this->stopping = true;
+		}
+
+		this->queue_cv.notify_all();
+		this->worker.join();
+
+		if (!this->for_write) { this->queue.clear(); }
+	}
+
+	/*
+		The function is the loop of the reading thread, it decompresses blocks while fewer than CODEC_QUEUE_BLOCKS are waiting.
+	*/
+	void FileCodec::readLoop() noexcept
+	{
+		while (true)
+		{
+			{
+				unique_lock<mutex> lock(this->queue_mutex);
+				this->queue_cv.wait(lock, [this]() { return this->stopping || this->queue.size() < CODEC_QUEUE_BLOCKS; });
+
+				if (this->stopping) { return; }
+			}
+
+			vector<char> block;
+			long made = -1;
+
+			try
+			{
+				block.resize(CODEC_BLOCK_SIZE);
+				made = this->decodeBlock(block.data(), block.size());
+			}
+			catch (...) { this->failed = true; }
+
+			lock_guard<mutex> lock(this->queue_mutex);
+
+			if (made <= 0)
+			{
+				if (made < 0) { this->failed = true; }
+
+				this->worker_ended = true;
+				this->queue_cv.notify_all();
+				return;
+			}
+
+			block.resize((size_t)made);
+
+			try { this->queue.push_back(std::move(block)); }
+			catch (...) { this->failed = true; this->worker_ended = true; this->queue_cv.notify_all(); return; }
+
+			this->queue_cv.notify_all();
+		}
+	}
+
+	/*
+		The function is the loop of the writing thread, it compresses the queued blocks into the file.
+	*/
+	void FileCodec::writeLoop() noexcept
+	{
+		unique_lock<mutex> lock(this->queue_mutex);
+
+		while (true)
+		{
+			this->queue_cv.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+
+			if (this->queue.empty()) { this->worker_ended = true; return; }
+
+			vector<char> block = std::move(this->queue.front());
+			this->queue.pop_front();
+			lock.unlock();
+
+			const bool val = !this->failed && this->encodeData(block.data(), block.size(), false);
+
+			lock.lock();
+			if (!val) { this->failed = true; }
+			this->queue_cv.notify_all();
+		}
+	}
+
+	/*
+		The function gives the stream up to size decompressed bytes from the cursor.
+		@ Returns the amount of bytes given, 0 at the end of the data or -1 on faliure.
+	*/
+	long FileCodec::readData(char* data, size_t size) noexcept
+	{
+		if (this->for_write) { errno = EBADF; return -1; }
+
+		while (this->window_pos == this->window.size())
+		{
+			if (!this->fillWindow()) { if (this->failed) { errno = EIO; return -1; } return 0; }
+		}
+
+		const size_t count = std::min(size, this->window.size() - this->window_pos);
+		memcpy(data, this->window.data() + this->window_pos, count);
+		this->window_pos += count;
+
+		return (long)count;
+	}
+
+	/*
+		The function compresses the data that the stream writes, or queues it for the thread of the stream.
+		@ Returns the amount of bytes taken, or 0 on faliure (a write that failed in the thread fails the next writes).
+	*/
+	long FileCodec::writeData(const char* data, size_t size) noexcept
+	{
+		if (!this->for_write || this->failed) { errno = EIO; return 0; }
+
+		if (this->background)
+		{
+			try
+			{
+				this->pending.insert(this->pending.end(), data, data + size);
+
+				if (this->pending.size() >= CODEC_BLOCK_SIZE)
+				{
+					unique_lock<mutex> lock(this->queue_mutex);
+					this->queue_cv.wait(lock, [this]() { return this->queue.size() < CODEC_QUEUE_BLOCKS || this->worker_ended; });
+
+					if (this->worker_ended || this->failed) { errno = EIO; return 0; }
+
+					this->queue.push_back(std::move(this->pending));
+					this->pending = vector<char>();
+					this->queue_cv.notify_all();
+				}
+			}
+			catch (...) { errno = ENOMEM; return 0; }
+		}
+		else if (!this->encodeData(data, size, false)) { this->failed = true; errno = EIO; return 0; }
+
+		this->written_size += (long long)size;
+
+		return (long)size;
+	}
+
+	/*
+		The function moves the cursor of a read stream, a seek forward decompresses up to the wanted place.
+		@ A written stream only tells its position (the amount of data written into it).
+		@ Returns 0 and sets offset to the new position, or -1 on faliure.
+	*/
+	int FileCodec::seekData(long long& offset, int origin) noexcept
+	{
+		const long long position = this->for_write ? this->written_size : this->window_start + (long long)this->window_pos;
+		long long target = position;
+
+		switch (origin)
+		{
+		case SEEK_SET: { target = offset; break; }
+		case SEEK_CUR: { target = position + offset; break; }
+		case SEEK_END:
+		{
+			if (this->for_write) { target = this->written_size + offset; break; }
+
+			do { this->window_pos = this->window.size(); } while (this->fillWindow());
+
+			if (this->failed) { errno = EIO; return -1; }
+			target = this->window_start + (long long)this->window.size() + offset;
+			break;
+		}
+		default:
+			errno = EINVAL;
+			return -1;
+		}
+
+		if (this->for_write)
+		{
+			if (target != this->written_size) { errno = ESPIPE; return -1; }
+
+			offset = target;
+			return 0;
+		}
+
+		if (target < 0) { errno = EINVAL; return -1; }
+		if (target < this->window_start && !this->restart()) { errno = EIO; return -1; }
+
+		while (target > this->window_start + (long long)this->window.size())
+		{
+			this->window_pos = this->window.size();
+			if (!this->fillWindow()) { break; }
+		}
+
+		if (target > this->window_start + (long long)this->window.size()) { errno = this->failed ? EIO : EINVAL; return -1; } // After the end of the data
+
+		this->window_pos = (size_t)(target - this->window_start);
+		offset = target;
+
+		return 0;
+	}
+
+	/*
+		The function ends the stream: the rest of the written data is compressed and the stream is finished, and the file is closed.
+		@ Returns 0, or EOF if any write failed.
+	*/
+	int FileCodec::closeStream() noexcept
+	{
+		bool val = true;
+
+		if (this->for_write && this->background && !this->pending.empty())
+		{
+			lock_guard<mutex> lock(this->queue_mutex);
+
+			try { this->queue.push_back(std::move(this->pending)); }
+			catch (...) { val = false; }
+		}
+
+		this->stopWorker();
+
+		if (this->for_write) { val = val && !this->failed && this->encodeData(nullptr, 0, true); }
+		if (fclose(this->raw)) { val = false; }
+		this->raw = NULL;
+
+		return val ? 0 : EOF;
+	}
+
+	/*
+		The function returns the descriptor of the compressed file, for its metadata and access hints.
+	*/
+	int FileCodec::getFd() const noexcept
+	{
+#if defined(FH_CODEC_COOKIE) || defined(FH_CODEC_FUNOPEN)
+		return this->raw != NULL ? fileno(this->raw) : -1;
+#else
+		return -1;
+#endif
+	}
+
+	/*
+		The function returns the codec of the stream (none if a read file isn't compressed).
+	*/
+	codecType FileCodec::getType() const noexcept { return this->type; }
+
+	/*
+		The function opens the file at the path and returns a stream that compresses or decompresses its data.
+		@ raw_mode - The mode of the compressed file: "rb" reads it, "wb" makes it again and "ab" adds a new gzip member or zstd frame at its end.
+		@ codec is set to the codec of the stream, which is owned by the stream and freed when the stream is closed.
+		@ Returns NULL if the file can't be opened, the codec isn't built in, or the system can't make such streams.
+		@ It is a static function.
+	*/
+	FILE* FileCodec::openStream(const string& path, const char* raw_mode, const codec_options& options, FileCodec*& codec) noexcept
+	{
+		codec = nullptr;
+
+#if defined(FH_CODEC_COOKIE) || defined(FH_CODEC_FUNOPEN)
+		if (raw_mode == nullptr) { return NULL; }
+
+		const bool for_write = raw_mode[0] != 'r';
+
+		FILE* raw = fopen(path.c_str(), raw_mode);
+		if (raw == NULL) { return NULL; }
+
+		setvbuf(raw, NULL, _IONBF, 0); // The data is read and written in whole blocks
+
+		FileCodec* stream_codec = new (std::nothrow) FileCodec(raw, for_write, options.background);
+		if (stream_codec == nullptr) { fclose(raw); return NULL; }
+
+		try { stream_codec->io_block.resize(CODEC_BLOCK_SIZE); }
+		catch (...) { fclose(raw); delete stream_codec; return NULL; }
+
+		stream_codec->type = options.type;
+
+		if (options.type == codecType::detect)
+		{
+			if (for_write) { stream_codec->type = typeOfPath(path); }
+			else
+			{
+				stream_codec->fillInput();
+				stream_codec->type = detectType(stream_codec->io_block.data(), stream_codec->in_end - stream_codec->in_begin);
+			}
+		}
+
+		if (!isAvailable(stream_codec->type) || stream_codec->failed || !stream_codec->setupState(options.level))
+		{
+			fclose(raw);
+			delete stream_codec;
+			return NULL;
+		}
+
+#if defined(FH_CODEC_COOKIE)
+		cookie_io_functions_t functions;
+		functions.read = [](void* cookie, char* data, size_t size) -> ssize_t { return ((FileCodec*)cookie)->readData(data, size); };
+		functions.write = [](void* cookie, const char* data, size_t size) -> ssize_t { return ((FileCodec*)cookie)->writeData(data, size); };
+		functions.seek = [](void* cookie, off64_t* offset, int origin) -> int
+			{
+				long long place = (long long)*offset;
+				if (((FileCodec*)cookie)->seekData(place, origin)) { return -1; }
+
+				*offset = (off64_t)place;
+				return 0;
+			};
+		functions.close = [](void* cookie) -> int
+			{
+				int val = ((FileCodec*)cookie)->closeStream();
+				delete (FileCodec*)cookie;
+				return val;
+			};
+
+		FILE* stream = fopencookie(stream_codec, for_write ? "w" : "r", functions);
+#else
+		FILE* stream = funopen(stream_codec,
+			for_write ? nullptr : +[](void* cookie, char* data, int size) -> int { return (int)((FileCodec*)cookie)->readData(data, (size_t)size); },
+			for_write ? +[](void* cookie, const char* data, int size) -> int { return (int)((FileCodec*)cookie)->writeData(data, (size_t)size); } : nullptr,
+			[](void* cookie, fpos_t offset, int origin) -> fpos_t
+			{
+				long long place = (long long)offset;
+				return ((FileCodec*)cookie)->seekData(place, origin) ? (fpos_t)-1 : (fpos_t)place;
+			},
+			[](void* cookie) -> int
+			{
+				int val = ((FileCodec*)cookie)->closeStream();
+				delete (FileCodec*)cookie;
+				return val;
+			});
+#endif
+
+		if (stream == NULL)
+		{
+			fclose(raw);
+			delete stream_codec;
+			return NULL;
+		}
+
+		stream_codec->startWorker();
+		codec = stream_codec;
+
+		return stream;
+#else
+		(void)path; (void)raw_mode; (void)options;
+		return NULL;
+#endif
+	}
+
+	/*
+		The function checks if the codec was built in.
+		@ It is a static function.
+	*/
+	bool FileCodec::isAvailable(const codecType& type) noexcept
+	{
+		switch (type)
+		{
+		case codecType::none: { return true; }
+#if defined(FH_CODEC_ZLIB)
+		case codecType::gzip: { return true; }
+#endif
+#if defined(FH_CODEC_ZSTD)
+		case codecType::zstd: { return true; }
+#endif
+		default:
+			return false;
+		}
+	}
+
+	/*
+		The function finds the codec of the data by its first bytes, none if it isn't compressed.
+		@ It is a static function.
+	*/
+	codecType FileCodec::detectType(const char* data, size_t size) noexcept
+	{
+		if (data == nullptr) { return codecType::none; }
+
+		if (size >= 2 && (unsigned char)data[0] == GZIP_MAGIC_FIRST && (unsigned char)data[1] == GZIP_MAGIC_SECOND) { return codecType::gzip; }
+
+		if (size >= 4)
+		{
+			const unsigned int magic = (unsigned int)(unsigned char)data[0] | ((unsigned int)(unsigned char)data[1] << 8) |
+				((unsigned int)(unsigned char)data[2] << 16) | ((unsigned int)(unsigned char)data[3] << 24);
+
+			if (magic == ZSTD_MAGIC_NUMBER) { return codecType::zstd; }
+		}
+
+		return codecType::none;
+	}
+
+	/*
+		The function finds the codec of a written file by the extension of its path, ".zst" and ".zstd" are zstd and anything else is gzip.
+		@ It is a static function.
+	*/
+	codecType FileCodec::typeOfPath(const string& path) noexcept
+	{
+		auto pos = path.find_last_of("./");
+		if (pos == string::npos || path[pos] != '.') { return codecType::gzip; }
+
+		string extension = path.substr(pos + 1);
+		for (char& ch : extension) { ch = (char)tolower((unsigned char)ch); }
+
+		return (extension == "zst" || extension == "zstd") ? codecType::zstd : codecType::gzip;
+	}
+}
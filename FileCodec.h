@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using std::string;
+using std::vector;
+using std::deque;
+using std::thread;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::condition_variable;
+
+#define CODEC_BLOCK_SIZE			262144
+#define CODEC_KEEP_SIZE				131072
+#define CODEC_QUEUE_BLOCKS			4
+#define DFLT_CODEC_LEVEL			-1
+
+namespace FileObj
+{
+	/*
+		The compression of a file.
+		detect --> A read file is known by its first bytes (a file that isn't compressed is read as it is), and a written file by its
+			extension (".zst" and ".zstd" are zstd, anything else is gzip).
+		none --> The data is read and written as it is.
+		gzip --> gzip members (zlib), members that were put one after the other are read as one stream.
+		zstd --> zstd frames, frames that were put one after the other are read as one stream.
+	*/
+	enum class codecType
+	{
+		detect, none, gzip, zstd
+	};
+
+	typedef struct codec_options // How a file is opened in the compressed modes
+	{
+		codecType type = codecType::detect;
+		int level = DFLT_CODEC_LEVEL; // DFLT_CODEC_LEVEL is the default level of the codec
+		bool background = false; // The data is compressed or decompressed on a thread of the stream, so it overlaps with the caller
+	} codec_options;
+
+	struct codec_state;
+
+	/*
+		A stream that compresses the data written into it and decompresses the data read from it, on the fly.
+		@ The stream is a FILE* (see openStream), so every stream function of the file handler works on it as on a plain file.
+		@ Decompressed data is made in blocks of CODEC_BLOCK_SIZE bytes, and the last CODEC_KEEP_SIZE bytes before the cursor
+			are kept, so the short seeks back of the line scans cost nothing. A seek before them decompresses again from the start.
+		@ With background, a thread of the stream compresses the written blocks (or decompresses up to CODEC_QUEUE_BLOCKS blocks ahead).
+		--> The stream can't be read or written by position, and a written stream can't seek. The compressed data is complete
+			only when the stream is closed!
+	*/
+	class FileCodec
+	{
+	private:
+		FILE* raw; // The compressed file
+		bool for_write;
+		codecType type;
+		bool background;
+		codec_state* state;
+
+		vector<char> io_block; // Compressed data read from the file, or made to be written into it
+		size_t in_begin;
+		size_t in_end;
+		bool input_ended;
+		bool member_ended; // A gzip member or a zstd frame ended, another one may follow it
+		bool stream_ended;
+
+		vector<char> window; // Decompressed data around the cursor
+		long long window_start;
+		size_t window_pos;
+		long long written_size;
+		vector<char> pending; // Written data that wasn't given to the thread yet
+
+		deque<vector<char>> queue; // Blocks between the caller and the thread
+		std::atomic<bool> failed;
+		bool stopping;
+		bool worker_ended;
+		mutex queue_mutex;
+		condition_variable queue_cv;
+		thread worker;
+
+		FileCodec(FILE* raw, const bool& for_write, const bool& background) noexcept;
+		~FileCodec();
+
+		bool setupState(const int& level) noexcept;
+		bool fillInput() noexcept;
+		long decodeBlock(char* data, size_t size) noexcept;
+		bool encodeData(const char* data, size_t size, const bool& finish) noexcept;
+		bool fillWindow() noexcept;
+		bool restart() noexcept;
+		void startWorker() noexcept;
+		void stopWorker() noexcept;
+		void readLoop() noexcept;
+		void writeLoop() noexcept;
+
+		long readData(char* data, size_t size) noexcept;
+		long writeData(const char* data, size_t size) noexcept;
+		int seekData(long long& offset, int origin) noexcept;
+		int closeStream() noexcept;
+
+	public:
+		FileCodec(const FileCodec& other) = delete;
+		FileCodec(FileCodec&& other) = delete;
+		FileCodec& operator=(const FileCodec& other) = delete;
+		FileCodec& operator=(FileCodec&& other) = delete;
+
+		int getFd() const noexcept;
+		codecType getType() const noexcept;
+
+		static FILE* openStream(const string& path, const char* raw_mode, const codec_options& options, FileCodec*& codec) noexcept;
+		static bool isAvailable(const codecType& type) noexcept;
+		static codecType detectType(const char* data, size_t size) noexcept;
+		static codecType typeOfPath(const string& path) noexcept;
+	};
+}
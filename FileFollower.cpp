@@ -0,0 +1,600 @@
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#define FH_FOLLOW_INOTIFY
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "FileFollower.h"
+
+namespace FileObj
+{
+	/*
+		The function constructs a FileFollower object, on Linux it makes its inotify, epoll and wake descriptors.
+		@ If one of them can't be made, the follower polls the files every poll_ms instead.
+	*/
+	FileFollower::FileFollower(unsigned int poll_ms) noexcept : files(), watches(), dirty(), next_id(1), poll_ms(poll_ms > 0 ? poll_ms : DFLT_FOLLOW_POLL_MS),
+		notify_fd(NON_WORK), epoll_fd(NON_WORK), wake_fd(NON_WORK), woken(false), stopping(false), next_check(std::chrono::steady_clock::now())
+	{
+		try { this->read_buffer.resize(FOLLOW_READ_BLOCK); }
+		catch (...) {}
+
+#if defined(FH_FOLLOW_INOTIFY)
+		this->notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		this->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		bool ready = this->notify_fd >= 0 && this->epoll_fd >= 0 && this->wake_fd >= 0;
+
+		for (int fd : { this->notify_fd, this->wake_fd })
+		{
+			if (!ready) { break; }
+
+			epoll_event event {};
+			event.events = EPOLLIN;
+			event.data.fd = fd;
+			ready = !epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+		}
+
+		if (!ready)
+		{
+			for (int* fd : { &this->notify_fd, &this->epoll_fd, &this->wake_fd })
+			{
+				if (*fd >= 0) { close(*fd); }
+				*fd = NON_WORK;
+			}
+		}
+#endif
+	}
+
+	/*
+		The function stops the thread of the follower (if it was started) and closes its descriptors.
+	*/
+	FileFollower::~FileFollower()
+	{
+		this->stop();
+
+#if defined(FH_FOLLOW_INOTIFY)
+		for (int fd : { this->notify_fd, this->epoll_fd, this->wake_fd })
+		{
+			if (fd >= 0) { close(fd); }
+		}
+#endif
+	}
+
+	/*
+		The function watches the path of the file with inotify.
+		@ A file that can't be watched (like when the limit of watches was reached) is checked every FOLLOW_CHECK_MS.
+		--> It is called with files_mutex locked.
+	*/
+	void FileFollower::addWatch(followed_file& file) noexcept
+	{
+#if defined(FH_FOLLOW_INOTIFY)
+		if (this->notify_fd < 0) { return; }
+
+		int watch = inotify_add_watch(this->notify_fd, file.path.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+		if (watch < 0) { return; }
+
+		try { this->watches[watch].push_back(file.id); }
+		catch (...) { return; }
+
+		file.watch = watch;
+#else
+		(void)file;
+#endif
+	}
+
+	/*
+		The function stops watching the file, the watch is removed when no other followed file shares it.
+		--> It is called with files_mutex locked.
+	*/
+	void FileFollower::removeWatch(followed_file& file) noexcept
+	{
+#if defined(FH_FOLLOW_INOTIFY)
+		if (file.watch == NON_WORK) { return; }
+
+		auto place = this->watches.find(file.watch);
+
+		if (place != this->watches.end())
+		{
+			vector<unsigned long long>& ids = place->second;
+			ids.erase(std::remove(ids.begin(), ids.end(), file.id), ids.end());
+
+			if (ids.empty())
+			{
+				inotify_rm_watch(this->notify_fd, file.watch);
+				this->watches.erase(place);
+			}
+		}
+#endif
+		file.watch = NON_WORK;
+	}
+
+	/*
+		The function reads all the waiting inotify events, and marks the files they are about as changed.
+		@ A file that was moved, removed or had its attributes changed (an unlink while it is open) is marked as lost, so its path is checked
+			in the same poll.
+	*/
+	void FileFollower::readNotify() noexcept
+	{
+#if defined(FH_FOLLOW_INOTIFY)
+		alignas(inotify_event) char events[FOLLOW_EVENTS_SIZE];
+
+		while (true)
+		{
+			ssize_t size = read(this->notify_fd, events, sizeof(events));
+			if (size <= 0) { return; }
+
+			lock_guard<mutex> lock(this->files_mutex);
+
+			try
+			{
+				for (char* place = events; place < events + size; place += sizeof(inotify_event) + ((inotify_event*)place)->len)
+				{
+					const inotify_event* event = (const inotify_event*)place;
+
+					if (event->mask & IN_Q_OVERFLOW) // Events were lost, so every file is read
+					{
+						for (auto& file : this->files) { this->dirty.insert(file.first); file.second->lost = true; }
+						this->next_check = std::chrono::steady_clock::now();
+						continue;
+					}
+
+					auto watched = this->watches.find(event->wd);
+					if (watched == this->watches.end()) { continue; }
+
+					for (unsigned long long id : watched->second)
+					{
+						auto file = this->files.find(id);
+						if (file == this->files.end()) { continue; }
+
+						this->dirty.insert(id);
+
+						if (event->mask & (IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED))
+						{
+							file->second->lost = true;
+							this->next_check = std::chrono::steady_clock::now(); // The path is checked in this poll
+						}
+
+						if (event->mask & IN_IGNORED) { file->second->watch = NON_WORK; } // The system removed the watch
+					}
+
+					if (event->mask & IN_IGNORED) { this->watches.erase(watched); }
+				}
+			}
+			catch (...) {}
+		}
+#endif
+	}
+
+	/*
+		The function checks the paths of the files that aren't watched or were lost with one batched stat (see FileHandler::statFiles).
+		@ A path that names another file now is opened again from its start, the rest of the old file is read before.
+		@ Without inotify every file is checked, and the files that grew or changed are read.
+		@ Returns the amount of events given.
+	*/
+	size_t FileFollower::checkPaths() noexcept
+	{
+		vector<std::shared_ptr<followed_file>> checked;
+		vector<string> paths;
+
+		try
+		{
+			lock_guard<mutex> lock(this->files_mutex);
+
+			for (auto& file : this->files)
+			{
+				if (this->notify_fd >= 0 && file.second->watch != NON_WORK && !file.second->lost) { continue; }
+
+				checked.push_back(file.second);
+				paths.push_back(file.second->path);
+			}
+		}
+		catch (...) {}
+
+		if (checked.empty()) { return 0; }
+
+		vector<retObj<file_meta>> metas = FileHandler::statFiles(paths);
+		size_t given = 0;
+
+		for (size_t i = 0; i < checked.size() && i < metas.size(); i++)
+		{
+			followed_file& file = *checked[i];
+			const file_meta& meta = metas[i].obj;
+
+			if (file.removed) { continue; }
+
+			if (metas[i].statusObj != ra_succss) { file.lost = true; given += this->readFile(file); continue; } // A writer may still have the old file open
+			if (meta.inode != file.meta.inode || meta.device != file.meta.device) { given += this->reopenFile(file); continue; }
+
+			file.lost = false;
+
+			{
+				lock_guard<mutex> lock(this->files_mutex);
+				if (!file.removed && file.watch == NON_WORK) { this->addWatch(file); }
+			}
+
+			if (meta.size != file.offset + (long)file.partial.size() || meta.mtime != file.meta.mtime || meta.mtime_ns != file.meta.mtime_ns)
+			{
+				given += this->readFile(file);
+			}
+		}
+
+		return given;
+	}
+
+	/*
+		The function reads the bytes that were added to the file since it was last read, and gives the complete lines in them.
+		@ If the file is shorter than the read part, it was truncated and is read again from its start.
+		@ Returns the amount of events given.
+	*/
+	size_t FileFollower::readFile(followed_file& file) noexcept
+	{
+		if (file.removed || this->read_buffer.empty() || !file.handler.isFileOpened()) { return 0; }
+
+		retObj<file_meta> meta = file.handler.getFileMeta(true);
+		if (meta.statusObj != ra_succss) { return 0; }
+
+		size_t given = 0;
+		long read_pos = file.offset + (long)file.partial.size();
+
+		if (meta.obj.size < read_pos)
+		{
+			file.offset = 0;
+			file.partial.clear();
+			read_pos = 0;
+			given += this->giveEvent(file, { followChange::truncated, file.id, &file.path, string_view(), 0 });
+		}
+
+		file.meta = meta.obj;
+
+		while (!file.removed)
+		{
+			retObj<read_result> got = file.handler.readAt(read_pos, this->read_buffer.data(), this->read_buffer.size());
+			if (got.statusObj != ra_succss || got.obj.count == 0) { break; }
+
+			const char* data = this->read_buffer.data();
+			const size_t size = got.obj.count;
+			size_t line_start = 0;
+
+			read_pos += (long)size;
+
+			try
+			{
+				for (const char* line_end; (line_end = (const char*)memchr(data + line_start, '\n', size - line_start)) != nullptr;)
+				{
+					const size_t line_size = (size_t)(line_end - data) - line_start;
+
+					if (file.partial.empty()) { given += this->giveLine(file, string_view(data + line_start, line_size)); }
+					else
+					{
+						file.partial.append(data + line_start, line_size);
+						given += this->giveLine(file, file.partial);
+						file.partial.clear();
+					}
+
+					line_start += line_size + 1;
+				}
+
+				file.partial.append(data + line_start, size - line_start);
+			}
+			catch (...) { file.offset = read_pos; file.partial.clear(); break; } // The line that didn't fit is dropped
+
+			if (got.obj.end_of_file) { break; }
+		}
+
+		return given;
+	}
+
+	/*
+		The function opens the file that the path names now, after the rest of the old file was read.
+		@ If there is no file at the path yet, the old one is kept and the path is checked again later.
+		@ Returns the amount of events given.
+	*/
+	size_t FileFollower::reopenFile(followed_file& file) noexcept
+	{
+		size_t given = this->readFile(file);
+
+		if (!file.partial.empty()) // The old file won't get the end of its last line anymore
+		{
+			given += this->giveLine(file, file.partial);
+			file.partial.clear();
+		}
+
+		FileHandler handler;
+		if (!handler.openFile(file.path, openFileModes::read_b, false, bufferType::non_buffer)) { file.lost = true; return given; }
+
+		retObj<file_meta> meta = handler.getFileMeta(true);
+		if (meta.statusObj != ra_succss) { file.lost = true; return given; }
+
+		file.handler = std::move(handler);
+		file.meta = meta.obj;
+		file.offset = 0;
+		file.lost = false;
+
+		{
+			lock_guard<mutex> lock(this->files_mutex);
+
+			if (!file.removed)
+			{
+				this->removeWatch(file);
+				this->addWatch(file);
+			}
+		}
+
+		given += this->giveEvent(file, { followChange::rotated, file.id, &file.path, string_view(), 0 });
+
+		return given + this->readFile(file);
+	}
+
+	/*
+		The function gives one complete line of the file, and moves the offset of the file after it.
+	*/
+	size_t FileFollower::giveLine(followed_file& file, string_view line) noexcept
+	{
+		const long offset = file.offset;
+		file.offset += (long)line.size() + 1;
+
+		if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+
+		return this->giveEvent(file, { followChange::line, file.id, &file.path, line, offset }) ? 1 : 0;
+	}
+
+	/*
+		The function calls the callback of the file, if it is still followed.
+		--> Exceptions of the callback are dropped, the other files are still followed.
+	*/
+	bool FileFollower::giveEvent(followed_file& file, const follow_event& event) noexcept
+	{
+		if (file.removed) { return false; }
+
+		try { file.callback(event); }
+		catch (...) {}
+
+		return true;
+	}
+
+	/*
+		The function wakes the thread that waits in poll.
+	*/
+	void FileFollower::wake() noexcept
+	{
+#if defined(FH_FOLLOW_INOTIFY)
+		if (this->wake_fd >= 0)
+		{
+			const uint64_t one = 1;
+			if (write(this->wake_fd, &one, sizeof(one)) < 0) {} // A full counter wakes it too
+			return;
+		}
+#endif
+		{
+			lock_guard<mutex> lock(this->files_mutex);
+			this->woken = true;
+		}
+
+		this->wake_cv.notify_all();
+	}
+
+	/*
+		The function polls until the follower is stopped.
+	*/
+	void FileFollower::loop() noexcept
+	{
+		while (true)
+		{
+			{
+				lock_guard<mutex> lock(this->files_mutex);
+				if (this->stopping) { return; }
+			}
+
+			this->poll(FOLLOW_CHECK_MS);
+		}
+	}
+
+	/*
+		The function starts following the file at the path, the new complete lines of it are given to the callback.
+		@ from_end starts after the current end of the file (like tail -F -n 0), else the lines already in it are given first.
+		@ Returns the id of the follow, or ra_fileisclosed_fail if the file couldn't be opened.
+	*/
+	retObj<unsigned long long> FileFollower::follow(const string& path, function<void(const follow_event&)>&& callback, const bool& from_end) noexcept
+	{
+		if (!callback) { return { 0, ra_outofrange_fail }; }
+
+		unsigned long long id = 0;
+
+		try
+		{
+			std::shared_ptr<followed_file> file = std::make_shared<followed_file>();
+			file->path = path;
+			FileHandler::fixPath(file->path);
+
+			if (!file->handler.openFile(file->path, openFileModes::read_b, false, bufferType::non_buffer)) { return { 0, ra_fileisclosed_fail }; }
+
+			retObj<file_meta> meta = file->handler.getFileMeta(true);
+			if (meta.statusObj != ra_succss) { return { 0, meta.statusObj }; }
+
+			file->callback = std::move(callback);
+			file->meta = meta.obj;
+			file->offset = from_end ? meta.obj.size : 0;
+			file->watch = NON_WORK;
+			file->lost = false;
+			file->removed = false;
+
+			lock_guard<mutex> lock(this->files_mutex);
+
+			id = file->id = this->next_id++;
+			this->files.emplace(id, file);
+			this->addWatch(*file);
+			if (!from_end) { this->dirty.insert(id); }
+		}
+		catch (...) { return { 0, ra_unknown_fail }; }
+
+		if (!from_end) { this->wake(); }
+
+		return { id, ra_succss };
+	}
+
+	/*
+		The function stops following the file of the id.
+		--> A callback of the file that is being called right now may still end after it returns.
+	*/
+	bool FileFollower::unfollow(unsigned long long id) noexcept
+	{
+		lock_guard<mutex> lock(this->files_mutex);
+
+		auto place = this->files.find(id);
+		if (place == this->files.end()) { return false; }
+
+		std::shared_ptr<followed_file> file = place->second; // The thread that polls may still use it
+		this->files.erase(place);
+		this->dirty.erase(id);
+		this->removeWatch(*file);
+		file->removed = true;
+
+		return true;
+	}
+
+	/*
+		The function waits up to timeout_ms (-1 is no limit) for changes of the followed files, and gives their new lines to the callbacks.
+		@ It returns after every wake up, so it may return before the timeout without giving anything.
+		@ Returns the amount of events given.
+		--> Only one thread polls at a time, it shouldn't be called while the follower was started.
+	*/
+	size_t FileFollower::poll(int timeout_ms) noexcept
+	{
+		lock_guard<mutex> poll_lock(this->poll_mutex);
+
+		long long wait_ms = std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(this->next_check - std::chrono::steady_clock::now()).count());
+		if (timeout_ms >= 0) { wait_ms = std::min<long long>(wait_ms, timeout_ms); }
+
+		{
+			lock_guard<mutex> lock(this->files_mutex);
+			if (!this->dirty.empty()) { wait_ms = 0; }
+		}
+
+#if defined(FH_FOLLOW_INOTIFY)
+		if (this->epoll_fd >= 0)
+		{
+			epoll_event events[2];
+			int count = epoll_wait(this->epoll_fd, events, 2, (int)wait_ms);
+
+			for (int i = 0; i < count; i++)
+			{
+				if (events[i].data.fd == this->notify_fd) { this->readNotify(); }
+				else
+				{
+					uint64_t value = 0;
+					if (read(this->wake_fd, &value, sizeof(value)) < 0) {} // Already read by another wake up
+				}
+			}
+		}
+		else
+#endif
+		{
+			unique_lock<mutex> lock(this->files_mutex);
+			this->wake_cv.wait_for(lock, std::chrono::milliseconds(wait_ms), [this]() { return this->woken || !this->dirty.empty(); });
+			this->woken = false;
+		}
+
+		size_t given = 0;
+
+		if (std::chrono::steady_clock::now() >= this->next_check)
+		{
+			given += this->checkPaths();
+			this->next_check = std::chrono::steady_clock::now() + std::chrono::milliseconds(this->isNotifying() ? FOLLOW_CHECK_MS : this->poll_ms);
+		}
+
+		vector<std::shared_ptr<followed_file>> changed;
+
+		try
+		{
+			lock_guard<mutex> lock(this->files_mutex);
+
+			for (unsigned long long id : this->dirty)
+			{
+				auto file = this->files.find(id);
+				if (file != this->files.end()) { changed.push_back(file->second); }
+			}
+
+			this->dirty.clear();
+		}
+		catch (...) {}
+
+		for (std::shared_ptr<followed_file>& file : changed) { given += this->readFile(*file); }
+
+		return given;
+	}
+
+	/*
+		The function starts a thread that polls the files, so the callbacks are called without calling poll.
+	*/
+	bool FileFollower::start() noexcept
+	{
+		lock_guard<mutex> lock(this->files_mutex);
+
+		if (this->loop_thread.joinable()) { return true; }
+
+		this->stopping = false;
+
+		try { this->loop_thread = thread(&FileFollower::loop, this); }
+		catch (...) { return false; }
+
+		return true;
+	}
+
+	/*
+		The function stops the thread that polls the files, and waits for it to end.
+		--> It must not be called from a callback, the callbacks are called by that thread!
+	*/
+	void FileFollower::stop() noexcept
+	{
+		thread stopped;
+
+		{
+			lock_guard<mutex> lock(this->files_mutex);
+
+			if (!this->loop_thread.joinable()) { return; }
+
+			this->stopping = true;
+			stopped = std::move(this->loop_thread);
+		}
+
+		this->wake();
+		stopped.join();
+	}
+
+	/*
+		The function returns the amount of followed files.
+	*/
+	size_t FileFollower::getCount() noexcept
+	{
+		lock_guard<mutex> lock(this->files_mutex);
+		return this->files.size();
+	}
+
+	/*
+		The function returns true if the files are watched with inotify, else they are polled.
+	*/
+	bool FileFollower::isNotifying() const noexcept
+	{
+		return this->epoll_fd >= 0;
+	}
+
+	/*
+		The function returns the follower that is shared by all the code, its thread is started on the first call.
+		@ It is a static function.
+	*/
+	FileFollower& FileFollower::getSharedFollower()
+	{
+		static FileFollower shared_follower;
+		static const bool started = shared_follower.start();
+		(void)started;
+
+		return shared_follower;
+	}
+}
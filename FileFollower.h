@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+
+#include "FileHandler.h"
+
+#define DFLT_FOLLOW_POLL_MS			250
+#define FOLLOW_CHECK_MS				1000
+#define FOLLOW_READ_BLOCK			65536
+#define FOLLOW_EVENTS_SIZE			16384
+
+namespace FileObj
+{
+	/*
+		What happened to a followed file.
+		line --> A complete new line was added (without its '\n', and '\r' before it is removed).
+		truncated --> The file got shorter than the read part, it is read again from its start.
+		rotated --> The path names another file now (it was moved or removed and made again), the new file is read from its start.
+			The last line of the old file is given before it, even without '\n'.
+	*/
+	enum class followChange
+	{
+		line, truncated, rotated
+	};
+
+	typedef struct follow_event // What the callback of a followed file gets
+	{
+		followChange change;
+		unsigned long long id; // The id follow returned
+		const string* path;
+		string_view line; // Valid only inside the callback
+		long offset; // The offset of the line in the file, 0 for truncated and rotated
+	} follow_event;
+
+	/*
+		Follows growing files (like logs, "tail -F"), and gives every complete line that is added to them to their callback.
+		@ Every file remembers the offset of its last given line, so only the new bytes are read (with pread, the files are
+			opened without a buffer).
+		@ On Linux one inotify descriptor watches all the files and is waited on with epoll, so one thread follows thousands of files.
+			Files that can't be watched, and paths whose file was moved or removed, are checked every FOLLOW_CHECK_MS with one batched stat.
+		@ Elsewhere (or without inotify) all the files are checked every poll_ms with one batched stat.
+		@ Truncation is seen by the size, rotation by the inode and device of the path against the opened file.
+		--> The callbacks are called from the thread that polls, one at a time, so they should be short!
+	*/
+	class FileFollower
+	{
+	private:
+		typedef struct followed_file
+		{
+			unsigned long long id;
+			string path;
+			function<void(const follow_event&)> callback;
+			FileHandler handler;
+			file_meta meta; // Of the opened file
+			long offset; // The start of the next line to give
+			string partial; // The bytes after offset that were read, a line without its '\n' yet
+			int watch; // The inotify watch, NON_WORK if it isn't watched
+			bool lost; // The path was moved or removed, it is checked until another file is there
+			std::atomic<bool> removed;
+		} followed_file;
+
+		std::unordered_map<unsigned long long, std::shared_ptr<followed_file>> files;
+		std::unordered_map<int, vector<unsigned long long>> watches; // More than one follow of the same file share a watch
+		std::unordered_set<unsigned long long> dirty; // Files that changed since the last poll
+		unsigned long long next_id;
+		unsigned int poll_ms;
+		int notify_fd;
+		int epoll_fd;
+		int wake_fd;
+		bool woken; // For the polling without epoll
+		bool stopping;
+		std::chrono::steady_clock::time_point next_check;
+		vector<char> read_buffer; // Used only by the thread that polls
+		mutex files_mutex;
+		mutex poll_mutex;
+		condition_variable wake_cv;
+		thread loop_thread;
+
+		void addWatch(followed_file& file) noexcept;
+		void removeWatch(followed_file& file) noexcept;
+		void readNotify() noexcept;
+		size_t checkPaths() noexcept;
+		size_t readFile(followed_file& file) noexcept;
+		size_t reopenFile(followed_file& file) noexcept;
+		size_t giveLine(followed_file& file, string_view line) noexcept;
+		bool giveEvent(followed_file& file, const follow_event& event) noexcept;
+		void wake() noexcept;
+		void loop() noexcept;
+
+	public:
+		FileFollower(unsigned int poll_ms = DFLT_FOLLOW_POLL_MS) noexcept;
+		~FileFollower();
+
+		FileFollower(const FileFollower& other) = delete;
+		FileFollower(FileFollower&& other) = delete;
+		FileFollower& operator=(const FileFollower& other) = delete;
+		FileFollower& operator=(FileFollower&& other) = delete;
+
+		retObj<unsigned long long> follow(const string& path, function<void(const follow_event&)>&& callback, const bool& from_end = true) noexcept;
+		bool unfollow(unsigned long long id) noexcept;
+		size_t poll(int timeout_ms = -1) noexcept;
+		bool start() noexcept;
+		void stop() noexcept;
+		size_t getCount() noexcept;
+		bool isNotifying() const noexcept;
+
+		static FileFollower& getSharedFollower();
+	};
+}
@@ -0,0 +1,424 @@
+#if defined(__unix__) || defined(__unix) || defined(__linux__) || defined(__APPLE__) || defined(__MACH__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FH_POSIX_IO
+#endif
+
+#include <cerrno>
+
+#include "FileHandleCache.h"
+
+#define NEGATIVE_CACHE_MAX_PATHS	4096
+
+namespace FileObj
+{
+	/*
+		The function constructs an empty handler, it isn't part of any cache.
+	*/
+	CachedHandle::CachedHandle() noexcept : cache(nullptr), key(), handler() {}
+
+	/*
+		The function constructs a handler that goes back to the given cache.
+	*/
+	CachedHandle::CachedHandle(FileHandleCache* cache, const string& key, FileHandler&& handler) noexcept : cache(cache), key(key), handler(std::move(handler)) {}
+
+	/*
+		The function moves the borrowed handler, the other object is left empty.
+	*/
+	CachedHandle::CachedHandle(CachedHandle&& other) noexcept : cache(other.cache), key(std::move(other.key)), handler(std::move(other.handler))
+	{
+		other.cache = nullptr;
+	}
+
+	/*
+		The function gives back the handler of this object and takes the borrowed handler of the other object.
+	*/
+	CachedHandle& CachedHandle::operator=(CachedHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			this->release();
+
+			this->cache = other.cache;
+			this->key = std::move(other.key);
+			this->handler = std::move(other.handler);
+			other.cache = nullptr;
+		}
+
+		return *this;
+	}
+
+	/*
+		The function gives the handler back to its cache now, the object is left empty.
+	*/
+	void CachedHandle::release() noexcept
+	{
+		if (this->cache != nullptr && this->handler.isFileOpened()) { this->cache->giveBack(this->key, std::move(this->handler)); }
+
+		this->cache = nullptr;
+	}
+
+	/*
+		The function closes the handler instead of giving it back to its cache.
+	*/
+	void CachedHandle::discard() noexcept
+	{
+		this->handler.closeFile();
+		this->cache = nullptr;
+	}
+
+	/*
+		The function checks if the object holds an opened handler.
+	*/
+	bool CachedHandle::isValid() const noexcept { return this->handler.isFileOpened(); }
+
+	/*
+		The function constructs the cache.
+		@ max_idle - The most idle handlers (so file descriptors) that are kept open.
+		@ negative_ttl_ms - For how long a file that wasn't found is remembered as missing.
+	*/
+	FileHandleCache::FileHandleCache(size_t max_idle, unsigned int negative_ttl_ms) : idle_handles(), idle_by_key(), missing_files(),
+		max_idle(max_idle), negative_ttl(negative_ttl_ms), validate(true), stats(), cache_mutex() {}
+
+	/*
+		The function closes all the idle handlers.
+		--> Borrowed handlers must be given back before the cache is destroyed!
+	*/
+	FileHandleCache::~FileHandleCache() { this->clear(); }
+
+	/*
+		The function makes the key of a handler by its path and open mode.
+		@ It is a static function.
+	*/
+	string FileHandleCache::makeKey(const string& path, const openFileModes& file_mode)
+	{
+		return path + '\n' + std::to_string((int)file_mode);
+	}
+
+	/*
+		The function gives a handler for the file, an idle one from the cache if there is one, else a newly opened one.
+		@ Returns ra_fileisclosed_fail if the file couldn't be opened (and a missing file is remembered as missing).
+		@ The returned handler goes back to the cache when it is destroyed.
+	*/
+	retObj<CachedHandle> FileHandleCache::acquire(const string& path, const openFileModes& file_mode, const bool thread_safe, const bufferType& buff_type, size_t buff_size) noexcept
+	{
+		try
+		{
+			string fixed_path = path;
+			FileHandler::fixPath(fixed_path);
+
+			const string key = makeKey(fixed_path, file_mode);
+			const bool must_exist = file_mode == openFileModes::read || file_mode == openFileModes::read_b || file_mode == openFileModes::read_p ||
+				file_mode == openFileModes::read_bp || file_mode == openFileModes::read_m || file_mode == openFileModes::read_d;
+
+			if (must_exist && this->isKnownMissing(fixed_path)) { return { CachedHandle(), ra_fileisclosed_fail }; }
+
+			FileHandler handler;
+			bool found = false;
+
+			{
+				lock_guard<mutex> lock(this->cache_mutex);
+				auto place = this->idle_by_key.find(key);
+
+				if (place != this->idle_by_key.end())
+				{
+					handler = std::move(place->second->handler);
+					this->idle_handles.erase(place->second);
+					this->idle_by_key.erase(place);
+					found = true;
+				}
+			}
+
+			if (found && this->validate && this->isStale(handler, fixed_path))
+			{
+				handler.closeFile();
+				found = false;
+
+				lock_guard<mutex> lock(this->cache_mutex);
+				this->stats.stale++;
+			}
+
+			if (found)
+			{
+				const bool truncate = file_mode == openFileModes::write || file_mode == openFileModes::write_b ||
+					file_mode == openFileModes::write_p || file_mode == openFileModes::write_bp || file_mode == openFileModes::write_d;
+
+#if defined(FH_POSIX_IO)
+				if (truncate && ftruncate(fileno(handler.file), 0)) { handler.closeFile(); found = false; }
+				handler.meta_valid = false;
+#else
+				if (truncate) { handler.closeFile(); found = false; } // Opened again so it is emptied
+#endif
+			}
+
+			if (found)
+			{
+				buff_size = std::clamp(buff_size, (size_t)MIN_BUFFER_SIZE, (size_t)MAX_BUFFER_SIZE);
+
+				handler.thread_safe = thread_safe;
+				handler.moveCursorInFile(filePosSet::start_file, 0);
+
+				if (handler.buffer_type != buff_type || (buff_type != bufferType::non_buffer && (size_t)handler.file_buffer_size != buff_size))
+				{
+					handler.changeFileBuffer(buff_type, buff_size);
+				}
+
+				{
+					lock_guard<mutex> lock(this->cache_mutex);
+					this->stats.hits++;
+				}
+
+				return { CachedHandle(this, key, std::move(handler)), ra_succss };
+			}
+
+			if (!handler.openFile(fixed_path, file_mode, thread_safe, buff_type, buff_size))
+			{
+				if (errno == ENOENT) { this->setMissing(fixed_path, true); }
+				return { CachedHandle(), ra_fileisclosed_fail };
+			}
+
+			this->setMissing(fixed_path, false);
+
+			{
+				lock_guard<mutex> lock(this->cache_mutex);
+				this->stats.misses++;
+			}
+
+			return { CachedHandle(this, key, std::move(handler)), ra_succss };
+		}
+		catch (...) { return { CachedHandle(), ra_unknown_fail }; }
+	}
+
+	/*
+		The function keeps a handler that was given back as idle, and closes the least recently used ones above the size of the cache.
+		@ The handler is flushed and cleared before it is kept, so the next one to take it gets it like new.
+	*/
+	void FileHandleCache::giveBack(const string& key, FileHandler&& handler) noexcept
+	{
+		if (!handler.isFileOpened()) { return; }
+
+		handler.setWriteBehind(false);
+		handler.flushFile();
+		handler.clearIngoring();
+		handler.clearLineIndex();
+
+		vector<FileHandler> evicted; // Closed after the lock is released
+
+		try
+		{
+			lock_guard<mutex> lock(this->cache_mutex);
+
+			this->idle_handles.push_front({ key, std::move(handler) });
+			this->idle_by_key.emplace(key, this->idle_handles.begin());
+			this->trimIdle(evicted);
+		}
+		catch (...) {}
+	}
+
+	/*
+		The function takes out the least recently used idle handlers while there are more than max_idle.
+		--> cache_mutex must be locked!
+	*/
+	void FileHandleCache::trimIdle(vector<FileHandler>& evicted) noexcept
+	{
+		while (this->idle_handles.size() > this->max_idle)
+		{
+			auto last = std::prev(this->idle_handles.end());
+			auto range = this->idle_by_key.equal_range(last->key);
+
+			for (auto place = range.first; place != range.second; place++)
+			{
+				if (place->second == last) { this->idle_by_key.erase(place); break; }
+			}
+
+			try { evicted.push_back(std::move(last->handler)); }
+			catch (...) {}
+
+			this->idle_handles.erase(last);
+			this->stats.evictions++;
+		}
+	}
+
+	/*
+		The function checks if the file was found missing lately.
+	*/
+	bool FileHandleCache::isKnownMissing(const string& path) noexcept
+	{
+		lock_guard<mutex> lock(this->cache_mutex);
+
+		auto place = this->missing_files.find(path);
+		if (place == this->missing_files.end()) { return false; }
+
+		if (std::chrono::steady_clock::now() - place->second < this->negative_ttl)
+		{
+			this->stats.negative_hits++;
+			return true;
+		}
+
+		this->missing_files.erase(place);
+
+		return false;
+	}
+
+	/*
+		The function remembers the file as missing, or forgets that it was missing.
+		@ When too many files are remembered, the old ones are dropped first.
+	*/
+	void FileHandleCache::setMissing(const string& path, const bool& missing) noexcept
+	{
+		try
+		{
+			lock_guard<mutex> lock(this->cache_mutex);
+
+			if (!missing) { this->missing_files.erase(path); return; }
+
+			auto now = std::chrono::steady_clock::now();
+
+			if (this->missing_files.size() >= NEGATIVE_CACHE_MAX_PATHS)
+			{
+				std::erase_if(this->missing_files, [&](const auto& entry) { return now - entry.second >= this->negative_ttl; });
+				if (this->missing_files.size() >= NEGATIVE_CACHE_MAX_PATHS) { this->missing_files.clear(); }
+			}
+
+			this->missing_files[path] = now;
+		}
+		catch (...) {}
+	}
+
+	/*
+		The function checks if the path of an idle handler points to another file now (or to nothing), since it was removed or replaced.
+	*/
+	bool FileHandleCache::isStale(FileHandler& handler, const string& path) noexcept
+	{
+#if defined(FH_POSIX_IO)
+		struct stat path_stat, handler_stat;
+
+		if (stat(path.c_str(), &path_stat) || fstat(fileno(handler.file), &handler_stat)) { return true; }
+
+		return path_stat.st_dev != handler_stat.st_dev || path_stat.st_ino != handler_stat.st_ino;
+#else
+		return !FileHandler::fileExists(path);
+#endif
+	}
+
+	/*
+		The function checks if the file exists, with one stat and without opening it.
+		@ A file that was found missing lately is returned as missing without a system call.
+	*/
+	bool FileHandleCache::exists(const string& path) noexcept
+	{
+		string fixed_path;
+
+		try { fixed_path = path; }
+		catch (...) { return false; }
+
+		FileHandler::fixPath(fixed_path);
+
+		if (this->isKnownMissing(fixed_path)) { return false; }
+
+		if (FileHandler::fileExists(fixed_path)) { return true; }
+
+		if (errno == ENOENT || errno == ENOTDIR) { this->setMissing(fixed_path, true); }
+
+		return false;
+	}
+
+	/*
+		The function forgets everything about the file: its idle handlers are closed and it isn't remembered as missing.
+		@ Should be called after the file was removed, renamed or created by others.
+	*/
+	void FileHandleCache::forget(const string& path) noexcept
+	{
+		vector<FileHandler> evicted;
+
+		try
+		{
+			string fixed_path = path;
+			FileHandler::fixPath(fixed_path);
+
+			const string prefix = fixed_path + '\n';
+			lock_guard<mutex> lock(this->cache_mutex);
+
+			this->missing_files.erase(fixed_path);
+
+			for (auto curr = this->idle_handles.begin(); curr != this->idle_handles.end();)
+			{
+				if (curr->key.compare(0, prefix.size(), prefix) != 0) { curr++; continue; }
+
+				auto range = this->idle_by_key.equal_range(curr->key);
+
+				for (auto place = range.first; place != range.second; place++)
+				{
+					if (place->second == curr) { this->idle_by_key.erase(place); break; }
+				}
+
+				evicted.push_back(std::move(curr->handler));
+				curr = this->idle_handles.erase(curr);
+			}
+		}
+		catch (...) {}
+	}
+
+	/*
+		The function closes all the idle handlers and forgets all the missing files.
+	*/
+	void FileHandleCache::clear() noexcept
+	{
+		std::list<idle_handle> evicted;
+
+		{
+			lock_guard<mutex> lock(this->cache_mutex);
+
+			this->idle_by_key.clear();
+			this->missing_files.clear();
+			evicted.swap(this->idle_handles);
+		}
+	}
+
+	/*
+		The function sets the most idle handlers that are kept open, the least recently used ones above it are closed.
+	*/
+	void FileHandleCache::setMaxIdle(size_t max_idle) noexcept
+	{
+		vector<FileHandler> evicted;
+
+		lock_guard<mutex> lock(this->cache_mutex);
+
+		this->max_idle = max_idle;
+		this->trimIdle(evicted);
+	}
+
+	/*
+		The function sets if an idle handler is checked to still be the file of its path when it is taken (one stat for every taking).
+	*/
+	void FileHandleCache::setValidate(const bool& validate) noexcept
+	{
+		lock_guard<mutex> lock(this->cache_mutex);
+		this->validate = validate;
+	}
+
+	/*
+		The function returns the counters of the cache.
+	*/
+	handle_cache_stats FileHandleCache::getStats() noexcept
+	{
+		lock_guard<mutex> lock(this->cache_mutex);
+
+		handle_cache_stats curr_stats = this->stats;
+		curr_stats.idle = this->idle_handles.size();
+
+		return curr_stats;
+	}
+
+	/*
+		The function returns the cache that is shared by the whole program.
+		@ It is never destroyed, so handlers given back at the exit of the program still have where to go.
+		@ It is a static function.
+	*/
+	FileHandleCache& FileHandleCache::getSharedCache()
+	{
+		static FileHandleCache* shared_cache = new FileHandleCache();
+		return *shared_cache;
+	}
+}
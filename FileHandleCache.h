@@ -0,0 +1,117 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <chrono>
+
+#include "FileHandler.h"
+
+#define DFLT_HANDLE_CACHE_SIZE		256
+#define DFLT_NEGATIVE_CACHE_MS		1000
+
+namespace FileObj
+{
+	class FileHandleCache;
+
+	/*
+		A file handler that is borrowed from a FileHandleCache, it is given back to the cache when it is destroyed.
+		@ It is used like a pointer to the handler.
+		--> Closing the handler (or calling discard) keeps it from going back to the cache.
+	*/
+	class CachedHandle
+	{
+	private:
+		FileHandleCache* cache;
+		string key;
+		FileHandler handler;
+
+		friend class FileHandleCache;
+
+		CachedHandle(FileHandleCache* cache, const string& key, FileHandler&& handler) noexcept;
+
+	public:
+		CachedHandle() noexcept;
+		CachedHandle(CachedHandle&& other) noexcept;
+		CachedHandle& operator=(CachedHandle&& other) noexcept;
+		~CachedHandle() { this->release(); }
+
+		CachedHandle(const CachedHandle& other) = delete;
+		CachedHandle& operator=(const CachedHandle& other) = delete;
+
+		FileHandler* operator->() noexcept { return &this->handler; }
+		FileHandler& operator*() noexcept { return this->handler; }
+		FileHandler& get() noexcept { return this->handler; }
+
+		void release() noexcept;
+		void discard() noexcept;
+		bool isValid() const noexcept;
+	};
+
+	typedef struct handle_cache_stats // Counters of a handle cache
+	{
+		unsigned long long hits; // Handlers that were taken from the cache without opening the file
+		unsigned long long misses; // Handlers that had to open the file
+		unsigned long long evictions; // Idle handlers that were closed to keep the cache in its size
+		unsigned long long stale; // Idle handlers that were closed since their path points to another file now
+		unsigned long long negative_hits; // Missing files that were found in the negative cache without a system call
+		size_t idle; // Amount of idle handlers kept open
+	} handle_cache_stats;
+
+	/*
+		Keeps the handlers of files that were used lately open, so opening the same file again costs no fopen.
+		@ Handlers are kept by their path and open mode, the least recently used idle handler is closed when there are
+			more idle handlers than the size of the cache (so the size is the budget of idle file descriptors).
+		@ A handler taken from the cache is like a new one: its cursor is at the start, ignoring and the line index
+			are cleared, and a write mode file is emptied again.
+		@ Files that weren't found are remembered for a short time, so checking them again costs no system call.
+		--> A kept handler whose path was removed or replaced is closed when it is taken (if validating is on).
+	*/
+	class FileHandleCache
+	{
+	private:
+		typedef struct idle_handle
+		{
+			string key;
+			FileHandler handler;
+		} idle_handle;
+
+		std::list<idle_handle> idle_handles; // The most recently used first
+		std::unordered_multimap<string, std::list<idle_handle>::iterator> idle_by_key;
+		std::unordered_map<string, std::chrono::steady_clock::time_point> missing_files; // When every missing file was checked
+		size_t max_idle;
+		std::chrono::milliseconds negative_ttl;
+		bool validate;
+		handle_cache_stats stats;
+		mutex cache_mutex;
+
+		friend class CachedHandle;
+
+		void giveBack(const string& key, FileHandler&& handler) noexcept;
+		void trimIdle(vector<FileHandler>& evicted) noexcept;
+		bool isKnownMissing(const string& path) noexcept;
+		void setMissing(const string& path, const bool& missing) noexcept;
+		bool isStale(FileHandler& handler, const string& path) noexcept;
+
+		static string makeKey(const string& path, const openFileModes& file_mode);
+
+	public:
+		FileHandleCache(size_t max_idle = DFLT_HANDLE_CACHE_SIZE, unsigned int negative_ttl_ms = DFLT_NEGATIVE_CACHE_MS);
+		~FileHandleCache();
+
+		FileHandleCache(const FileHandleCache& other) = delete;
+		FileHandleCache(FileHandleCache&& other) = delete;
+		FileHandleCache& operator=(const FileHandleCache& other) = delete;
+		FileHandleCache& operator=(FileHandleCache&& other) = delete;
+
+		retObj<CachedHandle> acquire(const string& path, const openFileModes& file_mode = DEFUALT_MODE_ENUM, const bool thread_safe = false,
+			const bufferType& buff_type = DEFUALT_BUFFER, size_t buff_size = DEFUALT_BUFFER_SIZE) noexcept;
+		bool exists(const string& path) noexcept;
+		void forget(const string& path) noexcept;
+		void clear() noexcept;
+		void setMaxIdle(size_t max_idle) noexcept;
+		void setValidate(const bool& validate) noexcept;
+		handle_cache_stats getStats() noexcept;
+
+		static FileHandleCache& getSharedCache();
+	};
+}
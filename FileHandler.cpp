@@ -1,4 +1,25 @@
+#if defined(__unix__) || defined(__unix) || defined(__linux__) || defined(__APPLE__) || defined(__MACH__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#if defined(__linux__)
+#include <sys/sysmacros.h>
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+#define FH_POSIX_IO
+#endif
+
+#include <cerrno>
+#include <cassert>
+#include <chrono>
+#include <regex>
+
 #include "FileHandler.h"
+#include "FileWorkerPool.h"
+#include "FileScanner.h"
+#include "FileBufferPool.h"
 
 namespace FileObj
 {
@@ -15,7 +36,7 @@ namespace FileObj
 			"\n\t-- File's name: " << data.file_name << " - File's extension: " << data.extension <<
 			"\n\t-- Buffer's Type: " << data.buffer_type << " (" << data.buffer_type_number << ")" <<
 			"\n\t-- Buffer's Size: " << data.buffer_size <<
-			"\n\t-- File's last move was: " << last_move_data << " Operation!" << std::endl;
+			"\n\t-- File's last move was: " << last_move_data << " Operation!" << std::endl << data.io;
 
 		return os;
 	}
@@ -39,6 +60,12 @@ namespace FileObj
 		case openFileModes::append_b: { return "ab"; }
 		case openFileModes::append_p: { return "a+"; }
 		case openFileModes::append_bp: { return "ab+"; }
+		case openFileModes::read_m: { return "rb"; }
+		case openFileModes::read_d: { return "rb"; }
+		case openFileModes::write_d: { return "wb"; }
+		case openFileModes::read_z: { return "rb"; }
+		case openFileModes::write_z: { return "wb"; }
+		case openFileModes::append_z: { return "ab"; }
 		default:
 			return DEFUALT_MODE;
 		}
@@ -46,88 +73,6 @@ namespace FileObj
 		return DEFUALT_MODE;
 	}
 
-	void FileHandler::getLineWithPromise(promise<retObj<string>>&& retVal, unsigned int numline, const int pos, unsigned int buff_size, const bool& auto_rewind, const bool& flush_file) noexcept
-	{
-		if (this->file != NULL)
-		{
-			if (this->file_access == openFileModes::read || this->file_access == openFileModes::read_p ||
-				this->file_access == openFileModes::write_p || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_b || this->file_access == openFileModes::read_bp ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_bp)
-			{
-				this->last_move = READ_OP;
-
-				if (flush_file && this->buffer_type != bufferType::non_buffer) { fflush(this->file); }
-
-				if (buff_size < MIN_BUFFER_GETLINE_SIZE || buff_size > MAX_BUFFER_GETLINE_SIZE) { buff_size = DFLT_BUFF_GLINE_SIZE; }
-
-				file_mutex.lock();
-				if (pos >= 0)
-				{
-					this->moveCursorInFile(filePosSet::start_file, pos);
-				}
-				else
-				{
-					this->moveCursorInFile(filePosSet::start_file);
-				}
-
-				if (feof(this->file)) { retVal.set_value({ "", ra_succss }); this->rewindFileOneStep(); file_mutex.unlock(); return; }
-
-				char tmp = 0;
-				char* data = new char[buff_size + 1]();
-				unsigned int ccount = 0, buffcount = 1;
-
-				while (!feof(this->file))
-				{
-					tmp = fgetc(this->file);
-					if (tmp == EOF || tmp == '\0' || (numline <= 0 && tmp == '\n')) break;
-					if (tmp == '\n') numline--;
-					if (tmp == '\r') continue;
-					if (numline <= 0 && tmp != '\n') data[ccount++] = tmp;
-					if (ccount > buff_size * buffcount)
-					{
-						char* ndata = new char[buff_size * (++buffcount) + 1]();
-						memcpy(ndata, data, buff_size * (buffcount - 1) + 1);
-						delete data;
-						data = ndata;
-					}
-				}
-
-				this->rewindFileOneStep();
-				file_mutex.unlock();
-
-				if ((tmp == EOF || tmp == '\0') && numline > 0) { retVal.set_value({ "", ra_endoffile_fail }); return; }
-
-				if (!this->clearCharsCanUse)
-				{
-					char* ndata = new char[ccount + 1]();
-
-					for (unsigned int i = 0, j = 0; i < ccount; i++)
-					{
-						const char ch = data[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[j] = ch;
-							j++;
-						}
-					}
-
-					delete data;
-					data = ndata;
-				}
-
-				string str = data;
-				delete data;
-				data = nullptr;
-
-				retVal.set_value({ str, ra_succss });
-				return;
-			}
-		}
-
-		retVal.set_value({ "", ra_fileisclosed_fail });
-	}
-
 	/*
 		The function fixes the string path by replacing back slash to forward slash.
 		@ It is a static function.
@@ -157,8 +102,12 @@ namespace FileObj
 	/*
 		The function constructs a FileHandler object.
 	*/
-	FileHandler::FileHandler() noexcept : file(NULL), file_buffer(NULL), thread_safe(false), file_buffer_size(0), buffer_type(DEFUALT_BUFFER),
-		file_access(DEFUALT_MODE_ENUM), last_move(0), last_file_place(SEEK_SET), clearCharsCanUse(true)
+	FileHandler::FileHandler() noexcept : file(NULL), file_buffer(NULL), file_buffer_size(0), clearCharsCanUse(true), thread_safe(false),
+		lock_shared_count(0), lock_exclusive_count(0), lock_shared_waits(0), lock_exclusive_waits(0), lock_wait_ns(0), io_counters(), observer(FileObserver::getGlobalObserver()),
+		buffer_type(DEFUALT_BUFFER), file_access(DEFUALT_MODE_ENUM), last_move(0), last_file_place(SEEK_SET), line_index_enabled(false), line_index_sidecar(false),
+		line_index_stopped(false), line_index_step(DFLT_LINE_INDEX_STEP), line_index_lines(0), line_index_end(0), access_hint(accessHint::normal), adaptive_buffer(false), adaptive_base_size(0), adaptive_next_pos(0), adaptive_seq_streak(0), adaptive_rand_streak(0), meta_cache(), meta_valid(false), meta_dirty(false), meta_written(false), meta_ttl_ms(DFLT_META_TTL_MS), meta_checked(), scan_cache(), scan_meta(), scan_valid(false),
+		direct_fd(NON_WORK), direct_align(DIRECT_IO_ALIGN), drop_start(0), drop_end(0), codec(nullptr), codec_settings(), map_data(nullptr), map_size(0), map_cursor(0), map_hint(accessHint::normal), char_filter_data(), char_filter_dirty(true),
+		behind_enabled(false), behind_busy(false), behind_stop(false), behind_failed(false), behind_high_water(DFLT_WRITE_BEHIND_MARK), behind_pending(0)
 	{
 		for (int i = 0; i < MAX_CHAR_CAPACITY; i++)
 		{
@@ -170,9 +119,14 @@ namespace FileObj
 		The function constructs a FileHandler object by trying to open a file.
 	*/
 	FileHandler::FileHandler(const string& path, const openFileModes& file_mode, const bool thread_safe, const bufferType& buff_type, size_t buff_size)
-		: file(NULL), file_buffer(NULL), thread_safe(thread_safe), file_buffer_size(0), buffer_type(DEFUALT_BUFFER), file_access(DEFUALT_MODE_ENUM), last_move(0), last_file_place(SEEK_SET), clearCharsCanUse(true)
+		: file(NULL), file_buffer(NULL), file_buffer_size(0), clearCharsCanUse(true), thread_safe(thread_safe),
+		lock_shared_count(0), lock_exclusive_count(0), lock_shared_waits(0), lock_exclusive_waits(0), lock_wait_ns(0), io_counters(), observer(FileObserver::getGlobalObserver()),
+		buffer_type(DEFUALT_BUFFER), file_access(DEFUALT_MODE_ENUM), last_move(0), last_file_place(SEEK_SET), line_index_enabled(false), line_index_sidecar(false),
+		line_index_stopped(false), line_index_step(DFLT_LINE_INDEX_STEP), line_index_lines(0), line_index_end(0), access_hint(accessHint::normal), adaptive_buffer(false), adaptive_base_size(0), adaptive_next_pos(0), adaptive_seq_streak(0), adaptive_rand_streak(0), meta_cache(), meta_valid(false), meta_dirty(false), meta_written(false), meta_ttl_ms(DFLT_META_TTL_MS), meta_checked(), scan_cache(), scan_meta(), scan_valid(false),
+		direct_fd(NON_WORK), direct_align(DIRECT_IO_ALIGN), drop_start(0), drop_end(0), codec(nullptr), codec_settings(), map_data(nullptr), map_size(0), map_cursor(0), map_hint(accessHint::normal), char_filter_data(), char_filter_dirty(true),
+		behind_enabled(false), behind_busy(false), behind_stop(false), behind_failed(false), behind_high_water(DFLT_WRITE_BEHIND_MARK), behind_pending(0)
 	{
-		if (!(this->openFile(path, file_mode, this->thread_safe, buffer_type, buff_size))) { throw FileHandlerException("Error - FileHandler: File couldn't be opened!"); }
+		if (!(this->openFile(path, file_mode, this->thread_safe, buff_type, buff_size))) { throw FileHandlerException("Error - FileHandler: File couldn't be opened!"); }
 
 		for (int i = 0; i < MAX_CHAR_CAPACITY; i++)
 		{
@@ -180,6 +134,148 @@ namespace FileObj
 		}
 	}
 
+	/*
+		The function moves the opened file and all its state into a new object, the other object is left closed.
+		--> Line readers and write batches of the other object stop working!
+	*/
+	FileHandler::FileHandler(FileHandler&& other) noexcept : FileHandler()
+	{
+		bool behind = false;
+
+		{
+			FileHandlerLock lock(other);
+			behind = this->takeFrom(other);
+		}
+
+		if (behind) { this->setWriteBehind(true, this->behind_high_water); }
+	}
+
+	/*
+		The function closes the file of this object and moves the opened file and all the state of the other object into it.
+		@ Both objects are locked in the order of their addresses, so two threads that move them into each other don't deadlock.
+	*/
+	FileHandler& FileHandler::operator=(FileHandler&& other) noexcept
+	{
+		if (this == &other) { return *this; }
+
+		const bool this_first = std::less<FileHandler*>()(this, &other);
+		bool behind = false;
+
+		{
+			FileHandlerLock first_lock(this_first ? *this : other);
+			FileHandlerLock second_lock(this_first ? other : *this);
+
+			this->closeFile();
+			behind = this->takeFrom(other);
+		}
+
+		if (behind) { this->setWriteBehind(true, this->behind_high_water); } // Started after the locks are released
+
+		return *this;
+	}
+
+	/*
+		The function takes the file and the state of the other object, which is left closed.
+		@ The mutexes aren't moved, and a write-behind flusher of the other object is stopped.
+		@ Returns true if the other object was in the write-behind mode, the caller starts it again for this object once it released the locks.
+		--> This object must be closed, and both objects must be locked by the caller!
+	*/
+	bool FileHandler::takeFrom(FileHandler& other) noexcept
+	{
+		const bool behind = other.behind_enabled;
+		this->behind_high_water = other.behind_high_water;
+		other.setWriteBehind(false);
+
+		this->file_path = std::move(other.file_path);
+		this->file_name = std::move(other.file_name);
+		this->extension = std::move(other.extension);
+		this->file = other.file;
+		this->file_buffer = other.file_buffer;
+		this->file_buffer_size = other.file_buffer_size;
+		memcpy(this->charsCanUse, other.charsCanUse, sizeof(this->charsCanUse));
+		this->clearCharsCanUse = other.clearCharsCanUse;
+
+		this->thread_safe = other.thread_safe;
+		this->lock_shared_count = other.lock_shared_count.load();
+		this->lock_exclusive_count = other.lock_exclusive_count.load();
+		this->lock_shared_waits = other.lock_shared_waits.load();
+		this->lock_exclusive_waits = other.lock_exclusive_waits.load();
+		this->lock_wait_ns = other.lock_wait_ns.load();
+		std::swap(this->io_counters, other.io_counters);
+		this->observer = other.getTracer();
+		this->buffer_type = other.buffer_type;
+		this->file_access = other.file_access;
+		this->last_move = other.last_move;
+		this->last_file_place = other.last_file_place;
+
+		this->line_index_enabled = other.line_index_enabled;
+		this->line_index_sidecar = other.line_index_sidecar;
+		this->line_index_stopped = other.line_index_stopped;
+		this->line_index_step = other.line_index_step;
+		this->line_index_lines = other.line_index_lines;
+		this->line_index_end = other.line_index_end;
+		this->line_index_offsets = std::move(other.line_index_offsets);
+
+		this->access_hint = other.access_hint;
+		this->adaptive_buffer = other.adaptive_buffer;
+		this->adaptive_base_size = other.adaptive_base_size;
+		this->adaptive_next_pos = other.adaptive_next_pos;
+		this->adaptive_seq_streak = other.adaptive_seq_streak;
+		this->adaptive_rand_streak = other.adaptive_rand_streak;
+
+		this->meta_cache = other.meta_cache;
+		this->meta_valid = other.meta_valid;
+		this->meta_dirty = other.meta_dirty;
+		this->meta_written = other.meta_written;
+		this->meta_ttl_ms = other.meta_ttl_ms;
+		this->meta_checked = other.meta_checked;
+		this->scan_cache = other.scan_cache;
+		this->scan_meta = other.scan_meta;
+		this->scan_valid = other.scan_valid;
+
+		this->direct_fd = other.direct_fd;
+		this->direct_align = other.direct_align;
+		this->drop_start = other.drop_start;
+		this->drop_end = other.drop_end;
+
+		this->codec = other.codec;
+		this->codec_settings = other.codec_settings;
+
+		this->map_data = other.map_data;
+		this->map_size = other.map_size;
+		this->map_cursor = other.map_cursor;
+		this->map_hint = other.map_hint;
+
+		this->line_chunk = std::move(other.line_chunk);
+		this->char_filter_dirty = true; // The compiled filter points to the table of the other object
+		this->filter_buffer = std::move(other.filter_buffer);
+
+		other.file = NULL;
+		other.file_buffer = NULL;
+		other.file_buffer_size = 0;
+		other.clearCharsCanUse = true;
+		for (int i = 0; i < MAX_CHAR_CAPACITY; i++) { other.charsCanUse[i] = true; }
+		other.char_filter_dirty = true;
+		other.thread_safe = false;
+		other.line_index_enabled = false;
+		other.line_index_sidecar = false;
+		other.resetLineIndex();
+		other.adaptive_buffer = false;
+		other.meta_valid = false;
+		other.scan_valid = false;
+		other.direct_fd = NON_WORK;
+		other.drop_start = other.drop_end = 0;
+		other.codec = nullptr;
+		other.map_data = nullptr;
+		other.map_size = 0;
+		other.map_cursor = 0;
+		other.file_path.clear();
+		other.file_name.clear();
+		other.extension.clear();
+
+		return behind;
+	}
+
 	/*
 		The function gets file's extension out of the path.
 		@ It is a static function.
@@ -198,20 +294,228 @@ namespace FileObj
 
 	/*
 		The function gets the file's length.
-		--> Might be slow so try to use the function only once and then store the value!
+		@ By default it is checked with one fstat on every call. After setMetaTtl the length comes from the metadata cache
+			(which follows the writes of this handler) for that time, so mostly it costs no system call.
+		--> With a time set, changes made by others are seen only after it!
 	*/
 	long FileHandler::getFilesLength() noexcept
 	{
+		FileHandlerLock lock(*this);
+
 		if (this->file == NULL)
 			return -1;
 
+		if (!this->meta_valid || this->meta_dirty || std::chrono::steady_clock::now() - this->meta_checked >= std::chrono::milliseconds(this->meta_ttl_ms))
+		{
+			if (!this->refreshMeta()) { return -1; }
+		}
+
+		return this->meta_cache.size;
+	}
+
+	/*
+		The function gets the metadata of the file (size, modification time, block size and inode).
+		@ By default it is checked with one fstat on every call. After setMetaTtl it is checked again only if the cache is older
+			than that time, the handler wrote since the last check (the size is known then, but not the modification time), or refresh is true.
+	*/
+	retObj<file_meta> FileHandler::getFileMeta(const bool& refresh) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL) { return { file_meta(), ra_fileisclosed_fail }; }
+
+		if (refresh || !this->meta_valid || this->meta_dirty || this->meta_written ||
+			std::chrono::steady_clock::now() - this->meta_checked >= std::chrono::milliseconds(this->meta_ttl_ms))
+		{
+			if (!this->refreshMeta()) { return { file_meta(), ra_updatetimefile_fail }; }
+		}
+
+		return { this->meta_cache, ra_succss };
+	}
+
+	/*
+		The function checks if the last scanStats of the file is still right, by the metadata of the file (its size, time and inode).
+		--> The handler's own writes drop the scan, changes made by others are seen like in getFileMeta.
+	*/
+	bool FileHandler::isScanCurrent() noexcept
+	{
+		if (!this->scan_valid) { return false; }
+
+		retObj<file_meta> meta = this->getFileMeta();
+		if (meta.statusObj != ra_succss) { return false; }
+
+		return meta.obj.size == this->scan_meta.size && meta.obj.mtime == this->scan_meta.mtime && meta.obj.mtime_ns == this->scan_meta.mtime_ns &&
+			meta.obj.inode == this->scan_meta.inode && meta.obj.device == this->scan_meta.device;
+	}
+
+	/*
+		The function sets for how long the metadata cache is trusted before it is checked again, against changes made by others.
+		@ 0 (the default) checks it on every call, with one fstat instead of seeking around the file.
+		--> A file that another process is growing is seen late by up to ttl_ms!
+	*/
+	void FileHandler::setMetaTtl(unsigned int ttl_ms) noexcept
+	{
+		FileHandlerLock lock(*this);
+		this->meta_ttl_ms = ttl_ms;
+	}
+
+	/*
+		The function fills the metadata cache from the file itself.
+		@ Pending writes are flushed first, so the size counts them.
+	*/
+	bool FileHandler::refreshMeta() noexcept
+	{
+		this->syncWriteBehind();
+		if (this->last_move == WRITE_OP) { this->flushStream(); }
+
+#if defined(FH_POSIX_IO)
+		struct stat file_stat;
+		FileStats::countSyscall(this->io_counters.get());
+		if (fstat(this->getFileFd(), &file_stat)) { this->meta_valid = false; return false; }
+
+		this->meta_cache.size = (long)file_stat.st_size;
+		this->meta_cache.mtime = file_stat.st_mtime;
+#if defined(__APPLE__) || defined(__MACH__)
+		this->meta_cache.mtime_ns = (long)file_stat.st_mtimespec.tv_nsec;
+#else
+		this->meta_cache.mtime_ns = (long)file_stat.st_mtim.tv_nsec;
+#endif
+		this->meta_cache.block_size = (size_t)file_stat.st_blksize;
+		this->meta_cache.inode = (unsigned long long)file_stat.st_ino;
+		this->meta_cache.device = (unsigned long long)file_stat.st_dev;
+#else
 		long curr_pos = ftell(this->file);
 
-		fseek(this->file, 0, SEEK_END);
-		long file_size = ftell(this->file);
-		fseek(this->file, curr_pos, SEEK_SET);
+		this->seekFile(0, SEEK_END);
+		this->meta_cache.size = ftell(this->file);
+		this->seekFile(curr_pos, SEEK_SET);
+
+		retObj<time_t> file_time = getFileTime(this->file_path);
+		this->meta_cache.mtime = file_time.statusObj == ra_succss ? file_time.obj : 0;
+		this->meta_cache.mtime_ns = 0;
+		this->meta_cache.block_size = BUFSIZ;
+		this->meta_cache.inode = 0;
+		this->meta_cache.device = 0;
+#endif
+
+		this->meta_valid = true;
+		this->meta_dirty = false;
+		this->meta_written = false;
+		this->meta_checked = std::chrono::steady_clock::now();
+
+		return true;
+	}
+
+	/*
+		The function keeps the metadata cache current after a write of this handler that ended at end.
+		@ If end isn't given, the write ended at the cursor of the file.
+	*/
+	void FileHandler::noteWrite(long end) noexcept
+	{
+		this->scan_valid = false; // The time of the file may not change between two quick writes, so it isn't trusted for the handler's own writes
+		if (!this->meta_valid) { return; }
+		if (this->codec != nullptr) { this->meta_dirty = true; return; } // The cursor is in the plain data, not in the file
+
+		if (end < 0) { end = ftell(this->file); }
+		if (end < 0) { this->meta_dirty = true; return; }
+
+		this->meta_cache.size = std::max(this->meta_cache.size, end);
+		this->meta_written = true;
+	}
+
+	/*
+		The function gets the metadata of many files at once, without opening them.
+		@ On Linux all the paths are checked with statx through the io_uring, in one system call for a group of them.
+		@ A path that can't be checked gets ra_updatetimefile_fail.
+		@ It is a static function.
+	*/
+	vector<retObj<file_meta>> FileHandler::statFiles(const vector<string>& paths) noexcept
+	{
+		vector<retObj<file_meta>> metas;
+
+		try { metas.assign(paths.size(), { file_meta(), ra_updatetimefile_fail }); }
+		catch (...) { return metas; }
+
+#if defined(FH_POSIX_IO) && defined(STATX_BASIC_STATS)
+		FileAsyncEngine& engine = FileAsyncEngine::getSharedEngine();
+
+		vector<struct statx> results;
+		vector<int> codes;
+		vector<async_request> requests;
+		mutex done_mutex;
+		condition_variable done_cv;
+		size_t left = paths.size();
+		size_t taken = 0;
+
+		try
+		{
+			results.resize(paths.size());
+			codes.assign(paths.size(), -ECANCELED);
+		}
+		catch (...) { return metas; }
+
+		try
+		{
+			if (engine.isStatInRing())
+			{
+				requests.reserve(paths.size());
+
+				for (size_t i = 0; i < paths.size(); i++)
+				{
+					requests.push_back({ asyncOp::stat, NON_WORK_RING, (char*)paths[i].c_str(), 0, 0, [&, i](long result)
+					{
+						lock_guard<mutex> lock(done_mutex);
+						codes[i] = (int)result;
+						if (--left == 0) { done_cv.notify_all(); }
+					}, &results[i] });
+				}
+
+				taken = engine.submit(requests.data(), requests.size());
+			}
+		}
+		catch (...) {}
+
+		for (size_t i = taken; i < paths.size(); i++) // The paths that the engine didn't take are checked here
+		{
+			codes[i] = statx(AT_FDCWD, paths[i].c_str(), AT_STATX_SYNC_AS_STAT, STATX_BASIC_STATS, &results[i]) ? -errno : 0;
+
+			lock_guard<mutex> lock(done_mutex);
+			left--;
+		}
+
+		{
+			unique_lock<mutex> lock(done_mutex);
+			done_cv.wait(lock, [&]() { return left == 0; });
+		}
+
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			if (codes[i] != 0) { continue; }
+
+			const struct statx& result = results[i];
+			metas[i] = { { (long)result.stx_size, (time_t)result.stx_mtime.tv_sec, (long)result.stx_mtime.tv_nsec, (size_t)result.stx_blksize,
+				(unsigned long long)result.stx_ino, (unsigned long long)makedev(result.stx_dev_major, result.stx_dev_minor) }, ra_succss };
+		}
+#elif defined(FH_POSIX_IO)
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			struct stat file_stat;
+			if (stat(paths[i].c_str(), &file_stat)) { continue; }
+
+			metas[i] = { { (long)file_stat.st_size, file_stat.st_mtime, 0, (size_t)file_stat.st_blksize,
+				(unsigned long long)file_stat.st_ino, (unsigned long long)file_stat.st_dev }, ra_succss };
+		}
+#else
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			FileHandler handler;
+			if (!handler.openFile(paths[i])) { continue; }
+
+			metas[i] = handler.getFileMeta(true);
+		}
+#endif
 
-		return file_size;
+		return metas;
 	}
 
 	/*
@@ -220,13 +524,11 @@ namespace FileObj
 	*/
 	FileHandler& FileHandler::operator<<(const char* str)
 	{
+		FileHandlerLock lock(*this);
+
 		if (this->file != NULL)
 		{
-			if (this->file_access == openFileModes::write || this->file_access == openFileModes::write_p ||
-				this->file_access == openFileModes::append || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_p || this->file_access == openFileModes::write_b ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_b ||
-				this->file_access == openFileModes::append_bp || this->file_access == openFileModes::read_bp)
+			if (this->canWriteFile())
 			{
 				this->last_move = WRITE_OP;
 
@@ -238,27 +540,10 @@ namespace FileObj
 
 				if (!this->clearCharsCanUse)
 				{
-					char* ndata = new char[length + 1]();
-					unsigned int nsize = 0;
-
-					for (unsigned int i = 0; i < length + 1; i++)
-					{
-						const char ch = str[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[nsize] = ch;
-							nsize++;
-						}
-					}
-
-					bool val = fwrite(ndata, sizeof(char), nsize, this->file) == nsize;
-
-					delete ndata;
-					ndata = nullptr;
-
-					if (val) return *this;
+					size_t nsize = this->filterToBuffer(str, length);
+					if (this->writeData(this->filter_buffer.data(), nsize)) return *this;
 				}
-				else if (fwrite(str, sizeof(char), length, this->file) == length) return *this;
+				else if (this->writeData(str, length)) return *this;
 
 				throw FileHandlerException("Error - FileHandler: Failed to write into the file!", ra_writefile_fail);
 			}
@@ -275,13 +560,11 @@ namespace FileObj
 	*/
 	FileHandler& FileHandler::operator<<(const string& str)
 	{
+		FileHandlerLock lock(*this);
+
 		if (this->file != NULL)
 		{
-			if (this->file_access == openFileModes::write || this->file_access == openFileModes::write_p ||
-				this->file_access == openFileModes::append || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_p || this->file_access == openFileModes::write_b ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_b ||
-				this->file_access == openFileModes::append_bp || this->file_access == openFileModes::read_bp)
+			if (this->canWriteFile())
 			{
 				this->last_move = WRITE_OP;
 
@@ -289,27 +572,10 @@ namespace FileObj
 
 				if (!this->clearCharsCanUse)
 				{
-					char* ndata = new char[str.size() + 1]();
-					unsigned int nsize = 0;
-
-					for (unsigned int i = 0; i < str.size() + 1; i++)
-					{
-						const char ch = str[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[nsize] = ch;
-							nsize++;
-						}
-					}
-
-					bool val = fwrite(ndata, sizeof(char), nsize, this->file) == nsize;
-
-					delete ndata;
-					ndata = nullptr;
-
-					if (val) return *this;
+					size_t nsize = this->filterToBuffer(str.c_str(), str.size());
+					if (this->writeData(this->filter_buffer.data(), nsize)) return *this;
 				}
-				else if (fwrite(str.c_str(), sizeof(char), str.size(), this->file) == str.size()) return *this;
+				else if (this->writeData(str.c_str(), str.size())) return *this;
 
 				throw FileHandlerException("Error - FileHandler: Failed to write into the file!", ra_writefile_fail);
 			}
@@ -326,13 +592,11 @@ namespace FileObj
 	*/
 	FileHandler& FileHandler::operator<<(string&& str)
 	{
+		FileHandlerLock lock(*this);
+
 		if (this->file != NULL)
 		{
-			if (this->file_access == openFileModes::write || this->file_access == openFileModes::write_p ||
-				this->file_access == openFileModes::append || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_p || this->file_access == openFileModes::write_b ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_b ||
-				this->file_access == openFileModes::append_bp || this->file_access == openFileModes::read_bp)
+			if (this->canWriteFile())
 			{
 				this->last_move = WRITE_OP;
 
@@ -340,27 +604,10 @@ namespace FileObj
 
 				if (!this->clearCharsCanUse)
 				{
-					char* ndata = new char[str.size() + 1]();
-					unsigned int nsize = 0;
-
-					for (unsigned int i = 0; i < str.size() + 1; i++)
-					{
-						const char ch = str[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[nsize] = ch;
-							nsize++;
-						}
-					}
-
-					bool val = fwrite(ndata, sizeof(char), nsize, this->file) == nsize;
-
-					delete ndata;
-					ndata = nullptr;
-
-					if (val) return *this;
+					size_t nsize = this->filterToBuffer(str.c_str(), str.size());
+					if (this->writeData(this->filter_buffer.data(), nsize)) return *this;
 				}
-				else if (fwrite(str.c_str(), sizeof(char), str.size(), this->file) == str.size()) return *this;
+				else if (this->writeData(str.c_str(), str.size())) return *this;
 
 				throw FileHandlerException("Error - FileHandler: Failed to write into the file!", ra_writefile_fail);
 			}
@@ -372,61 +619,28 @@ namespace FileObj
 	}
 
 	/*
-		The function enables the option to read data from the file.
+		The function reads the next line of the file and drops it, str isn't filled since its size isn't known.
+		--> The function is deprecated, use operator>>(string&) to get the line.
 		--> The function is throwable!
 	*/
 	FileHandler& FileHandler::operator>>(char* str)
 	{
+		FileHandlerLock lock(*this);
+
 		if (this->file != NULL)
 		{
 			this->last_move = READ_OP;
 
 			if (feof(this->file)) { throw FileHandlerException("Error - FileHandler: Failed to read from file -> End of file was reached!", ra_endoffile_fail); }
 
-			if (this->file_access == openFileModes::read || this->file_access == openFileModes::read_p ||
-				this->file_access == openFileModes::write_p || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_b || this->file_access == openFileModes::read_bp ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_bp)
+			if (this->canReadFile())
 			{
-				char tmp = 0;
-				char* data = new char[DFLT_BUFF_GLINE_SIZE + 1]();
-				unsigned int ccount = 0, buffcount = 1;
-
-				while (!feof(this->file))
-				{
-					tmp = fgetc(this->file);
-					if (tmp == EOF || tmp == '\0') break;
-					if (tmp == '\r') continue;
-					data[ccount++] = tmp;
-					if (ccount > DFLT_BUFF_GLINE_SIZE * buffcount)
-					{
-						char* ndata = new char[DFLT_BUFF_GLINE_SIZE * (++buffcount) + 1]();
-						memcpy(ndata, data, DFLT_BUFF_GLINE_SIZE * (buffcount - 1) + 1);
-						delete data;
-						data = ndata;
-					}
-					if (tmp == '\n') break;
-				}
-
-				if (!this->clearCharsCanUse)
-				{
-					char* ndata = new char[ccount + 1]();
-
-					for (unsigned int i = 0, j = 0; i < ccount; i++)
-					{
-						const char ch = data[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[j] = ch;
-							j++;
-						}
-					}
+				(void)str;
 
-					delete data;
-					data = ndata;
-				}
+				string data;
+				unsigned int skip_lines = 0;
 
-				str = data;
+				this->scanLine(data, skip_lines, true);
 
 				return *this;
 			}
@@ -443,60 +657,30 @@ namespace FileObj
 	*/
 	FileHandler& FileHandler::operator>>(string& str)
 	{
+		FileHandlerLock lock(*this);
+
 		if (this->file != NULL)
 		{
 			this->last_move = READ_OP;
 
 			if (feof(this->file)) { throw FileHandlerException("Error - FileHandler: Failed to read from file -> End of file was reached!", ra_endoffile_fail); }
 
-			if (this->file_access == openFileModes::read || this->file_access == openFileModes::read_p ||
-				this->file_access == openFileModes::write_p || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_b || this->file_access == openFileModes::read_bp ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_bp)
+			if (this->canReadFile())
 			{
-				char tmp = 0;
-				char* data = new char[DFLT_BUFF_GLINE_SIZE + 1]();
-				unsigned int ccount = 0, buffcount = 1;
+				unsigned int skip_lines = 0;
 
-				while (!feof(this->file))
+				if (!this->clearCharsCanUse)
 				{
-					tmp = fgetc(this->file);
-					if (tmp == EOF || tmp == '\0') break;
-					if (tmp == '\r') continue;
-					data[ccount++] = tmp;
-					if (ccount > DFLT_BUFF_GLINE_SIZE * buffcount)
-					{
-						char* ndata = new char[DFLT_BUFF_GLINE_SIZE * (++buffcount) + 1]();
-						memcpy(ndata, data, DFLT_BUFF_GLINE_SIZE * (buffcount - 1) + 1);
-						delete data;
-						data = ndata;
-					}
-					if (tmp == '\n') break;
+					string data;
+					this->scanLine(data, skip_lines, true);
+					this->filterData(data);
+					str += data;
 				}
-
-				if (!this->clearCharsCanUse)
+				else
 				{
-					char* ndata = new char[ccount + 1]();
-
-					for (unsigned int i = 0, j = 0; i < ccount; i++)
-					{
-						const char ch = data[i];
-
-						if (this->charsCanUse[(unsigned int)ch])
-						{
-							ndata[j] = ch;
-							j++;
-						}
-					}
-
-					delete data;
-					data = ndata;
+					this->scanLine(str, skip_lines, true);
 				}
 
-				str += data;
-				delete data;
-				data = nullptr;
-
 				return *this;
 			}
 
@@ -512,7 +696,10 @@ namespace FileObj
 	*/
 	bool& FileHandler::operator[](const unsigned int index)
 	{
+		FileHandlerLock lock(*this);
+
 		if (index >= MAX_CHAR_CAPACITY) { throw FileHandlerException("Error - FileHandler: The wanted ignoring index is out of range!", ra_outofrange_fail); }
+		this->char_filter_dirty = true; // The table may be changed through the reference
 		return charsCanUse[index];
 	}
 
@@ -528,23 +715,38 @@ namespace FileObj
 		The function opens the wanted file by giving the right data.
 		@ If a file is already opened then it will try to close the stored file, but if it fails
 			it will return false and won't keep on going.
+		@ thread_safe - Every call of the object takes its lock, positional readers (readAt, readAsync) share it
+			and all the other calls take it alone (see getLockStats for how much the threads wait for it).
 	*/
 	bool FileHandler::openFile(const string& f_path, const openFileModes& file_mode, const bool thread_safe, const bufferType& buff_type, size_t buff_size) noexcept
 	{
+		FileHandlerLock lock(*this);
+
 		string open_mode = getFileStreamType(file_mode);
 
 		string fnew_path = f_path;
 		fixPath(fnew_path);
 
+		FileTraceScope trace(this->getTracer(), traceOp::open, &fnew_path);
+
 		if (this->file != NULL) // Closing old file and if can't close it then return false
 		{
 			if (!(this->closeFile())) { return false; }
 		}
 
-		if ((this->file = fopen(fnew_path.c_str(), open_mode.c_str())) != NULL)
+		const bool compressed = file_mode == openFileModes::read_z || file_mode == openFileModes::write_z || file_mode == openFileModes::append_z;
+
+		if ((this->file = compressed ? FileCodec::openStream(fnew_path, open_mode.c_str(), this->codec_settings, this->codec) : fopen(fnew_path.c_str(), open_mode.c_str())) != NULL)
 		{
 			this->file_access = file_mode;
 			this->thread_safe = thread_safe;
+			this->meta_valid = false;
+			this->scan_valid = false;
+			if (this->io_counters == nullptr)
+			{
+				try { this->io_counters = std::make_shared<FileStats>(); }
+				catch (...) {} // The handler works without its own counters
+			}
 
 			if (buff_size > MAX_BUFFER_SIZE)
 			{
@@ -557,38 +759,42 @@ namespace FileObj
 
 			if (this->file_buffer == NULL && buff_type != bufferType::non_buffer) // Buffer allocation check
 			{
-				this->file_buffer = new char[buff_size];
+				this->file_buffer = allocFileBuffer(buff_size);
 				this->file_buffer_size = buff_size * sizeof(char);
 
 				if (this->file_buffer == NULL) // Secondary checking that the allocation/reallocation worked
 				{
 					fclose(this->file);
 					this->file = NULL;
+					this->codec = nullptr;
 					this->file_buffer_size = 0;
 					return false;
 				}
 			}
 			else if (buff_type != bufferType::non_buffer)
 			{
-				delete[] this->file_buffer;
-				this->file_buffer = new char[buff_size];
+				freeFileBuffer(this->file_buffer, this->file_buffer_size);
+				this->file_buffer = allocFileBuffer(buff_size);
 				this->file_buffer_size = buff_size * sizeof(char);
 
 				if (this->file_buffer == NULL) // Secondary checking that the allocation/reallocation worked
 				{
 					fclose(this->file);
 					this->file = NULL;
+					this->codec = nullptr;
 					this->file_buffer_size = 0;
 					return false;
 				}
 			}
 			else if (this->file_buffer != NULL)
 			{
-				delete[] this->file_buffer;
+				freeFileBuffer(this->file_buffer, this->file_buffer_size);
 				this->file_buffer = NULL;
 				this->file_buffer_size = 0;
 			}
 
+			this->buffer_type = buff_type;
+
 			switch (buff_type)
 			{
 			case bufferType::non_buffer: { setvbuf(this->file, this->file_buffer, _IONBF, buff_size);  break; }
@@ -597,6 +803,15 @@ namespace FileObj
 			default: { setvbuf(this->file, this->file_buffer, DEFUALT_BUFFER_NAME, buff_size); }
 			}
 
+			if (file_mode == openFileModes::read_m && !this->mapFile())
+			{
+				fclose(this->file);
+				this->file = NULL;
+				return false;
+			}
+
+			if (file_mode == openFileModes::read_d || file_mode == openFileModes::write_d) { this->openDirect(fnew_path); }
+
 			this->file_path = fnew_path;
 			this->file_name = getFileName(this->file_path);
 			this->extension = getFileExtenstion(this->file_path);
@@ -612,13 +827,12 @@ namespace FileObj
 	*/
 	bool FileHandler::writeToFile(const string& data, const int& pos, const bool& auto_rewind, const bool& flush_file) noexcept
 	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::write_to_file);
+
 		if (this->file != NULL)
 		{
-			if (this->file_access == openFileModes::write || this->file_access == openFileModes::write_p ||
-				this->file_access == openFileModes::append || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_p || this->file_access == openFileModes::write_b ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_b ||
-				this->file_access == openFileModes::append_bp || this->file_access == openFileModes::read_bp)
+			if (this->canWriteFile())
 			{
 				this->last_move = WRITE_OP;
 
@@ -634,30 +848,12 @@ namespace FileObj
 				bool val = true;
 				if (!this->clearCharsCanUse)
 				{
-					unsigned int nsize = data.size();
-					char* ndata = new char[data.size()]();
-
-					for (unsigned int i = 0, j = 0; i < data.size(); i++)
-					{
-						const char ch = data[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[j] = ch;
-							j++;
-						}
-						else
-						{
-							nsize--;
-						}
-					}
-
-					val = fwrite(ndata, sizeof(char), nsize, this->file) == nsize;
-					delete ndata;
-					ndata = nullptr;
+					size_t nsize = this->filterToBuffer(data.c_str(), data.size());
+					val = this->writeData(this->filter_buffer.data(), nsize);
 				}
 				else
 				{
-					val = fwrite(data.c_str(), sizeof(char), data.size(), this->file) == data.size();
+					val = this->writeData(data.c_str(), data.size());
 				}
 
 				if (pos >= 0 && auto_rewind)
@@ -673,80 +869,526 @@ namespace FileObj
 	}
 
 	/*
-		The function is reading data from the file by the given parameters.
+		The function writes the data from the cursor of the file, or queues it when the write-behind mode is on.
 	*/
-	retObj<string> FileHandler::readFromFile(const size_t& count, const int& pos, const bool& auto_rewind, const bool& flush_file) noexcept
+	bool FileHandler::writeData(const char* data, size_t size) noexcept
 	{
-		if (this->file != NULL)
+		FileTraceScope trace(this->getTracer(), traceOp::write, &this->file_path, TRACE_NO_OFFSET, size);
+
+		if (this->behind_enabled)
 		{
-			if (this->file_access == openFileModes::read || this->file_access == openFileModes::read_p ||
-				this->file_access == openFileModes::write_p || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_b || this->file_access == openFileModes::read_bp ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_bp)
-			{
-				this->last_move = READ_OP;
+			string_view piece(data, size);
+			if (!this->queueWriteBehind(&piece, 1, size)) { return false; }
 
-				if (flush_file && this->buffer_type != bufferType::non_buffer) { fflush(this->file); }
+			FileStats::countWrite(this->io_counters.get(), size);
+			return true;
+		}
 
-				if (count <= 0) { return { "", ra_succss }; }
+		if (this->direct_fd >= 0)
+		{
+			if (!this->writeDirectAtCursor(data, size)) { return false; }
 
-				if (pos >= 0)
-				{
-					this->moveCursorInFile(filePosSet::start_file, pos);
-				}
+			FileStats::countWrite(this->io_counters.get(), size);
+			return true;
+		}
 
-				auto rewind_check = [&]()
-				{
-					if (pos >= 0 && auto_rewind)
-					{
-						this->rewindFileOneStep();
-					}
-				};
+		if (fwrite(data, sizeof(char), size, this->file) != size) { return false; }
+		if (this->line_index_enabled) { this->updateLineIndex(data, size); }
+		this->noteWrite();
+		FileStats::countWrite(this->io_counters.get(), size);
 
-				char* temp_str = new char[(unsigned int)count + 1]();
-				bool read_work = fread(temp_str, sizeof(char), count, this->file) == (count);
+		if (this->file_access == openFileModes::write_d)
+		{
+			long write_end = ftell(this->file);
+			this->dropCachedRange(write_end - (long)size, write_end, true);
+		}
 
-				if (!this->clearCharsCanUse)
-				{
-					char* ndata = new char[(unsigned int)count + 1]();
+		return true;
+	}
 
-					for (unsigned int i = 0, j = 0; i < (unsigned int)count + 1; i++)
-					{
-						const char ch = temp_str[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[j] = ch;
-							j++;
-						}
+	/*
+		The function copies the pieces into the write-behind queue, and wakes the flusher.
+		--> If the queue is above the high-water mark, the function waits until the flusher makes place (the queue is never refused if it is empty).
+	*/
+	bool FileHandler::queueWriteBehind(const string_view* pieces, size_t count, size_t total) noexcept
+	{
+		{
+			unique_lock<mutex> lock(this->behind_mutex);
+			this->behind_done_cv.wait(lock, [&]() { return this->behind_pending == 0 || this->behind_pending + total <= this->behind_high_water; });
+
+			try
+			{
+				for (size_t i = 0; i < count; i++) { this->behind_front.insert(this->behind_front.end(), pieces[i].begin(), pieces[i].end()); }
+			}
+			catch (...) { return false; }
+
+			this->behind_pending += total;
+		}
+
+		this->meta_dirty = true;
+		this->scan_valid = false;
+		this->behind_cv.notify_one();
+
+		return true;
+	}
+
+	/*
+		The function waits until all the queued data was written into the file.
+		@ Every function that uses the file, except for queueing writes, calls it first, so the flusher never shares the file with them.
+		@ Returns false if a background write failed since the last time.
+	*/
+	bool FileHandler::syncWriteBehind() noexcept
+	{
+		if (!this->behind_enabled) { return true; }
+
+		unique_lock<mutex> lock(this->behind_mutex);
+		this->behind_done_cv.wait(lock, [this]() { return this->behind_pending == 0 && !this->behind_busy; });
+
+		bool val = !this->behind_failed;
+		this->behind_failed = false;
+
+		return val;
+	}
+
+	/*
+		The function is the loop of the flusher thread, it swaps the queues and writes the full one into the file.
+	*/
+	void FileHandler::writeBehindLoop() noexcept
+	{
+		unique_lock<mutex> lock(this->behind_mutex);
+
+		while (true)
+		{
+			this->behind_cv.wait(lock, [this]() { return this->behind_stop || !this->behind_front.empty(); });
+
+			if (this->behind_front.empty()) { return; }
+
+			std::swap(this->behind_front, this->behind_back);
+			this->behind_busy = true;
+			lock.unlock();
+
+			size_t size = this->behind_back.size();
+			bool val = fwrite(this->behind_back.data(), sizeof(char), size, this->file) == size;
+			if (val && this->line_index_enabled) { this->updateLineIndex(this->behind_back.data(), size); }
+
+			this->behind_back.clear();
+
+			lock.lock();
+			this->behind_busy = false;
+			this->behind_pending -= size;
+			if (!val) { this->behind_failed = true; }
+			this->behind_done_cv.notify_all();
+		}
+	}
+
+	/*
+		Sets the write-behind mode: the writes only copy the data into a queue, and a background thread writes it into the file.
+		@ high_water_mark - The amount of pending bytes above which the writers wait, so the memory stays bounded.
+		@ flushFile waits for the queue to be written, and closing the file or turning the mode off writes it all first.
+		--> Write errors are reported by the next flushFile (or by turning the mode off).
+	*/
+	bool FileHandler::setWriteBehind(const bool& enable, size_t high_water_mark) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (!enable)
+		{
+			if (!this->behind_enabled) { return true; }
+
+			bool val = this->syncWriteBehind();
+
+			{
+				unique_lock<mutex> lock(this->behind_mutex);
+				this->behind_stop = true;
+			}
+
+			this->behind_cv.notify_all();
+			if (this->behind_thread.joinable()) { this->behind_thread.join(); }
+
+			this->behind_enabled = false;
+			this->behind_stop = false;
+			this->behind_front = vector<char>();
+			this->behind_back = vector<char>();
+
+			return val;
+		}
+
+		if (this->file == NULL || !this->canWriteFile() || this->file_access == openFileModes::write_d) { return false; } // The queue would go through the cache
+
+		this->behind_high_water = (high_water_mark > 0) ? high_water_mark : DFLT_WRITE_BEHIND_MARK;
+		if (this->behind_enabled) { return true; }
+
+		try { this->behind_thread = thread(&FileHandler::writeBehindLoop, this); }
+		catch (...) { return false; }
+
+		this->behind_enabled = true;
+
+		return true;
+	}
+
+	/*
+		The function checks if the write-behind mode is on.
+	*/
+	bool FileHandler::isWriteBehind() const noexcept { return this->behind_enabled; }
+
+	/*
+		The function writes the pieces one after the other from the cursor of the file.
+		@ Small pieces in a fully buffered file go into the buffer of the file, else the buffer is flushed and
+			all the pieces are written together with writev, so many pieces cost one system call.
+	*/
+	bool FileHandler::writePieces(const string_view* pieces, size_t count, size_t total) noexcept
+	{
+		FileTraceScope trace(this->getTracer(), traceOp::write, &this->file_path, TRACE_NO_OFFSET, total);
+
+		if (this->behind_enabled)
+		{
+			if (!this->queueWriteBehind(pieces, count, total)) { return false; }
+
+			FileStats::countWrite(this->io_counters.get(), total);
+			return true;
+		}
+
+		if (this->direct_fd >= 0)
+		{
+			if (count == 1)
+			{
+				if (!this->writeDirectAtCursor(pieces[0].data(), pieces[0].size())) { return false; }
+
+				FileStats::countWrite(this->io_counters.get(), total);
+				return true;
+			}
+
+			vector<char> joined; // One write keeps the unaligned ends of the pieces from being read and written again
+
+			try
+			{
+				joined.reserve(total);
+				for (size_t i = 0; i < count; i++) { joined.insert(joined.end(), pieces[i].begin(), pieces[i].end()); }
+			}
+			catch (...) { return false; }
+
+			if (!this->writeDirectAtCursor(joined.data(), joined.size())) { return false; }
+
+			FileStats::countWrite(this->io_counters.get(), total);
+			return true;
+		}
+
+		bool direct = false;
+
+#if defined(FH_POSIX_IO)
+		direct = this->codec == nullptr && (this->buffer_type != bufferType::full_buffer || total >= this->file_buffer_size);
+#endif
+
+		if (!direct)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (fwrite(pieces[i].data(), sizeof(char), pieces[i].size(), this->file) != pieces[i].size()) { return false; }
+			}
+		}
+#if defined(FH_POSIX_IO)
+		else
+		{
+			if (this->flushStream()) { return false; }
+
+			const int fd = fileno(this->file);
+			size_t piece = 0, piece_offset = 0;
+
+			while (piece < count)
+			{
+				struct iovec iov[WRITE_BATCH_IOV_MAX];
+				int iov_count = 0;
+
+				for (size_t i = piece; i < count && iov_count < WRITE_BATCH_IOV_MAX; i++)
+				{
+					size_t skip = (i == piece) ? piece_offset : 0;
+					if (pieces[i].size() <= skip) { continue; }
+
+					iov[iov_count].iov_base = (void*)(pieces[i].data() + skip);
+					iov[iov_count].iov_len = pieces[i].size() - skip;
+					iov_count++;
+				}
+
+				if (iov_count == 0) { break; }
+
+				ssize_t written = writev(fd, iov, iov_count);
+				FileStats::countSyscall(this->io_counters.get());
+
+				if (written < 0)
+				{
+					if (errno == EINTR) { continue; }
+					return false;
+				}
+
+				size_t left = (size_t)written;
+
+				while (piece < count) // Moves over the written data, writev may write only a part of it
+				{
+					size_t piece_left = pieces[piece].size() - piece_offset;
+
+					if (left < piece_left) { piece_offset += left; break; }
+
+					left -= piece_left;
+					piece++;
+					piece_offset = 0;
+				}
+			}
+
+			off_t write_end = lseek(fd, 0, SEEK_CUR); // The stream keeps its own position, so it is set again after writing around it
+			FileStats::countSyscall(this->io_counters.get());
+			if (write_end < 0 || this->seekFile((long)write_end, SEEK_SET)) { return false; }
+		}
+#endif
+
+		if (this->line_index_enabled)
+		{
+			long write_start = ftell(this->file) - (long)total;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				this->updateLineIndex(pieces[i].data(), pieces[i].size(), write_start);
+				write_start += (long)pieces[i].size();
+			}
+		}
+
+		this->noteWrite();
+		FileStats::countWrite(this->io_counters.get(), total);
+
+		if (this->file_access == openFileModes::write_d)
+		{
+			long write_end = ftell(this->file);
+			this->dropCachedRange(write_end - (long)total, write_end, true);
+		}
+
+		return true;
+	}
+
+	/*
+		The function is writing many pieces of data into the file together, by the given parameters.
+		@ Instead of a write for every piece, the pieces are written with one writev (or into the buffer of the file if they fit there).
+		--> If ignoring is set, the pieces are filtered back to back into one buffer first.
+	*/
+	bool FileHandler::writeBatch(const string_view* pieces, size_t count, const int& pos, const bool& auto_rewind, const bool& flush_file) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::write_batch);
+
+		if (this->file != NULL)
+		{
+			if (this->canWriteFile())
+			{
+				this->last_move = WRITE_OP;
+
+				if (flush_file) { this->flushFile(); }
+
+				size_t total = 0;
+				for (size_t i = 0; i < count; i++) { total += pieces[i].size(); }
+
+				if (total <= 0) { return true; }
+
+				if (pos >= 0)
+				{
+					this->moveCursorInFile(filePosSet::start_file, pos);
+				}
+
+				bool val = true;
+
+				if (!this->clearCharsCanUse)
+				{
+					if (this->filter_buffer.size() < total) { this->filter_buffer.resize(total); }
+
+					const char_filter& filter = this->getCharFilter();
+					size_t nsize = 0;
+
+					for (size_t i = 0; i < count; i++)
+					{
+						nsize += FileScanner::filterBytes(this->filter_buffer.data() + nsize, pieces[i].data(), pieces[i].size(), filter);
 					}
 
-					delete temp_str;
-					temp_str = ndata;
+					FileStats::countFiltered(this->io_counters.get(), total - nsize);
+					string_view filtered(this->filter_buffer.data(), nsize);
+					val = this->writePieces(&filtered, 1, nsize);
+				}
+				else
+				{
+					val = this->writePieces(pieces, count, total);
+				}
+
+				if (pos >= 0 && auto_rewind)
+				{
+					this->rewindFileOneStep();
+				}
+
+				return val;
+			}
+		}
+
+		return false;
+	}
+
+	/*
+		The function reads up to count bytes from the file straight into the given buffer, without any allocation.
+		@ Returns the amount of bytes put in the buffer and if the end of the file was reached, so binary data is kept as is.
+		@ A read from a given position that is rewound is done with readAt's positional read, so the cursor isn't moved twice.
+		--> If ignoring is set, the buffer is filtered in place and the returned amount is after the filtering.
+	*/
+	retObj<read_result> FileHandler::readInto(char* buffer, const size_t& count, const long& pos, const bool& auto_rewind, const bool& flush_file) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::read_into);
+		FileTraceScope trace(this->getTracer(), traceOp::read, &this->file_path, pos, count);
+
+		if (this->file != NULL)
+		{
+			if (this->canReadFile())
+			{
+				const bool after_write = this->last_move == WRITE_OP;
+				this->last_move = READ_OP;
+
+				if ((flush_file || (after_write && pos >= 0 && auto_rewind)) && this->buffer_type != bufferType::non_buffer) { this->flushStream(); }
+
+				this->syncWriteBehind();
+
+				if (count <= 0 || buffer == nullptr) { return { { 0, (bool)feof(this->file) }, ra_succss }; }
+
+				size_t read_count = 0;
+				bool read_fail = false, end_of_file = false;
+
+				if (pos >= 0 && auto_rewind && this->codec == nullptr) // The cursor would be put back anyway, so it isn't moved at all
+				{
+					long pread_count = this->preadFile(buffer, count, pos);
+
+					read_fail = pread_count < 0;
+					read_count = read_fail ? 0 : (size_t)pread_count;
+					end_of_file = !read_fail && read_count < count;
+
+					this->dropCachedRange(pos, pos + (long)read_count, false);
+				}
+				else if (this->direct_fd >= 0)
+				{
+					if (pos >= 0) { this->moveCursorInFile(filePosSet::start_file, pos); }
+
+					const long read_start = ftell(this->file);
+					long direct_count = read_start < 0 ? -1 : this->directRead(buffer, count, read_start);
+
+					read_fail = direct_count < 0 || this->seekFile(read_start + direct_count, SEEK_SET);
+					read_count = direct_count < 0 ? 0 : (size_t)direct_count;
+					FileStats::countRead(this->io_counters.get(), read_count);
+					end_of_file = !read_fail && read_count < count;
+				}
+				else
+				{
+					if (pos >= 0) { this->moveCursorInFile(filePosSet::start_file, pos); }
+
+					const long read_start = (this->adaptive_buffer || this->file_access == openFileModes::read_d) ? ftell(this->file) : NON_WORK;
+
+					read_count = fread(buffer, sizeof(char), count, this->file);
+					read_fail = read_count < count && ferror(this->file);
+					FileStats::countRead(this->io_counters.get(), read_count);
+					end_of_file = read_count < count && feof(this->file);
+
+					if (read_fail) { clearerr(this->file); }
+
+					this->trackAccess(read_start, read_start + (long)read_count);
+					this->dropCachedRange(read_start, read_start + (long)read_count, false);
+
+					if (pos >= 0 && auto_rewind) { this->rewindFileOneStep(); } // A compressed file can't be read by position
+				}
+
+				if (read_fail) { return { { read_count, end_of_file }, ra_readfile_fail }; }
+
+				if (!this->clearCharsCanUse)
+				{
+					size_t raw_count = read_count;
+					read_count = FileScanner::filterBytes(buffer, buffer, read_count, this->getCharFilter());
+					FileStats::countFiltered(this->io_counters.get(), raw_count - read_count);
 				}
 
-				string str = temp_str;
-				delete temp_str;
-				temp_str = nullptr;
+				trace.setSize(read_count);
+				return { { read_count, end_of_file }, ra_succss };
+			}
+
+			return { { 0, false }, ra_fileaccesstype_fail };
+		}
+
+		return { { 0, false }, ra_fileisclosed_fail };
+	}
+
+	/*
+		The function is reading data from the file by the given parameters.
+		@ If the end of the file was reached, an EOF char is added at the end of the returned data.
+		--> readInto reads into a given buffer without the allocation and without the EOF char.
+	*/
+	retObj<string> FileHandler::readFromFile(const size_t& count, const int& pos, const bool& auto_rewind, const bool& flush_file) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::read_from_file);
+
+		if (this->file != NULL)
+		{
+			if (this->canReadFile())
+			{
+				if (count <= 0) { this->last_move = READ_OP; return { "", ra_succss }; }
+
+				string str(count, '\0');
+				retObj<read_result> read = this->readInto(str.data(), count, pos, auto_rewind, flush_file);
+
+				if (read.statusObj != ra_succss) { return { "", read.statusObj }; }
+
+				str.resize(read.obj.count);
+				if (read.obj.end_of_file) { str += (char)EOF; }
+
+				return { str, ra_succss };
+			}
+		}
+
+		return { "", ra_fileisclosed_fail };
+	}
+
+	/*
+		The function gets a line out of a file.
+		@ This file returns error if during the getting line, the file met \0 of EOF operators and the wanted line wasn't reached yet.
+		--> buff_size is kept for old code, the line's buffer grows by itself.
+	*/
+	retObj<string> FileHandler::getLine(unsigned int numline, const int& pos, [[maybe_unused]] unsigned int buff_size, [[maybe_unused]] const bool& auto_rewind, const bool& flush_file) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::get_line);
+		FileTraceScope trace(this->getTracer(), traceOp::read, &this->file_path, pos);
+
+		if (this->file != NULL)
+		{
+			if (this->canReadFile())
+			{
+				this->last_move = READ_OP;
 
-				char tmpv[2] = { EOF, 0 };
+				if (flush_file && this->buffer_type != bufferType::non_buffer) { this->flushStream(); }
 
-				if (!read_work && feof(this->file))
+				if (pos >= 0)
 				{
-					rewind_check();
-					return { string(tmpv), ra_succss };
+					this->moveCursorInFile(filePosSet::start_file, pos);
 				}
-				else if (!read_work)
+				else if (this->line_index_enabled)
 				{
-					rewind_check();
-					return { "", ra_readfile_fail };
+					this->moveCursorInFile(filePosSet::start_file, this->seekLineIndex(numline));
 				}
-				else if (feof(this->file))
+				else
 				{
-					rewind_check();
-					return { str.append(tmpv), ra_succss };
+					this->moveCursorInFile(filePosSet::start_file);
 				}
 
-				rewind_check();
+				if (feof(this->file)) { return { "", ra_succss }; }
+
+				string str;
+				int stop_char = this->scanLine(str, numline, false);
+
+				this->rewindFileOneStep();
+
+				if ((stop_char == EOF || stop_char == '\0') && numline > 0)  return { "", ra_endoffile_fail };
+
+				if (!this->clearCharsCanUse) { this->filterData(str); }
+
+				trace.setSize(str.size());
 				return { str, ra_succss };
 			}
 		}
@@ -755,376 +1397,2883 @@ namespace FileObj
 	}
 
 	/*
-		The function gets a line out of a file.
-		@ This file returns error if during the getting line, the file met \0 of EOF operators and the wanted line wasn't reached yet.
+		The function reads from the cursor of the file, skips skip_lines lines and then appends the line after them into line_data.
+		@ The data is read in growing blocks and the line's parts are appended at once, '\r' is removed from the line.
+		@ Returns the char that stopped the line ('\n' or '\0') or EOF, and the cursor is left right after it.
+		--> skip_lines is lowered by the amount of lines skipped, so above 0 means the line wasn't reached.
+	*/
+	int FileHandler::scanLine(string& line_data, unsigned int& skip_lines, const bool& keep_new_line) noexcept
+	{
+		size_t chunk_size = DFLT_LINE_SCAN_CHUNK;
+
+		this->syncWriteBehind();
+
+		const long scan_start = this->adaptive_buffer ? ftell(this->file) : NON_WORK; // The line reads feed the adaptive buffer too
+		long scan_end = scan_start;
+
+		while (true)
+		{
+			if (this->line_chunk.size() < chunk_size) { this->line_chunk.resize(chunk_size); }
+
+			const char* data = this->line_chunk.data();
+			size_t read_count = fread(this->line_chunk.data(), sizeof(char), chunk_size, this->file);
+			size_t curr = 0;
+
+			while (curr < read_count)
+			{
+				size_t stop = curr + FileScanner::findLineStop(data + curr, read_count - curr);
+
+				if (skip_lines == 0) { line_data.append(data + curr, stop - curr); }
+				if (stop == read_count) { break; }
+
+				const char ch = data[stop];
+				curr = stop + 1;
+
+				if (ch == '\r') { continue; }
+				if (ch == '\n' && skip_lines > 0) { skip_lines--; continue; }
+				if (ch == '\n' && keep_new_line) { line_data += '\n'; }
+
+				if (curr < read_count) { this->seekFile(-(long)(read_count - curr), SEEK_CUR); }
+				FileStats::countRead(this->io_counters.get(), curr);
+				this->trackAccess(scan_start, scan_end + (long)curr);
+
+				return ch;
+			}
+
+			FileStats::countRead(this->io_counters.get(), read_count);
+			scan_end += (long)read_count;
+			if (read_count < chunk_size) { this->trackAccess(scan_start, scan_end); return EOF; }
+			if (chunk_size < LINE_INDEX_READ_CHUNK) { chunk_size *= 2; }
+		}
+	}
+
+	/*
+		The function removes from the data all the chars that the ignoring table doesn't allow.
+	*/
+	void FileHandler::filterData(string& data) noexcept
+	{
+		size_t data_size = data.size();
+		data.resize(FileScanner::filterBytes(data.data(), data.data(), data.size(), this->getCharFilter()));
+		FileStats::countFiltered(this->io_counters.get(), data_size - data.size());
+	}
+
+	/*
+		The function copies the chars of the data that the ignoring table allows into filter_buffer, and returns their amount.
+		--> filter_buffer is kept between the calls, so it is allocated only when it needs to grow.
+	*/
+	size_t FileHandler::filterToBuffer(const char* data, size_t size) noexcept
+	{
+		if (this->filter_buffer.size() < size) { this->filter_buffer.resize(size); }
+
+		size_t new_size = FileScanner::filterBytes(this->filter_buffer.data(), data, size, this->getCharFilter());
+		FileStats::countFiltered(this->io_counters.get(), size - new_size);
+
+		return new_size;
+	}
+
+	/*
+		The function returns the compiled ignoring table, and compiles it again if the table was changed.
+	*/
+	const char_filter& FileHandler::getCharFilter() noexcept
+	{
+		if (this->char_filter_dirty)
+		{
+			FileScanner::compileFilter(this->char_filter_data, this->charsCanUse);
+			this->char_filter_dirty = false;
+		}
+
+		return this->char_filter_data;
+	}
+
+	/*
+		The function moves the cursor of the stream, and counts the seek.
+	*/
+	int FileHandler::seekFile(long offset, int origin) noexcept
+	{
+		FileTraceScope trace(this->getTracer(), traceOp::seek, &this->file_path, origin == SEEK_SET ? offset : TRACE_NO_OFFSET);
+		FileStats::countSeek(this->io_counters.get());
+		return fseek(this->file, offset, origin);
+	}
+
+	/*
+		The function returns the descriptor of the file, in the compressed modes it is the one of the compressed file.
+	*/
+	int FileHandler::getFileFd() const noexcept
+	{
+#if defined(FH_POSIX_IO)
+		return this->codec != nullptr ? this->codec->getFd() : fileno(this->file);
+#else
+		return -1;
+#endif
+	}
+
+	/*
+		The function flushes the buffer of the stream into the file, and counts the flush.
+	*/
+	int FileHandler::flushStream() noexcept
+	{
+		FileTraceScope trace(this->getTracer(), traceOp::flush, &this->file_path);
+		FileStats::countFlush(this->io_counters.get());
+		return fflush(this->file);
+	}
+
+	/*
+		The function reads count bytes from the given offset of the file, without using or moving the cursor of the file.
+		@ Returns the amount of bytes read or -1 on faliure.
+		--> Data that is still in the buffer of the file isn't seen, so the file should be flushed before.
+	*/
+	long FileHandler::preadFile(char* buffer, size_t count, long offset) noexcept
+	{
+		if (this->file == NULL || this->codec != nullptr || buffer == nullptr || offset < 0) { return -1; }
+
+		if (this->direct_fd >= 0)
+		{
+			long direct_count = this->directRead(buffer, count, offset);
+			if (direct_count > 0) { FileStats::countRead(this->io_counters.get(), (size_t)direct_count); }
+
+			return direct_count;
+		}
+
+#if defined(FH_POSIX_IO)
+		size_t total = 0;
+
+		while (total < count)
+		{
+			ssize_t read_count = pread(fileno(this->file), buffer + total, count - total, (off_t)(offset + total));
+			FileStats::countSyscall(this->io_counters.get());
+			if (read_count < 0) { return -1; }
+			if (read_count == 0) { break; }
+			total += (size_t)read_count;
+		}
+
+		FileStats::countRead(this->io_counters.get(), total);
+
+		return (long)total;
+#else
+		lock_guard<mutex> lock(this->file_mutex);
+
+		long curr_pos = ftell(this->file);
+		if (this->seekFile(offset, SEEK_SET)) { return -1; }
+
+		size_t read_count = fread(buffer, sizeof(char), count, this->file);
+		clearerr(this->file);
+		this->seekFile(curr_pos, SEEK_SET);
+		FileStats::countRead(this->io_counters.get(), read_count);
+
+		return (long)read_count;
+#endif
+	}
+
+	/*
+		The function writes count bytes at the given offset of the file, without using or moving the cursor of the file.
+		@ Returns the amount of bytes written or -1 on faliure.
+		--> In an append file the system puts the data at the end of the file, whatever the offset is.
+	*/
+	long FileHandler::pwriteFile(const char* data, size_t count, long offset) noexcept
+	{
+		if (this->file == NULL || this->codec != nullptr || data == nullptr || offset < 0) { return -1; }
+		if (this->direct_fd >= 0) { return this->directWrite(data, count, offset); }
+
+#if defined(FH_POSIX_IO)
+		size_t total = 0;
+
+		while (total < count)
+		{
+			ssize_t write_count = pwrite(fileno(this->file), data + total, count - total, (off_t)(offset + total));
+			FileStats::countSyscall(this->io_counters.get());
+
+			if (write_count < 0)
+			{
+				if (errno == EINTR) { continue; }
+				return -1;
+			}
+
+			total += (size_t)write_count;
+		}
+
+		return (long)total;
+#else
+		lock_guard<mutex> lock(this->file_mutex);
+
+		long curr_pos = ftell(this->file);
+		if (this->flushStream() || this->seekFile(offset, SEEK_SET)) { return -1; }
+
+		size_t write_count = fwrite(data, sizeof(char), count, this->file);
+		this->flushStream();
+		this->seekFile(curr_pos, SEEK_SET);
+
+		return (long)write_count;
+#endif
+	}
+
+	/*
+		The function opens the O_DIRECT descriptor of a direct mode, and finds the alignment its reads and writes need.
+		@ If the file system can't go around the page cache, the file is used through the cache and the used data is dropped from it.
+	*/
+	void FileHandler::openDirect(const string& path) noexcept
+	{
+		this->direct_fd = NON_WORK;
+		this->direct_align = DIRECT_IO_ALIGN;
+		this->drop_start = this->drop_end = 0;
+
+#if defined(FH_POSIX_IO) && defined(O_DIRECT)
+		int fd = open(path.c_str(), (this->file_access == openFileModes::write_d ? O_RDWR : O_RDONLY) | O_DIRECT | O_CLOEXEC);
+
+#if defined(STATX_DIOALIGN)
+		struct statx dio_stat;
+
+		if (fd >= 0 && !statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &dio_stat) && (dio_stat.stx_mask & STATX_DIOALIGN))
+		{
+			const size_t align = std::max(dio_stat.stx_dio_offset_align, dio_stat.stx_dio_mem_align);
+
+			if (align == 0 || dio_stat.stx_dio_mem_align > BUFFER_POOL_ALIGN || align > DIRECT_IO_CHUNK_SIZE) { close(fd); fd = NON_WORK; }
+			else { this->direct_align = std::max(align, (size_t)512); }
+		}
+#endif
+
+		if (fd >= 0) { this->direct_fd = fd; return; }
+#endif
+
+#if defined(F_NOCACHE)
+		fcntl(fileno(this->file), F_NOCACHE, 1);
+#endif
+		this->setAccessHint(accessHint::once);
+	}
+
+	/*
+		The function closes the O_DIRECT descriptor, or drops the last written range from the cache if there is none.
+	*/
+	void FileHandler::closeDirect() noexcept
+	{
+#if defined(FH_POSIX_IO)
+		if (this->direct_fd >= 0) { close(this->direct_fd); }
+		else if (this->file != NULL && this->drop_end > this->drop_start && !this->flushStream() && !fdatasync(fileno(this->file)))
+		{
+			posix_fadvise(fileno(this->file), (off_t)this->drop_start, (off_t)(this->drop_end - this->drop_start), POSIX_FADV_DONTNEED);
+		}
+#endif
+
+		this->direct_fd = NON_WORK;
+		this->drop_start = this->drop_end = 0;
+	}
+
+	/*
+		The function reads up to count bytes from the given offset through the O_DIRECT descriptor.
+		@ The aligned middle goes straight into the buffer if the buffer is aligned too, the rest goes through an aligned buffer of the pool.
+		@ Returns the amount of bytes read or -1 on faliure.
+	*/
+	long FileHandler::directRead(char* buffer, size_t count, long offset) noexcept
+	{
+#if defined(FH_POSIX_IO)
+		const size_t align = this->direct_align;
+		char* bounce = nullptr;
+		size_t done = 0;
+		bool ended = false, failed = false;
+
+		while (done < count && !ended)
+		{
+			const long curr = offset + (long)done;
+			const size_t left = count - done;
+			ssize_t read_count = 0;
+
+			if (curr % (long)align == 0 && (uintptr_t)(buffer + done) % align == 0 && left >= align)
+			{
+				size_t size = std::min(left, (size_t)MAX_ASYNC_REQUEST_SIZE);
+				size -= size % align;
+
+				FileStats::countSyscall(this->io_counters.get());
+				if ((read_count = pread(this->direct_fd, buffer + done, size, (off_t)curr)) < 0)
+				{
+					if (errno == EINTR) { continue; }
+					failed = true; break;
+				}
+
+				done += (size_t)read_count;
+				ended = (size_t)read_count < size;
+				continue;
+			}
+
+			if (bounce == nullptr && (bounce = allocFileBuffer(DIRECT_IO_CHUNK_SIZE)) == nullptr) { failed = true; break; }
+
+			const long start = curr - curr % (long)align;
+			const size_t skip = (size_t)(curr - start);
+			const size_t size = std::min((size_t)DIRECT_IO_CHUNK_SIZE, (skip + left + align - 1) / align * align);
+
+			FileStats::countSyscall(this->io_counters.get());
+			if ((read_count = pread(this->direct_fd, bounce, size, (off_t)start)) < 0)
+			{
+				if (errno == EINTR) { continue; }
+				failed = true; break;
+			}
+
+			ended = (size_t)read_count < size;
+			if ((size_t)read_count <= skip) { break; }
+
+			const size_t piece = std::min((size_t)read_count - skip, left);
+			memcpy(buffer + done, bounce + skip, piece);
+			done += piece;
+		}
+
+		freeFileBuffer(bounce, DIRECT_IO_CHUNK_SIZE);
+
+		return failed ? -1 : (long)done;
+#else
+		(void)buffer; (void)count; (void)offset;
+		return -1;
+#endif
+	}
+
+	/*
+		The function writes count bytes at the given offset through the O_DIRECT descriptor.
+		@ The aligned middle is written straight from the data if the data is aligned too. A block that is written only
+			in part is read first so its other bytes are kept, and the file is cut back if the last block went past its end.
+		@ Returns the amount of bytes written or -1 on faliure.
+	*/
+	long FileHandler::directWrite(const char* data, size_t count, long offset) noexcept
+	{
+#if defined(FH_POSIX_IO)
+		lock_guard<mutex> lock(this->file_mutex); // Writes that share a block would undo each other
+
+		const size_t align = this->direct_align;
+		char* bounce = nullptr;
+		size_t done = 0;
+		long file_size = NON_WORK; // Checked only when a block is written in part
+		bool padded = false, failed = false;
+
+		auto readBlock = [&](char* block, long block_start) -> bool // Reads one block, the part after the end of the file is zeroed
+		{
+			ssize_t read_count = 0;
+
+			if (block_start < file_size)
+			{
+				FileStats::countSyscall(this->io_counters.get());
+				while ((read_count = pread(this->direct_fd, block, align, (off_t)block_start)) < 0)
+				{
+					if (errno != EINTR) { return false; }
+				}
+			}
+
+			memset(block + read_count, 0, align - (size_t)read_count);
+			return true;
+		};
+
+		while (done < count && !failed)
+		{
+			const long curr = offset + (long)done;
+			const size_t left = count - done;
+
+			if (curr % (long)align == 0 && (uintptr_t)(data + done) % align == 0 && left >= align)
+			{
+				size_t size = std::min(left, (size_t)MAX_ASYNC_REQUEST_SIZE);
+				size -= size % align;
+
+				ssize_t write_count = pwrite(this->direct_fd, data + done, size, (off_t)curr);
+				FileStats::countSyscall(this->io_counters.get());
+
+				if (write_count <= 0)
+				{
+					if (write_count < 0 && errno == EINTR) { continue; }
+					failed = true; break;
+				}
+
+				done += (size_t)write_count;
+				continue;
+			}
+
+			if (bounce == nullptr && (bounce = allocFileBuffer(DIRECT_IO_CHUNK_SIZE)) == nullptr) { failed = true; break; }
+
+			const long start = curr - curr % (long)align;
+			const size_t skip = (size_t)(curr - start);
+			const size_t size = std::min((size_t)DIRECT_IO_CHUNK_SIZE, (skip + left + align - 1) / align * align);
+			const size_t piece = std::min(size - skip, left);
+			const long last = start + (long)(size - align);
+
+			if (skip > 0 || skip + piece < size)
+			{
+				if (file_size < 0)
+				{
+					struct stat file_stat;
+					if (fstat(this->direct_fd, &file_stat)) { failed = true; break; }
+					file_size = (long)file_stat.st_size;
+				}
+
+				if (skip > 0 && !readBlock(bounce, start)) { failed = true; break; }
+				if (skip + piece < size && (last != start || skip == 0) && !readBlock(bounce + (size - align), last)) { failed = true; break; }
+
+				padded = padded || start + (long)size > file_size;
+			}
+
+			memcpy(bounce + skip, data + done, piece);
+
+			for (size_t written = 0; written < size;)
+			{
+				ssize_t write_count = pwrite(this->direct_fd, bounce + written, size - written, (off_t)(start + (long)written));
+				FileStats::countSyscall(this->io_counters.get());
+
+				if (write_count <= 0)
+				{
+					if (write_count < 0 && errno == EINTR) { continue; }
+					failed = true; break;
+				}
+
+				written += (size_t)write_count;
+			}
+
+			if (!failed) { done += piece; }
+		}
+
+		if (!failed && padded && ftruncate(this->direct_fd, (off_t)std::max(file_size, offset + (long)count))) { failed = true; }
+
+		freeFileBuffer(bounce, DIRECT_IO_CHUNK_SIZE);
+
+		return failed ? -1 : (long)done;
+#else
+		(void)data; (void)count; (void)offset;
+		return -1;
+#endif
+	}
+
+	/*
+		The function writes the data at the cursor of the file through the O_DIRECT descriptor, and moves the cursor after it.
+	*/
+	bool FileHandler::writeDirectAtCursor(const char* data, size_t size) noexcept
+	{
+		if (this->flushStream()) { return false; }
+
+		const long write_start = ftell(this->file);
+		if (write_start < 0 || this->directWrite(data, size, write_start) != (long)size) { return false; }
+		if (this->seekFile(write_start + (long)size, SEEK_SET)) { return false; }
+
+		if (this->line_index_enabled) { this->updateLineIndex(data, size, write_start); }
+		this->noteWrite(write_start + (long)size);
+
+		return true;
+	}
+
+	/*
+		The function drops a used range of a direct mode file from the page cache, when the file system can't go around it.
+		@ A written range is sent to the disk in the background and dropped after the next write, so the writer doesn't wait for it.
+	*/
+	void FileHandler::dropCachedRange(long start, long end, const bool& written) noexcept
+	{
+#if defined(FH_POSIX_IO)
+		if (this->direct_fd >= 0 || start < 0 || end <= start) { return; }
+		if (this->file_access != openFileModes::read_d && this->file_access != openFileModes::write_d) { return; }
+
+		const int fd = fileno(this->file);
+
+		if (!written) { posix_fadvise(fd, (off_t)start, (off_t)(end - start), POSIX_FADV_DONTNEED); return; }
+
+		if (this->flushStream()) { return; }
+
+#if defined(__linux__)
+		sync_file_range(fd, (off_t)start, (off_t)(end - start), SYNC_FILE_RANGE_WRITE);
+
+		if (this->drop_end > this->drop_start)
+		{
+			sync_file_range(fd, (off_t)this->drop_start, (off_t)(this->drop_end - this->drop_start),
+				SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+			posix_fadvise(fd, (off_t)this->drop_start, (off_t)(this->drop_end - this->drop_start), POSIX_FADV_DONTNEED);
+		}
+
+		this->drop_start = start;
+		this->drop_end = end;
+#else
+		if (!fdatasync(fd)) { posix_fadvise(fd, (off_t)start, (off_t)(end - start), POSIX_FADV_DONTNEED); }
+#endif
+#else
+		(void)start; (void)end; (void)written;
+#endif
+	}
+
+	/*
+		The function gets the file ready for the requests that use its descriptor, they go around the buffer of the file.
+		@ Waits for the write-behind queue and flushes the data that is still in the buffer of the file.
+		@ Before a write, data that the buffer of the file read ahead is dropped, since the write may change it.
+	*/
+	returnAns FileHandler::prepareFdAccess(const bool& for_write) noexcept
+	{
+		if (this->file == NULL) { return ra_fileisclosed_fail; }
+		if (this->codec != nullptr || (for_write ? !this->canWriteFile() : !this->canReadFile())) { return ra_fileaccesstype_fail; } // A compressed file has no plain data to read by position
+
+		this->syncWriteBehind();
+
+		if (this->last_move == WRITE_OP && this->buffer_type != bufferType::non_buffer && this->flushStream()) { return ra_writefile_fail; }
+
+		// The data that the stream read ahead may be written over, a flush drops it (a seek isn't enough, glibc keeps the buffer
+		// on a seek inside it and reads it again on other seeks), so the next read of the stream gets the written data
+		if (for_write && this->last_move == READ_OP && this->buffer_type != bufferType::non_buffer && this->flushStream()) { return ra_writefile_fail; }
+
+		return ra_succss;
+	}
+
+	/*
+		The function reads up to count bytes from the given offset of the file into the buffer.
+		@ The cursor of the file isn't used or moved, so many threads can read from the same object at once
+			without the thread safe mode and without rewinding.
+		@ Returns the amount of bytes put in the buffer, end_of_file is set if the read ended before count bytes.
+		--> Ignoring isn't applied, the bytes are returned as they are in the file!
+	*/
+	retObj<read_result> FileHandler::readAt(const long& offset, char* buffer, const size_t& count) noexcept
+	{
+		FileHandlerLock lock(*this, false);
+		FileStatsTimer timer(this->io_counters.get(), statCall::read_at);
+		FileTraceScope trace(this->getTracer(), traceOp::read, &this->file_path, offset, count);
+
+		returnAns status = this->prepareFdAccess(false);
+		if (status != ra_succss) { return { { 0, false }, status }; }
+
+		if (offset < 0 || (buffer == nullptr && count > 0)) { return { { 0, false }, ra_outofrange_fail }; }
+		if (count == 0) { return { { 0, false }, ra_succss }; }
+
+		long read_count = this->preadFile(buffer, count, offset);
+		if (read_count < 0) { return { { 0, false }, ra_readfile_fail }; }
+		trace.setSize((size_t)read_count);
+
+		return { { (size_t)read_count, (size_t)read_count < count }, ra_succss };
+	}
+
+	/*
+		The function writes count bytes at the given offset of the file.
+		@ The cursor of the file isn't used or moved, so many threads can write to the same object at once.
+		@ The line index is kept up to date (In an append file it is dropped, since the data goes to the end of the file).
+		--> Ignoring isn't applied, the bytes are written as they are!
+	*/
+	retObj<size_t> FileHandler::writeAt(const long& offset, const char* data, const size_t& count) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::write_at);
+		FileTraceScope trace(this->getTracer(), traceOp::write, &this->file_path, offset, count);
+
+		returnAns status = this->prepareFdAccess(true);
+		if (status != ra_succss) { return { 0, status }; }
+
+		if (offset < 0 || (data == nullptr && count > 0)) { return { 0, ra_outofrange_fail }; }
+		if (count == 0) { return { 0, ra_succss }; }
+
+		long write_count = this->pwriteFile(data, count, offset);
+		if (write_count < 0) { return { 0, ra_writefile_fail }; }
+		FileStats::countWrite(this->io_counters.get(), (size_t)write_count);
+
+		const bool append = this->file_access == openFileModes::append || this->file_access == openFileModes::append_p ||
+			this->file_access == openFileModes::append_b || this->file_access == openFileModes::append_bp;
+
+		{
+			lock_guard<mutex> lock(this->file_mutex); // Writers on other threads update the same index and metadata
+
+			if (this->line_index_enabled)
+			{
+				if (append) { this->line_index_enabled = false; this->resetLineIndex(); }
+				else { this->updateLineIndex(data, (size_t)write_count, offset); }
+			}
+
+			if (append) { this->meta_dirty = true; this->scan_valid = false; } // The system put the data at the end of the file
+			else { this->noteWrite(offset + write_count); }
+		}
+
+		return { (size_t)write_count, ra_succss };
+	}
+
+	/*
+		The function gets all the wanted lines that are counted from the same start position, in one pass over the file.
+		@ lines - Pairs of (line number, place in lines_data), sorted by the line number.
+	*/
+	void FileHandler::scanLinesAt(long start, const pair<unsigned int, size_t>* lines, size_t count, vector<retObj<string>>& lines_data) noexcept
+	{
+		vector<char> chunk(LINE_SCAN_FIRST_CHUNK); // Starts small since with a line index the wanted lines are close
+		string line_data;
+		unsigned int curr_line = 0;
+		size_t curr = 0;
+		long offset = start;
+		bool ended = false;
+		bool read_fail = false;
+
+		while (curr < count && !ended)
+		{
+			long read_count = this->preadFile(chunk.data(), chunk.size(), offset);
+			if (read_count <= 0) { read_fail = read_count < 0; break; }
+
+			for (size_t i = 0; i < (size_t)read_count && curr < count;)
+			{
+				size_t stop = i + FileScanner::findLineStop(chunk.data() + i, (size_t)read_count - i);
+
+				if (lines[curr].first == curr_line) { line_data.append(chunk.data() + i, stop - i); }
+				if (stop == (size_t)read_count) { break; }
+
+				const char ch = chunk[stop];
+				i = stop + 1;
+
+				if (ch == '\0') { ended = true; break; }
+
+				if (ch == '\n')
+				{
+					if (!this->clearCharsCanUse) { this->filterData(line_data); }
+					for (; curr < count && lines[curr].first == curr_line; curr++) { lines_data[lines[curr].second] = { line_data, ra_succss }; }
+
+					line_data.clear();
+					curr_line++;
+				}
+			}
+
+			offset += read_count;
+			if (chunk.size() < LINE_INDEX_READ_CHUNK) { chunk.resize(chunk.size() * 2); }
+		}
+
+		if (read_fail) // The rest of the lines weren't reached, and the current one may be cut
+		{
+			for (; curr < count; curr++) { lines_data[lines[curr].second] = { "", ra_readfile_fail }; }
+			return;
+		}
+
+		if (!this->clearCharsCanUse) { this->filterData(line_data); }
+		for (; curr < count && lines[curr].first == curr_line; curr++) { lines_data[lines[curr].second] = { line_data, ra_succss }; }
+		for (; curr < count; curr++) { lines_data[lines[curr].second] = { "", ra_endoffile_fail }; }
+	}
+
+	/*
+		The function gets many lines out of a file, each line by its number and start position like in getLine.
+		@ The lines are returned in the same order as they were asked.
+		@ Lines that are counted from the same position are found in one pass over the file, and the passes
+			run in parallel on the shared worker pool. With a line index, every line has its own short pass.
+		@ If the file was scanned by scanStats and didn't change, lines after its end fail without reading it.
+		--> The cursor of the file isn't used, so no rewinding is needed.
+	*/
+	retObj<vector<retObj<string>>> FileHandler::getLines(const vector<pair<unsigned int, int>>& lines_pos, const bool& flush_file) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::get_lines);
+
+		if (this->file == NULL) { return { {}, ra_fileisclosed_fail }; }
+		if (!this->canReadFile() || this->codec != nullptr) { return { {}, ra_fileaccesstype_fail }; }
+
+		this->syncWriteBehind();
+
+		if ((flush_file || this->last_move == WRITE_OP) && this->buffer_type != bufferType::non_buffer) { this->flushStream(); }
+
+		this->last_move = READ_OP;
+
+		if (lines_pos.empty()) { return { {}, ra_succss }; }
+
+		struct line_request
+		{
+			long start;
+			unsigned int numline;
+			size_t place;
+		};
+
+		vector<line_request> requests;
+		requests.reserve(lines_pos.size());
+
+		retObj<vector<retObj<string>>> retObject = { vector<retObj<string>>(lines_pos.size()), ra_succss };
+		const bool scanned = this->isScanCurrent() && this->scan_cache.nul_bytes == 0; // The lines after the end of the file are known without a pass over it
+
+		for (size_t i = 0; i < lines_pos.size(); i++)
+		{
+			unsigned int numline = lines_pos[i].first;
+			long start = 0;
+
+			if (scanned && lines_pos[i].second < 0 && numline > this->scan_cache.new_lines) { retObject.obj[i] = { "", ra_endoffile_fail }; continue; }
+
+			if (lines_pos[i].second >= 0) { start = lines_pos[i].second; }
+			else if (this->line_index_enabled) { start = this->seekLineIndex(numline); }
+
+			requests.push_back({ start, numline, i });
+		}
+
+		std::sort(requests.begin(), requests.end(), [](const line_request& a, const line_request& b)
+			{ return a.start != b.start ? a.start < b.start : a.numline < b.numline; });
+
+		vector<pair<unsigned int, size_t>> lines;
+		vector<pair<size_t, size_t>> groups; // Ranges in lines that share the same start position
+		lines.reserve(requests.size());
+
+		for (size_t i = 0; i < requests.size(); i++)
+		{
+			if (i == 0 || requests[i].start != requests[i - 1].start) { groups.push_back({ i, i }); }
+
+			lines.push_back({ requests[i].numline, requests[i].place });
+			groups.back().second = i + 1;
+		}
+
+		if (!this->clearCharsCanUse) { this->getCharFilter(); } // Compiled here so the workers only read it
+
+		try
+		{
+			FileWorkerPool::getSharedPool().runTasks(groups.size(), [&](size_t group)
+				{
+					FileTraceScope trace(this->getTracer(), traceOp::task, &this->file_path, requests[groups[group].first].start, groups[group].second - groups[group].first);
+					this->scanLinesAt(requests[groups[group].first].start, lines.data() + groups[group].first,
+						groups[group].second - groups[group].first, retObject.obj);
+				});
+		}
+		catch (...) { return { {}, ra_unknown_fail }; }
+
+		return retObject;
+	}
+
+	/*
+		The function splits the file into about count ranges of whole lines, for reading them in parallel.
+		@ Every cut is moved to right after the first line stop ('\n' or '\0') at or after it, so no line is split
+			between two ranges. A line longer than a range makes less ranges.
+		@ The ranges are at least min_range_size bytes, so a small file isn't split for nothing.
+	*/
+	retObj<vector<line_range>> FileHandler::splitLineRanges(size_t count, size_t min_range_size) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		returnAns status = this->prepareFdAccess(false);
+		if (status != ra_succss) { return { {}, status }; }
+
+		const long file_len = this->getFilesLength();
+		if (file_len < 0) { return { {}, ra_readfile_fail }; }
+
+		if (!this->clearCharsCanUse) { this->getCharFilter(); } // Compiled here so the readers of the ranges only read it
+
+		count = std::max<size_t>(1, std::min(count, (size_t)file_len / std::max<size_t>(1, min_range_size)));
+
+		try
+		{
+			vector<line_range> ranges;
+			ranges.reserve(count);
+
+			char probe[LINE_SCAN_FIRST_CHUNK];
+			long start = 0;
+
+			for (size_t i = 1; i < count; i++)
+			{
+				long pos = (long)((unsigned long long)file_len * i / count) - 1; // The line that has the byte before the cut ends the range
+				long stop = NON_WORK;
+
+				if (pos < start) { continue; }
+
+				while (stop < 0 && pos < file_len)
+				{
+					long read_count = this->preadFile(probe, sizeof(probe), pos);
+					if (read_count <= 0) { break; }
+
+					for (long j = 0; j < read_count; j++)
+					{
+						if (probe[j] == '\n' || probe[j] == '\0') { stop = pos + j; break; }
+					}
+
+					pos += read_count;
+				}
+
+				if (stop < 0) { break; } // The rest of the file is one line
+
+				ranges.push_back({ start, stop + 1 });
+				start = stop + 1;
+			}
+
+			if (start < file_len || ranges.empty()) { ranges.push_back({ start, file_len }); }
+
+			return { ranges, ra_succss };
+		}
+		catch (...) { return { {}, ra_unknown_fail }; }
+	}
+
+	typedef struct find_plan // The compiled patterns of one search, shared by all its ranges
+	{
+		const vector<string>* patterns;
+		vector<std::regex> regexes; // Empty when the patterns are literal
+		size_t max_length; // Of the longest literal pattern
+		size_t max_matches;
+		long start; // The searched bytes are [start, end)
+		long end;
+		std::atomic<bool>* stop; // Set when no more matches are wanted
+	} find_plan;
+
+	typedef struct find_piece // The matches of one range, kept until all the ranges before it are given
+	{
+		vector<find_match> matches; // Their line is counted from the start of the range
+		unsigned long lines; // Amount of '\n' in the range
+		unsigned int status;
+		bool done;
+	} find_piece;
+
+	/*
+		The function adds the amount of '\n' in the bytes [start, end) of the file to count.
+		@ Returns false if reading failed.
+	*/
+	bool FileHandler::countLineEnds(long start, long end, unsigned long& count) noexcept
+	{
+		try
+		{
+			vector<char> block(std::min<size_t>(DFLT_RANGE_BLOCK_SIZE, (size_t)std::max(0L, end - start)));
+
+			while (start < end)
+			{
+				long read_count = this->preadFile(block.data(), std::min(block.size(), (size_t)(end - start)), start);
+				if (read_count < 0) { return false; }
+				if (read_count == 0) { break; }
+
+				count += (unsigned long)FileScanner::countByte(block.data(), (size_t)read_count, '\n');
+				start += read_count;
+			}
+
+			return true;
+		}
+		catch (...) { return false; }
+	}
+
+	/*
+		The function finds the matches of the patterns that start in the bytes [start, end) of the file, and puts them in the piece by their order in the file.
+		@ Literal patterns are found by FileScanner::findPair on blocks of the file, and the blocks overlap by the longest pattern so no match is split between them.
+		@ Regexes are matched against every line that starts in the range, a line that starts in the range before it is left to that range.
+		@ The '\n' before every match are counted only up to it, so the whole range is counted only once.
+	*/
+	void FileHandler::findInRange(const find_plan& plan, long start, long end, find_piece& piece) noexcept
+	{
+		piece.lines = 0;
+		piece.status = ra_succss;
+
+		try
+		{
+			const bool regex = !plan.regexes.empty();
+			const size_t overlap = regex ? 0 : plan.max_length - 1;
+			const long read_end = regex ? plan.end : std::min(plan.end, end + (long)overlap);
+			vector<char> buffer(FIND_BLOCK_SIZE + overlap);
+
+			bool skip_line = regex && start > plan.start; // The byte before the range tells if a line starts at it
+			long buffer_pos = skip_line ? start - 1 : start; // The offset of the first byte of the buffer
+			long read_pos = buffer_pos;
+			long counted = start; // The '\n' up to here are counted in piece.lines
+			size_t kept = 0;
+			bool last = false;
+
+			while (!last && !plan.stop->load(std::memory_order_relaxed))
+			{
+				if (kept == buffer.size()) { buffer.resize(buffer.size() * 2); } // A line longer than the buffer
+
+				const size_t wanted = std::min(buffer.size() - kept, (size_t)(read_end - read_pos));
+				const long read_count = wanted > 0 ? this->preadFile(buffer.data() + kept, wanted, read_pos) : 0;
+				if (read_count < 0) { piece.status = ra_readfile_fail; return; }
+
+				read_pos += read_count;
+				last = (size_t)read_count < wanted || read_pos >= read_end;
+
+				const char* data = buffer.data();
+				const size_t size = kept + (size_t)read_count;
+				const size_t first_match = piece.matches.size();
+				size_t done = 0; // The places before it were searched, the bytes after it are kept for the next block
+
+				if (!regex)
+				{
+					done = last ? size : size - overlap;
+					const size_t limit = std::min(done, (size_t)std::max(0L, end - buffer_pos));
+
+					for (unsigned int p = 0; p < plan.patterns->size(); p++)
+					{
+						const string& pattern = (*plan.patterns)[p];
+						const size_t length = pattern.size();
+						const size_t scan_end = std::min(size, limit + length - 1);
+						size_t place = 0;
+
+						while (place < limit)
+						{
+							place += FileScanner::findPair(data + place, scan_end - place, pattern.front(), pattern.back(), length - 1);
+							if (place >= limit) { break; }
+
+							if (length <= 2 || !memcmp(data + place + 1, pattern.data() + 1, length - 2)) { piece.matches.push_back({ buffer_pos + (long)place, length, 0, p }); }
+							place++;
+						}
+					}
+				}
+				else
+				{
+					size_t line_start = 0;
+
+					if (skip_line)
+					{
+						const char* line_end = (const char*)memchr(data, '\n', size);
+						line_start = line_end != nullptr ? (size_t)(line_end - data) + 1 : size;
+						skip_line = line_end == nullptr;
+					}
+
+					while (!skip_line && line_start < size && buffer_pos + (long)line_start < end)
+					{
+						const char* line_end = (const char*)memchr(data + line_start, '\n', size - line_start);
+						if (line_end == nullptr && !last) { break; } // The line goes on in the next block
+
+						const char* line = data + line_start;
+						const size_t line_size = (line_end != nullptr ? (size_t)(line_end - data) : size) - line_start;
+						const size_t match_size = (line_size > 0 && line[line_size - 1] == '\r') ? line_size - 1 : line_size;
+
+						for (unsigned int p = 0; p < plan.regexes.size(); p++)
+						{
+							for (std::cregex_iterator found(line, line + match_size, plan.regexes[p]), found_end; found != found_end; ++found)
+							{
+								if (found->length(0) == 0) { continue; } // Empty matches (like of "^") aren't places in the file
+
+								piece.matches.push_back({ buffer_pos + (long)(line_start + found->position(0)), (size_t)found->length(0), 0, p });
+							}
+						}
+
+						line_start += line_size + 1;
+					}
+
+					done = std::min(line_start, size);
+					if (buffer_pos + (long)done >= end) { last = true; }
+				}
+
+				if (plan.patterns->size() > 1)
+				{
+					std::sort(piece.matches.begin() + first_match, piece.matches.end(), [](const find_match& a, const find_match& b)
+						{ return a.offset != b.offset ? a.offset < b.offset : a.pattern < b.pattern; });
+				}
+
+				for (size_t m = first_match; m < piece.matches.size(); m++)
+				{
+					find_match& match = piece.matches[m];
+
+					piece.lines += (unsigned long)FileScanner::countByte(data + (counted - buffer_pos), (size_t)(match.offset - counted), '\n');
+					counted = match.offset;
+					match.line = piece.lines;
+				}
+
+				const long count_end = std::min(buffer_pos + (long)done, end);
+
+				if (count_end > counted)
+				{
+					piece.lines += (unsigned long)FileScanner::countByte(data + (counted - buffer_pos), (size_t)(count_end - counted), '\n');
+					counted = count_end;
+				}
+
+				if (plan.max_matches > 0 && piece.matches.size() >= plan.max_matches) { break; } // The ranges after it won't be given
+
+				kept = size - done;
+				if (kept > 0 && done > 0) { memmove(buffer.data(), buffer.data() + done, kept); }
+				buffer_pos += (long)done;
+			}
+		}
+		catch (...) { piece.status = ra_unknown_fail; }
+	}
+
+	/*
+		The function searches the file for the patterns, and gives every match to the callback by the order of the file.
+		@ Literal patterns are found by their bytes, every place a pattern starts at is a match, so the matches of a pattern can overlap.
+		@ With options.regex the patterns are regexes that are matched against every line ('\r' at its end is removed), like grep.
+		@ Large files are split between the workers of the shared pool, and read in blocks so the file is never kept whole in memory.
+			The matches of a range are kept until the ranges before it ended, and are given right after.
+		@ The callback is called one match at a time (from the calling thread or a worker), and can return false to stop the search.
+		@ Returns the amount of matches given.
+		--> The ignoring table isn't applied, the offsets are of the bytes in the file!
+		--> In the thread safe mode the callback must not call other functions of the handler, the search holds its lock.
+	*/
+	retObj<size_t> FileHandler::find(const vector<string>& patterns, const function<bool(const find_match&)>& callback, const find_options& options) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::find);
+
+		returnAns status = this->prepareFdAccess(false);
+		if (status != ra_succss) { return { 0, status }; }
+
+		const long file_len = this->getFilesLength();
+		if (file_len < 0) { return { 0, ra_readfile_fail }; }
+
+		const long end = options.end == NON_WORK ? file_len : std::min(options.end, file_len);
+		if (!callback || options.start < 0 || options.start > file_len || (options.end != NON_WORK && options.end < options.start)) { return { 0, ra_outofrange_fail }; }
+		if (patterns.empty() || options.start >= end) { return { 0, ra_succss }; }
+
+		std::atomic<bool> stop{ false };
+		find_plan plan = { &patterns, {}, 0, options.max_matches, options.start, end, &stop };
+
+		try
+		{
+			for (const string& pattern : patterns)
+			{
+				if (pattern.empty()) { return { 0, ra_outofrange_fail }; }
+
+				plan.max_length = std::max(plan.max_length, pattern.size());
+				if (options.regex) { plan.regexes.emplace_back(pattern, std::regex::ECMAScript | std::regex::optimize); }
+			}
+		}
+		catch (const std::regex_error&) { return { 0, ra_outofrange_fail }; }
+		catch (...) { return { 0, ra_unknown_fail }; }
+
+		unsigned long lines = 0;
+		long counted = 0;
+
+		if (this->line_index_enabled && !this->line_index_offsets.empty()) // The '\n' before the search are counted from the closest checkpoint
+		{
+			size_t checkpoint = (size_t)(std::upper_bound(this->line_index_offsets.begin(), this->line_index_offsets.end(), options.start) - this->line_index_offsets.begin());
+			checkpoint = checkpoint > 0 ? checkpoint - 1 : 0;
+
+			lines = (unsigned long)(checkpoint * this->line_index_step);
+			counted = this->line_index_offsets[checkpoint];
+		}
+
+		if (!this->countLineEnds(counted, options.start, lines)) { return { 0, ra_readfile_fail }; }
+
+		FileWorkerPool& pool = FileWorkerPool::getSharedPool();
+		const size_t wanted = options.parallel.ranges > 0 ? options.parallel.ranges : (size_t)pool.getWorkersCount() * LINE_RANGES_PER_WORKER;
+		const size_t count = std::max<size_t>(1, std::min(wanted, (size_t)(end - options.start) / std::max<size_t>(1, options.parallel.min_range_size)));
+
+		size_t given = 0;
+		unsigned int given_status = ra_succss;
+
+		try
+		{
+			vector<find_piece> pieces(count);
+			size_t next_piece = 0;
+			mutex given_mutex;
+
+			auto rangeStart = [&](size_t piece) { return options.start + (long)((unsigned long long)(end - options.start) * piece / count); };
+
+			pool.runTasks(count, [&](size_t piece)
+				{
+					{
+						FileTraceScope trace(this->getTracer(), traceOp::task, &this->file_path, rangeStart(piece), (size_t)(rangeStart(piece + 1) - rangeStart(piece)));
+						this->findInRange(plan, rangeStart(piece), rangeStart(piece + 1), pieces[piece]);
+					}
+
+					lock_guard<mutex> given_lock(given_mutex);
+					pieces[piece].done = true;
+
+					while (next_piece < count && pieces[next_piece].done) // Gives the ranges that all the ranges before them were given
+					{
+						find_piece& ready = pieces[next_piece++];
+
+						if (ready.status != ra_succss && !stop.load()) { given_status = ready.status; stop = true; }
+
+						for (size_t m = 0; m < ready.matches.size() && !stop.load(); m++)
+						{
+							ready.matches[m].line += lines;
+							given++;
+
+							bool go_on = false;
+							try { go_on = callback(ready.matches[m]); }
+							catch (...) { given_status = ra_unknown_fail; }
+
+							if (!go_on || (options.max_matches > 0 && given >= options.max_matches)) { stop = true; }
+						}
+
+						lines += ready.lines;
+						vector<find_match>().swap(ready.matches);
+					}
+				});
+		}
+		catch (...) { return { given, ra_unknown_fail }; }
+
+		return { given, given_status };
+	}
+
+	/*
+		The function searches the file for the patterns like find, and returns all the matches by the order of the file.
+	*/
+	retObj<vector<find_match>> FileHandler::findAll(const vector<string>& patterns, const find_options& options) noexcept
+	{
+		vector<find_match> matches;
+
+		retObj<size_t> found = this->find(patterns, [&matches](const find_match& match) { matches.push_back(match); return true; }, options);
+
+		return { std::move(matches), found.statusObj };
+	}
+
+	/*
+		The function searches the file for one pattern like find, and returns all the matches by the order of the file.
+	*/
+	retObj<vector<find_match>> FileHandler::findAll(const string& pattern, const find_options& options) noexcept
+	{
+		try { return this->findAll(vector<string>{ pattern }, options); }
+		catch (...) { return { {}, ra_unknown_fail }; }
+	}
+
+	/*
+		The function counts the lines, the line ends, the "\r\n" pairs and the '\0' of the file, and finds its longest line.
+		@ The file is read in large blocks that are scanned with FileScanner::scanBytes, and large files are split between the workers of the shared pool.
+		@ The result is kept until the file changes, so calling it again costs one fstat at most (see setMetaTtl). refresh scans the file anyway.
+		--> The ignoring table isn't applied, the bytes are counted as they are in the file!
+	*/
+	retObj<scan_stats> FileHandler::scanStats(const bool& refresh, const parallel_options& options) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::scan_stats);
+
+		returnAns status = this->prepareFdAccess(false);
+		if (status != ra_succss) { return { scan_stats(), status }; }
+
+		if (!refresh && this->isScanCurrent()) { return { this->scan_cache, ra_succss }; }
+
+		retObj<file_meta> meta = this->getFileMeta(true);
+		if (meta.statusObj != ra_succss) { return { scan_stats(), ra_readfile_fail }; }
+
+		const long file_len = meta.obj.size;
+		FileWorkerPool& pool = FileWorkerPool::getSharedPool();
+		const size_t wanted = options.ranges > 0 ? options.ranges : (size_t)pool.getWorkersCount() * LINE_RANGES_PER_WORKER;
+		const size_t count = std::max<size_t>(1, std::min(wanted, (size_t)file_len / std::max<size_t>(1, options.min_range_size)));
+
+		byte_counts total = byte_counts();
+		std::atomic<unsigned int> part_status{ ra_succss };
+
+		try
+		{
+			vector<byte_counts> parts(count, byte_counts());
+
+			auto partStart = [&](size_t part) { return (long)((unsigned long long)file_len * part / count); };
+
+			pool.runTasks(count, [&](size_t part)
+				{
+					FileTraceScope trace(this->getTracer(), traceOp::task, &this->file_path, partStart(part), (size_t)(partStart(part + 1) - partStart(part)));
+					const long part_end = partStart(part + 1);
+					vector<char> block(std::min<size_t>(DFLT_RANGE_BLOCK_SIZE, (size_t)(part_end - partStart(part))));
+					byte_counts block_counts;
+
+					for (long offset = partStart(part); offset < part_end;)
+					{
+						long read_count = this->preadFile(block.data(), std::min(block.size(), (size_t)(part_end - offset)), offset);
+						if (read_count < 0) { part_status = ra_readfile_fail; return; }
+						if (read_count == 0) { break; }
+
+						FileScanner::scanBytes(block.data(), (size_t)read_count, block_counts);
+						FileScanner::mergeCounts(parts[part], block_counts);
+						offset += read_count;
+					}
+				});
+
+			for (const byte_counts& part : parts) { FileScanner::mergeCounts(total, part); }
+		}
+		catch (...) { return { scan_stats(), ra_unknown_fail }; }
+
+		if (part_status != ra_succss) { return { scan_stats(), part_status.load() }; }
+
+		const scan_stats stats = { (long)total.size, (unsigned long long)total.new_lines + (total.last_line > 0 ? 1 : 0), total.new_lines, total.crlf_pairs, total.nul_bytes,
+			std::max({ total.longest_line, total.first_line, total.last_line }) };
+
+		this->scan_valid = (long)total.size == file_len; // Not kept if the file changed while it was read
+		this->scan_cache = stats;
+		this->scan_meta = meta.obj;
+
+		return { stats, ra_succss };
+	}
+
+	/*
+		The function returns the amount of lines in the file, as '\n' splits them (a last line without '\n' is counted too).
+		@ It uses scanStats, so it is kept until the file changes.
+	*/
+	retObj<unsigned long long> FileHandler::countLines(const bool& refresh) noexcept
+	{
+		retObj<scan_stats> stats = this->scanStats(refresh);
+		return { stats.obj.lines, stats.statusObj };
+	}
+
+	/*
+		The function gets many lines out of a file, and puts them in a map by their (line number, position) pair.
+		@ This file returns error if during the getting line, the file met \0 of EOF operators and the wanted line wasn't reached yet.
+		--> Kept for old code, getLines returns the same lines in a flat vector.
+	*/
+	void FileHandler::getLineMultiThreaded(retObj<map<pair<unsigned int, int>, retObj<string>>>& retObject, const vector<pair<unsigned int, int>>& lines_pos, [[maybe_unused]] unsigned int buff_size, [[maybe_unused]] const bool& auto_rewind, const bool& flush_file)
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file != NULL)
+		{
+			if (!this->thread_safe) { retObject = { {}, ra_notthreadsafe_fail }; return; }
+			if (lines_pos.size() <= 0) { retObject = { {}, ra_succss }; return; }
+
+			retObj<vector<retObj<string>>> lines_data = this->getLines(lines_pos, flush_file);
+
+			if (lines_data.statusObj != ra_succss) { retObject = { {}, lines_data.statusObj }; return; }
+
+			for (size_t i = 0; i < lines_pos.size(); i++)
+			{
+				retObject.obj.insert(pair<pair<unsigned int, int>, retObj<string>>(lines_pos[i], std::move(lines_data.obj[i])));
+			}
+
+			retObject.statusObj = ra_succss;
+
+			return;
+		}
+
+		retObject = { {},  ra_fileisclosed_fail };
+	}
+
+	/*
+		The function is closing a file and the buffer if opened.
+		@ In the compressed modes the end of the compressed data is written on closing, so a failed close returns false.
+		@ The destructor closes the file through this function too, so the mapping of read_m is released either way.
+	*/
+	bool FileHandler::closeFile() noexcept { FileHandlerLock lock(*this); this->setWriteBehind(false); this->closeDirect(); if (this->line_index_enabled && this->line_index_sidecar) { this->saveLineIndex(); } this->clearLineIndex(); this->unmapFile(); file_path = "";  file_name = ""; extension = ""; thread_safe = false; this->adaptive_buffer = false; this->meta_valid = false; this->scan_valid = false; bool val = false; if (this->file != NULL) { val = !fclose(this->file) || this->codec == nullptr; this->file = NULL; this->codec = nullptr; } if (this->file_buffer != NULL) { freeFileBuffer(this->file_buffer, this->file_buffer_size); this->file_buffer = NULL; this->file_buffer_size = 0; } return val; }
+
+	/*
+		The function deletes the function from the computer.
+	*/
+	bool FileHandler::removeFile() noexcept { FileHandlerLock lock(*this); closeFile(); return !remove(this->file_path.c_str()); }
+
+	/*
+		The function flushed the buffer if existst and if in writing mode, else just return true.
+		@ In the write-behind mode it first waits for the queued data to be written.
+	*/
+	bool FileHandler::flushFile() noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::flush);
+
+		bool behind_val = this->syncWriteBehind();
+
+		if (this->buffer_type == bufferType::non_buffer) { return behind_val; }
+
+		if (this->file != NULL && (this->file_access == openFileModes::write || this->file_access == openFileModes::write_b ||
+			this->file_access == openFileModes::append || this->file_access == openFileModes::append_b || this->last_move == WRITE_OP))
+		{
+			return !this->flushStream() && behind_val;
+		}
+
+		return false;
+	}
+
+	/*
+		The function changes the file buffer type and size.
+	*/
+	bool FileHandler::changeFileBuffer(const bufferType& buff_type, size_t buff_size) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (file != NULL)
+		{
+			this->syncWriteBehind();
+
+			if (buff_size > MAX_BUFFER_SIZE)
+			{
+				buff_size = MAX_BUFFER_SIZE;
+			}
+			else if (buff_size < MIN_BUFFER_SIZE)
+			{
+				buff_size = MIN_BUFFER_SIZE;
+			}
+
+			return this->resizeFileBuffer(buff_type, buff_size);
+		}
+
+		return false;
+	}
+
+	/*
+		The function replaces the buffer of the opened file.
+		@ The old buffer is flushed (or its read ahead data is dropped) and the cursor is put back, so no data is lost.
+		--> The old buffer is freed only after the stream stopped using it!
+	*/
+	bool FileHandler::resizeFileBuffer(const bufferType& buff_type, size_t buff_size) noexcept
+	{
+		long curr_pos = ftell(this->file);
+		if (this->flushStream()) { return false; }
+
+		char* new_buffer = NULL;
+
+		if (buff_type != bufferType::non_buffer)
+		{
+			new_buffer = allocFileBuffer(buff_size);
+			if (new_buffer == NULL) { return false; }
+		}
+
+		int mode = DEFUALT_BUFFER_NAME;
+
+		switch (buff_type)
+		{
+		case bufferType::non_buffer: { mode = _IONBF; break; }
+		case bufferType::line_buffer: { mode = _IOLBF; break; }
+		case bufferType::full_buffer: { mode = _IOFBF; break; }
+		default: { mode = DEFUALT_BUFFER_NAME; }
+		}
+
+		if (setvbuf(this->file, new_buffer, mode, buff_size))
+		{
+			freeFileBuffer(new_buffer, buff_size);
+			return false;
+		}
+
+		freeFileBuffer(this->file_buffer, this->file_buffer_size);
+
+		this->file_buffer = new_buffer;
+		this->file_buffer_size = new_buffer != NULL ? (unsigned int)buff_size : 0;
+		this->buffer_type = buff_type;
+
+		if (curr_pos >= 0) { this->seekFile(curr_pos, SEEK_SET); }
+
+		return true;
+	}
+
+	/*
+		The function borrows a buffer for a file from the shared buffer pool, it is page aligned so big buffers fill whole pages.
+		@ Returns NULL if the allocation failed.
+		@ It is a static function.
+	*/
+	char* FileHandler::allocFileBuffer(size_t buff_size) noexcept
+	{
+		return FileBufferPool::getSharedPool().acquire(buff_size);
+	}
+
+	/*
+		The function gives a buffer that was borrowed by allocFileBuffer back to the shared buffer pool.
+		@ It is a static function.
+	*/
+	void FileHandler::freeFileBuffer(char* buffer, size_t buff_size) noexcept
+	{
+		FileBufferPool::getSharedPool().release(buffer, buff_size);
+	}
+
+	/*
+		The function gets the file's state.
+	*/
+	file_data FileHandler::getFileState() noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		unsigned int file_len = 0;
+		unsigned int buffer_type_number = 0;
+		string buffer_type;
+
+		switch (this->buffer_type)
+		{
+		case bufferType::non_buffer: { buffer_type = "No Buffering"; buffer_type_number = _IONBF; break; }
+		case bufferType::line_buffer: { buffer_type = "Line Buffering"; buffer_type_number = _IOLBF;  break; }
+		case bufferType::full_buffer: { buffer_type = "Full Buffering"; buffer_type_number = _IOFBF; break; }
+		default:
+		{
+			buffer_type = DEFUALT_BUFFER_NAME_TXT;
+			buffer_type_number = DEFUALT_BUFFER_NAME;
+		}
+		}
+
+		return { this->file_path, this->file_name, this->extension, this->file_buffer,  buffer_type_number, buffer_type,
+							getFileStreamType(this->file_access), getFilesLength(), this->file_buffer_size, this->last_move, this->getIOStats() };
+	}
+
+	/*
+		The function move's the cursor around the file.
+		--> This function is slow and should'nt be used a lot!
+	*/
+	bool FileHandler::moveCursorInFile(const filePosSet& pos_set, long offset) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (file == NULL)
+			return false;
+
+		this->syncWriteBehind();
+
+		int curser_pos = 0;
+
+		this->last_file_place = ftell(this->file);
+
+		switch (pos_set)
+		{
+		case filePosSet::start_file: { curser_pos = SEEK_SET; break; }
+		case filePosSet::current_file: { curser_pos = SEEK_CUR; break; }
+		case filePosSet::end_file: { curser_pos = SEEK_END; break; }
+		default:
+			curser_pos = SEEK_SET;
+		}
+
+		return !this->seekFile(offset, curser_pos);
+	}
+
+	/*
+		Sets the file's ignoring data.
+		--> The ignoring is set both to reading and writing options!
+	*/
+	bool FileHandler::setIgnoring(const ignore_data& ignoring) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL) { return false; }
+
+		if (!ignoring.ignore_signle_chars.empty()) { this->clearCharsCanUse = false; }
+
+		for (size_t i = 0; i < ignoring.ignore_signle_chars.size(); i++)
+		{
+			this->charsCanUse[(unsigned char)ignoring.ignore_signle_chars[i]] = false;
+		}
+
+		for (size_t i = 0; i < ignoring.ignore_range_chars.size(); i++)
+		{
+			const pair<char, char>& range_data = ignoring.ignore_range_chars[i];
+
+			if ((unsigned char)range_data.first <= (unsigned char)range_data.second)
+			{
+				this->clearCharsCanUse = false;
+
+				for (unsigned int j = (unsigned char)range_data.first; j <= (unsigned char)range_data.second; j++)
+				{
+					this->charsCanUse[j] = false;
+				}
+			}
+		}
+
+		this->char_filter_dirty = true;
+
+		return true;
+	}
+
+	/*
+		Clears the file's ignoring data.
+		--> The ignoring is cleared both to reading and writing options!
+	*/
+	bool FileHandler::clearIngoring() noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL) { return false; }
+
+		for (int i = 0; i < MAX_CHAR_CAPACITY; i++)
+		{
+			this->charsCanUse[i] = true;
+		}
+
+		this->clearCharsCanUse = true;
+		this->char_filter_dirty = true;
+
+		return true;
+	}
+
+	/*
+		The function resets the line index to an empty index that starts at the beginning of the file.
+	*/
+	void FileHandler::resetLineIndex() noexcept
+	{
+		this->line_index_offsets.assign(1, 0);
+		this->line_index_lines = 0;
+		this->line_index_end = 0;
+		this->line_index_stopped = false;
+	}
+
+	/*
+		The function adds the given data, which sits right after the indexed part of the file, into the line index.
+		--> Every line_index_step's line gets a checkpoint so the memory stays bounded on big files.
+	*/
+	void FileHandler::scanLineIndex(const char* data, size_t size) noexcept
+	{
+		if (this->line_index_stopped || data == nullptr) { return; }
+
+		for (size_t i = FileScanner::findLineStop(data, size); i < size; i += 1 + FileScanner::findLineStop(data + i + 1, size - i - 1))
+		{
+			if (data[i] == '\0') // Every line scan stops on '\0' so nothing after it can be reached by line
+			{
+				this->line_index_stopped = true;
+				this->line_index_end += (long)i;
+				return;
+			}
+
+			if (data[i] == '\n' && (++this->line_index_lines) % this->line_index_step == 0)
+			{
+				this->line_index_offsets.push_back(this->line_index_end + (long)i + 1);
+			}
+		}
+
+		this->line_index_end += (long)size;
+	}
+
+	/*
+		The function reads the part of the file that isn't indexed yet and adds it into the line index.
+		@ The cursor of the file is restored when the function ends.
+	*/
+	bool FileHandler::extendLineIndex() noexcept
+	{
+		if (this->file == NULL) { return false; }
+		if (this->line_index_stopped) { return true; }
+
+		this->syncWriteBehind();
+
+		if (!this->canReadFile())
+		{
+			return this->getFilesLength() == this->line_index_end; // Can't read, so the index is good only if nothing is missing
+		}
+
+		long curr_pos = ftell(this->file);
+		if (this->seekFile(this->line_index_end, SEEK_SET)) { return false; }
+
+		char* chunk = new char[LINE_INDEX_READ_CHUNK];
+		size_t read_count = 0;
+
+		while (!this->line_index_stopped && (read_count = fread(chunk, sizeof(char), LINE_INDEX_READ_CHUNK, this->file)) > 0)
+		{
+			this->scanLineIndex(chunk, read_count);
+		}
+
+		delete[] chunk;
+		chunk = nullptr;
+
+		clearerr(this->file);
+		this->seekFile(curr_pos, SEEK_SET);
+
+		return true;
+	}
+
+	/*
+		The function keeps the line index up to date after the given data was written into the file.
+		@ If no write_start is given, the data is taken as written right before the cursor.
+		--> Appending at the end of the indexed part just extends the index, writing inside of it drops the checkpoints after the write.
+	*/
+	void FileHandler::updateLineIndex(const char* data, size_t size, long write_start) noexcept
+	{
+		if (write_start < 0)
+		{
+			long write_end = ftell(this->file);
+			if (write_end < 0) { this->line_index_enabled = false; this->resetLineIndex(); return; } // Also called by the flusher, so it can't wait for it
+
+			write_start = write_end - (long)size;
+		}
+
+		if (write_start == this->line_index_end)
+		{
+			this->scanLineIndex(data, size);
+		}
+		else if (write_start < this->line_index_end)
+		{
+			while (this->line_index_offsets.size() > 1 && this->line_index_offsets.back() > write_start)
+			{
+				this->line_index_offsets.pop_back();
+			}
+
+			this->line_index_lines = (unsigned long)(this->line_index_offsets.size() - 1) * this->line_index_step;
+			this->line_index_end = this->line_index_offsets.back();
+			this->line_index_stopped = false;
+		}
+	}
+
+	/*
+		The function returns the closest indexed offset before the wanted line and lowers numline to the amount of lines left to skip from it.
+		--> If the wanted line is after the indexed part, the index is extended first.
+	*/
+	long FileHandler::seekLineIndex(unsigned int& numline) noexcept
+	{
+		if (numline > this->line_index_lines) { this->extendLineIndex(); }
+
+		size_t checkpoint = std::min((size_t)(numline / this->line_index_step), this->line_index_offsets.size() - 1);
+		numline -= (unsigned int)(checkpoint * this->line_index_step);
+
+		return this->line_index_offsets[checkpoint];
+	}
+
+	/*
+		Builds the line index of the file, so getting a line costs one seek and a short scan instead of scanning from the beginning of the file.
+		@ step - The amount of lines between every two checkpoints (The memory used is about 8 bytes per step lines).
+		@ use_sidecar - Loads the index from a sidecar file (file path + LINE_INDEX_SIDECAR_EXT) if it is still valid, and saves it there.
+		@ The sidecar is saved again when the file is closed, by closeFile() or by the destructor, so the lines indexed since are kept.
+		--> The index is updated by the writes of this object, but changes made by others to the file aren't seen!
+	*/
+	bool FileHandler::buildLineIndex(unsigned int step, const bool& use_sidecar) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL) { return false; }
+
+		this->line_index_step = (step > 0) ? step : DFLT_LINE_INDEX_STEP;
+		this->line_index_sidecar = use_sidecar;
+
+		if (use_sidecar && this->loadLineIndex()) { return true; }
+
+		this->resetLineIndex();
+		this->line_index_enabled = true;
+
+		if (!this->extendLineIndex())
+		{
+			this->clearLineIndex();
+			return false;
+		}
+
+		if (use_sidecar) { this->saveLineIndex(); }
+
+		return true;
+	}
+
+	/*
+		Loads the line index from the sidecar file.
+		@ The sidecar is ignored if the file's length, modification time or the index step changed since it was saved.
+	*/
+	bool FileHandler::loadLineIndex() noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL) { return false; }
+
+		retObj<file_meta> meta = this->getFileMeta(true);
+		if (meta.statusObj != ra_succss) { return false; }
+
+		FILE* sidecar = fopen((this->file_path + LINE_INDEX_SIDECAR_EXT).c_str(), "rb");
+		if (sidecar == NULL) { return false; }
+
+		char magic[sizeof(LINE_INDEX_MAGIC)] = { 0 };
+		unsigned int step = 0;
+		unsigned char stopped = 0;
+		unsigned long lines = 0;
+		long end = 0, length = 0;
+		time_t mtime = 0;
+		size_t count = 0;
+
+		bool val = fread(magic, sizeof(char), sizeof(LINE_INDEX_MAGIC), sidecar) == sizeof(LINE_INDEX_MAGIC) &&
+			!memcmp(magic, LINE_INDEX_MAGIC, sizeof(LINE_INDEX_MAGIC)) &&
+			fread(&step, sizeof(step), 1, sidecar) == 1 && fread(&stopped, sizeof(stopped), 1, sidecar) == 1 &&
+			fread(&lines, sizeof(lines), 1, sidecar) == 1 && fread(&end, sizeof(end), 1, sidecar) == 1 &&
+			fread(&length, sizeof(length), 1, sidecar) == 1 && fread(&mtime, sizeof(mtime), 1, sidecar) == 1 &&
+			fread(&count, sizeof(count), 1, sidecar) == 1 &&
+			step == this->line_index_step && mtime == meta.obj.mtime && length == meta.obj.size && count > 0;
+
+		if (val)
+		{
+			vector<long> offsets(count);
+			val = fread(offsets.data(), sizeof(long), count, sidecar) == count && offsets[0] == 0;
+
+			if (val)
+			{
+				this->line_index_offsets = std::move(offsets);
+				this->line_index_lines = lines;
+				this->line_index_end = end;
+				this->line_index_stopped = stopped != 0;
+				this->line_index_enabled = true;
+			}
+		}
+
+		fclose(sidecar);
+
+		return val;
+	}
+
+	/*
+		Saves the line index into the sidecar file (file path + LINE_INDEX_SIDECAR_EXT).
+		--> The file is flushed first so the saved length and modification time match the index.
+	*/
+	bool FileHandler::saveLineIndex() noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL || !this->line_index_enabled) { return false; }
+
+		this->flushFile();
+
+		retObj<file_meta> meta = this->getFileMeta(true);
+		if (meta.statusObj != ra_succss) { return false; }
+
+		FILE* sidecar = fopen((this->file_path + LINE_INDEX_SIDECAR_EXT).c_str(), "wb");
+		if (sidecar == NULL) { return false; }
+
+		unsigned char stopped = this->line_index_stopped;
+		size_t count = this->line_index_offsets.size();
+
+		bool val = fwrite(LINE_INDEX_MAGIC, sizeof(char), sizeof(LINE_INDEX_MAGIC), sidecar) == sizeof(LINE_INDEX_MAGIC) &&
+			fwrite(&this->line_index_step, sizeof(this->line_index_step), 1, sidecar) == 1 && fwrite(&stopped, sizeof(stopped), 1, sidecar) == 1 &&
+			fwrite(&this->line_index_lines, sizeof(this->line_index_lines), 1, sidecar) == 1 && fwrite(&this->line_index_end, sizeof(this->line_index_end), 1, sidecar) == 1 &&
+			fwrite(&meta.obj.size, sizeof(meta.obj.size), 1, sidecar) == 1 && fwrite(&meta.obj.mtime, sizeof(meta.obj.mtime), 1, sidecar) == 1 &&
+			fwrite(&count, sizeof(count), 1, sidecar) == 1 &&
+			fwrite(this->line_index_offsets.data(), sizeof(long), count, sidecar) == count;
+
+		return !fclose(sidecar) && val;
+	}
+
+	/*
+		Clears the line index, so getting a line scans from the beginning of the file again.
+		--> The sidecar file isn't removed.
+	*/
+	bool FileHandler::clearLineIndex() noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		this->syncWriteBehind();
+
+		this->line_index_enabled = false;
+		this->line_index_sidecar = false;
+		this->line_index_offsets.clear();
+		this->line_index_offsets.shrink_to_fit();
+		this->line_index_lines = 0;
+		this->line_index_end = 0;
+		this->line_index_stopped = false;
+
+		return true;
+	}
+
+	/*
+		The function checks if the line index is used.
+	*/
+	bool FileHandler::hasLineIndex() const noexcept { return this->line_index_enabled; }
+
+	/*
+		The function checks if the file's access type allows reading from it.
+	*/
+	bool FileHandler::canReadFile() const noexcept
+	{
+		return this->file_access == openFileModes::read || this->file_access == openFileModes::read_p ||
+			this->file_access == openFileModes::write_p || this->file_access == openFileModes::append_p ||
+			this->file_access == openFileModes::read_b || this->file_access == openFileModes::read_bp ||
+			this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_bp ||
+			this->file_access == openFileModes::read_m || this->file_access == openFileModes::read_d ||
+			this->file_access == openFileModes::read_z;
+	}
+
+	/*
+		The function checks if the file's access type allows writing into it.
+	*/
+	bool FileHandler::canWriteFile() const noexcept
+	{
+		return this->file_access == openFileModes::write || this->file_access == openFileModes::write_p ||
+			this->file_access == openFileModes::append || this->file_access == openFileModes::append_p ||
+			this->file_access == openFileModes::read_p || this->file_access == openFileModes::write_b ||
+			this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_b ||
+			this->file_access == openFileModes::append_bp || this->file_access == openFileModes::read_bp ||
+			this->file_access == openFileModes::write_d || this->file_access == openFileModes::write_z ||
+			this->file_access == openFileModes::append_z;
+	}
+
+	/*
+		The function maps the whole opened file into the memory.
+		@ An empty file isn't mapped until it grows.
+	*/
+	bool FileHandler::mapFile() noexcept
+	{
+#if defined(FH_POSIX_IO)
+		struct stat file_stat {};
+		if (fstat(fileno(this->file), &file_stat)) { return false; }
+
+		this->map_cursor = 0;
+		this->map_size = (size_t)file_stat.st_size;
+
+		if (this->map_size == 0) { this->map_data = nullptr; return true; }
+
+		void* map_ptr = mmap(nullptr, this->map_size, PROT_READ, MAP_SHARED, fileno(this->file), 0);
+
+		if (map_ptr == MAP_FAILED)
+		{
+			this->map_data = nullptr;
+			this->map_size = 0;
+			return false;
+		}
+
+		this->map_data = (char*)map_ptr;
+		if (this->map_hint != accessHint::normal) { this->adviseMap(this->map_hint); }
+
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/*
+		The function removes the mapping of the file, if exists.
+	*/
+	void FileHandler::unmapFile() noexcept
+	{
+#if defined(FH_POSIX_IO)
+		if (this->map_data != nullptr) { munmap(this->map_data, this->map_size); }
+#endif
+		this->map_data = nullptr;
+		this->map_size = 0;
+		this->map_cursor = 0;
+		this->map_hint = accessHint::normal;
+	}
+
+	/*
+		The function maps the part of the file that was added since the last mapping, if the file grew up to the needed size.
+		--> Views that were returned before the remapping may point to freed memory after it!
+	*/
+	bool FileHandler::remapFile(size_t needed_size) noexcept
+	{
+		if (needed_size <= this->map_size) { return true; }
+
+#if defined(FH_POSIX_IO)
+		struct stat file_stat {};
+		if (fstat(fileno(this->file), &file_stat) || (size_t)file_stat.st_size <= this->map_size) { return false; }
+
+		size_t new_size = (size_t)file_stat.st_size;
+		void* map_ptr = MAP_FAILED;
+
+#if defined(__linux__)
+		if (this->map_data != nullptr)
+		{
+			map_ptr = mremap(this->map_data, this->map_size, new_size, MREMAP_MAYMOVE);
+		}
+		else
+#endif
+		{
+			if (this->map_data != nullptr) { munmap(this->map_data, this->map_size); }
+			map_ptr = mmap(nullptr, new_size, PROT_READ, MAP_SHARED, fileno(this->file), 0);
+		}
+
+		if (map_ptr == MAP_FAILED)
+		{
+			this->map_data = nullptr;
+			this->map_size = 0;
+			return false;
+		}
+
+		this->map_data = (char*)map_ptr;
+		this->map_size = new_size;
+		if (this->map_hint != accessHint::normal) { this->adviseMap(this->map_hint); }
+
+		return needed_size <= this->map_size;
+#else
+		return false;
+#endif
+	}
+
+	/*
+		The function checks that the file wasn't truncated below the mapped size, since touching the mapping past the end of the file raises SIGBUS.
+		@ If it was, the file is mapped again with its new size.
+		--> The file can still be truncated between the check and the access, views that were returned before may point past its end!
+	*/
+	bool FileHandler::checkMapSize() noexcept
+	{
+#if defined(FH_POSIX_IO)
+		if (this->map_data == nullptr) { return true; }
+
+		struct stat file_stat {};
+		FileStats::countSyscall(this->io_counters.get());
+		if (fstat(fileno(this->file), &file_stat)) { return false; }
+		if ((size_t)file_stat.st_size >= this->map_size) { return true; }
+
+		munmap(this->map_data, this->map_size);
+		this->map_data = nullptr;
+		this->map_size = 0;
+
+		return this->remapFile((size_t)file_stat.st_size);
+#else
+		return true;
+#endif
+	}
+
+	/*
+		The function returns a view of the wanted data straight from the mapped file, without copying it.
+		@ If no position is given, the view starts where the last view ended (The mapped views have their own cursor).
+		@ If the end of the file was reached, the returned view is shorter and the status is ra_endoffile_fail.
+		--> Works only in read_m mode. The ignoring table isn't applied on views!
+		--> The view is valid until the file is closed or remapped because of growing or truncating (see read_m).
+	*/
+	retObj<string_view> FileHandler::viewFromFile(const size_t& count, const long& pos) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::view);
+
+		if (this->file == NULL) { return { string_view(), ra_fileisclosed_fail }; }
+		if (this->file_access != openFileModes::read_m) { return { string_view(), ra_fileaccesstype_fail }; }
+		if (!this->checkMapSize()) { return { string_view(), ra_readfile_fail }; }
+
+		this->last_move = READ_OP;
+
+		size_t start = (pos >= 0) ? (size_t)pos : this->map_cursor;
+
+		if (start + count > this->map_size) { this->remapFile(start + count); }
+		if (start >= this->map_size) { return { string_view(), (count > 0) ? ra_endoffile_fail : ra_succss }; }
+
+		size_t len = std::min(count, this->map_size - start);
+		if (pos < 0) { this->map_cursor = start + len; }
+		FileStats::countRead(this->io_counters.get(), len);
+
+		return { string_view(this->map_data + start, len), (len < count) ? ra_endoffile_fail : ra_succss };
+	}
+
+	/*
+		The function returns a view of the wanted line straight from the mapped file, without copying it.
+		@ Like getLine, the line ends on '\n', '\0' or the end of the file, and counting starts at the given position (or the beginning of the file).
+		@ Only the '\r' at the end of the line is removed, since a view can't skip data.
+		--> Works only in read_m mode. The ignoring table isn't applied on views!
+		--> The view is valid until the file is closed or remapped because of growing or truncating (see read_m).
+	*/
+	retObj<string_view> FileHandler::getLineView(unsigned int numline, const long& pos) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::view);
+
+		if (this->file == NULL) { return { string_view(), ra_fileisclosed_fail }; }
+		if (this->file_access != openFileModes::read_m) { return { string_view(), ra_fileaccesstype_fail }; }
+		if (!this->checkMapSize()) { return { string_view(), ra_readfile_fail }; }
+
+		this->last_move = READ_OP;
+
+		size_t curr = 0;
+
+		if (pos >= 0)
+		{
+			curr = (size_t)pos;
+		}
+		else if (this->line_index_enabled)
+		{
+			curr = (size_t)this->seekLineIndex(numline);
+		}
+
+		auto find_newline = [&](size_t from, size_t& found) -> bool
+		{
+			while (true)
+			{
+				if (from < this->map_size)
+				{
+					const void* place = memchr(this->map_data + from, '\n', this->map_size - from);
+					if (place != nullptr) { found = (const char*)place - this->map_data; return true; }
+				}
+
+				found = this->map_size;
+				if (!this->remapFile(this->map_size + 1)) { return false; }
+			}
+		};
+
+		auto has_null = [&](size_t from, size_t to) -> bool { return to > from && memchr(this->map_data + from, '\0', to - from) != nullptr; };
+
+		size_t line_end = 0;
+
+		for (; numline > 0; numline--)
+		{
+			if (!find_newline(curr, line_end) || has_null(curr, line_end)) { return { string_view(), ra_endoffile_fail }; }
+
+			curr = line_end + 1;
+		}
+
+		if (curr >= this->map_size && !this->remapFile(curr + 1)) { return { string_view(), ra_succss }; }
+
+		find_newline(curr, line_end);
+
+		const void* null_place = (line_end > curr) ? memchr(this->map_data + curr, '\0', line_end - curr) : nullptr;
+		if (null_place != nullptr) { line_end = (const char*)null_place - this->map_data; }
+		if (line_end > curr && this->map_data[line_end - 1] == '\r') { line_end--; }
+		FileStats::countRead(this->io_counters.get(), line_end - curr);
+
+		return { string_view(this->map_data + curr, line_end - curr), ra_succss };
+	}
+
+	/*
+		The function tells the system how the mapped file is going to be accessed.
+		--> The hint is kept when the file is remapped.
+	*/
+	bool FileHandler::adviseMap(const accessHint& hint) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL || this->file_access != openFileModes::read_m) { return false; }
+
+		this->map_hint = hint;
+		if (this->map_data == nullptr) { return true; }
+
+#if defined(FH_POSIX_IO)
+		int advice = MADV_NORMAL;
+
+		switch (hint)
+		{
+		case accessHint::sequential:
+		case accessHint::once: { advice = MADV_SEQUENTIAL; break; }
+		case accessHint::random: { advice = MADV_RANDOM; break; }
+		case accessHint::willneed: { advice = MADV_WILLNEED; break; }
+		case accessHint::dontneed: { advice = MADV_DONTNEED; break; }
+		default:
+			advice = MADV_NORMAL;
+		}
+
+		return !madvise(this->map_data, this->map_size, advice);
+#else
+		return false;
+#endif
+	}
+
+	/*
+		The function checks if the file is opened and mapped into the memory.
+	*/
+	bool FileHandler::isFileMapped() const noexcept { return this->file != NULL && this->file_access == openFileModes::read_m; }
+
+	/*
+		The function checks if the file is read and written around the page cache (a direct mode that the file system supports).
+	*/
+	bool FileHandler::isDirectIO() const noexcept { return this->file != NULL && this->direct_fd >= 0; }
+
+	/*
+		Sets how the next files opened in the compressed modes are compressed (the codec, its level and if it works on a background thread).
+		@ With background the written data is compressed on a thread of the stream, and the read data is decompressed ahead of the reads,
+			so the codec overlaps with the caller.
+		--> The file that is already opened isn't changed!
+	*/
+	bool FileHandler::setCompression(const codec_options& options) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (options.type != codecType::detect && !FileCodec::isAvailable(options.type)) { return false; }
+
+		this->codec_settings = options;
+		return true;
+	}
+
+	/*
+		The function checks if the file was opened in a compressed mode.
+	*/
+	bool FileHandler::isCompressed() const noexcept { return this->file != NULL && this->codec != nullptr; }
+
+	/*
+		The function tells the system how the file is going to be read, so it can read ahead (or not) by it.
+		@ offset, length - The part of the file the hint is for, a length of 0 means until the end of the file.
+		@ willneed starts reading the part into the memory right away, and a mapped file is advised too.
+		@ With the adaptive buffer, sequential and once grow the buffer to MAX_ADAPTIVE_BUFFER_SIZE and random
+			shrinks it back to the block size of the file.
+	*/
+	bool FileHandler::setAccessHint(const accessHint& hint, long offset, long length) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL || offset < 0 || length < 0) { return false; }
+
+		this->access_hint = hint;
+		bool val = true;
+
+#if defined(FH_POSIX_IO) && defined(POSIX_FADV_NORMAL)
+		int advice = POSIX_FADV_NORMAL;
+
+		switch (hint)
+		{
+		case accessHint::sequential: { advice = POSIX_FADV_SEQUENTIAL; break; }
+		case accessHint::random: { advice = POSIX_FADV_RANDOM; break; }
+		case accessHint::willneed: { advice = POSIX_FADV_WILLNEED; break; }
+		case accessHint::dontneed: { advice = POSIX_FADV_DONTNEED; break; }
+		case accessHint::once: { advice = POSIX_FADV_NOREUSE; break; }
+		default:
+			advice = POSIX_FADV_NORMAL;
+		}
+
+		const int fd = this->getFileFd();
+		val = !posix_fadvise(fd, (off_t)offset, (off_t)length, advice);
+
+		if (hint == accessHint::once) { posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_SEQUENTIAL); } // NOREUSE alone doesn't read ahead
+#else
+		val = false;
+#endif
+
+		if (this->file_access == openFileModes::read_m) { val = this->adviseMap(hint) && val; }
+
+		if (this->adaptive_buffer && this->buffer_type != bufferType::non_buffer)
+		{
+			if ((hint == accessHint::sequential || hint == accessHint::once) && this->file_buffer_size < MAX_ADAPTIVE_BUFFER_SIZE)
+			{
+				val = this->resizeFileBuffer(this->buffer_type, MAX_ADAPTIVE_BUFFER_SIZE) && val;
+			}
+			else if (hint == accessHint::random && this->file_buffer_size > this->adaptive_base_size)
+			{
+				val = this->resizeFileBuffer(this->buffer_type, this->adaptive_base_size) && val;
+			}
+		}
+
+		return val;
+	}
+
+	/*
+		The function returns the last access hint that was given.
+	*/
+	accessHint FileHandler::getAccessHint() const noexcept { return this->access_hint; }
+
+	/*
+		The function turns the adaptive buffer on or off.
+		@ The buffer starts at the block size of the file, grows (up to MAX_ADAPTIVE_BUFFER_SIZE) while the reads
+			are sequential, and shrinks back to the block size when they become random.
+		--> Turning it off keeps the current buffer, changeFileBuffer sets a fixed one.
+	*/
+	bool FileHandler::setAdaptiveBuffer(const bool& enable) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file == NULL) { return false; }
+
+		this->adaptive_buffer = enable;
+		if (!enable) { return true; }
+
+		this->syncWriteBehind();
+
+		size_t block_size = DEFUALT_BUFFER_SIZE;
+
+#if defined(FH_POSIX_IO)
+		struct stat file_stat;
+		if (!fstat(this->getFileFd(), &file_stat) && file_stat.st_blksize > 0) { block_size = (size_t)file_stat.st_blksize; }
+#endif
+
+		this->adaptive_base_size = std::clamp(block_size, (size_t)MIN_BUFFER_SIZE, (size_t)MAX_ADAPTIVE_BUFFER_SIZE);
+		this->adaptive_seq_streak = 0;
+		this->adaptive_rand_streak = 0;
+		this->adaptive_next_pos = ftell(this->file);
+
+		const bufferType buff_type = this->buffer_type == bufferType::non_buffer ? bufferType::full_buffer : this->buffer_type;
+		const bool sequential = this->access_hint == accessHint::sequential || this->access_hint == accessHint::once;
+
+		return this->resizeFileBuffer(buff_type, sequential ? MAX_ADAPTIVE_BUFFER_SIZE : this->adaptive_base_size);
+	}
+
+	/*
+		The function checks if the adaptive buffer is on.
+	*/
+	bool FileHandler::isAdaptiveBuffer() const noexcept { return this->adaptive_buffer; }
+
+	/*
+		The function follows the reads through the buffer of the file, for the adaptive buffer.
+		@ After ADAPTIVE_BUFFER_STREAK reads in a row that continue each other the buffer grows 4 times (up to
+			MAX_ADAPTIVE_BUFFER_SIZE), and after ADAPTIVE_BUFFER_STREAK reads in a row that jump it is shrunk to the block size.
+	*/
+	void FileHandler::trackAccess(long start, long end) noexcept
+	{
+		if (!this->adaptive_buffer || start < 0 || end < 0) { return; }
+
+		if (start == this->adaptive_next_pos) { this->adaptive_seq_streak++; this->adaptive_rand_streak = 0; }
+		else { this->adaptive_rand_streak++; this->adaptive_seq_streak = 0; }
+
+		this->adaptive_next_pos = end;
+
+		if (this->adaptive_seq_streak >= ADAPTIVE_BUFFER_STREAK && this->file_buffer_size < MAX_ADAPTIVE_BUFFER_SIZE)
+		{
+			this->adaptive_seq_streak = 0;
+			this->resizeFileBuffer(this->buffer_type, std::min((size_t)this->file_buffer_size * 4, (size_t)MAX_ADAPTIVE_BUFFER_SIZE));
+		}
+		else if (this->adaptive_rand_streak >= ADAPTIVE_BUFFER_STREAK && this->file_buffer_size > this->adaptive_base_size)
+		{
+			this->adaptive_rand_streak = 0;
+			this->resizeFileBuffer(this->buffer_type, this->adaptive_base_size);
+		}
+	}
+
+
+	/*
+		The function reads count bytes from the given position of the file into the buffer, without waiting for it.
+		@ The callback gets the amount of bytes read, it is called from the thread of the async engine so it should be short.
+		@ Like pread, less bytes than asked may be read, end_of_file is set if the read ended before count bytes.
+		--> The buffer must live until the callback is called, and ignoring isn't applied to the read bytes!
+	*/
+	bool FileHandler::readAsync(char* buffer, const size_t& count, const long& pos, function<void(retObj<read_result>)>&& callback) noexcept
+	{
+		FileHandlerLock lock(*this, false);
+		FileStatsTimer timer(this->io_counters.get(), statCall::read_async);
+
+		if (buffer == nullptr || pos < 0 || !callback || this->prepareFdAccess(false) != ra_succss) { return false; }
+
+#if defined(FH_POSIX_IO)
+		const size_t asked = std::min(count, (size_t)MAX_ASYNC_REQUEST_SIZE);
+
+		return FileAsyncEngine::getSharedEngine().submit({ asyncOp::read, fileno(this->file), buffer, asked, pos,
+			[asked, stats = this->io_counters, callback = std::move(callback)](long result)
+			{
+				if (result < 0) { callback({ { 0, false }, ra_readfile_fail }); return; }
+				FileStats::countRead(stats.get(), (size_t)result);
+				callback({ { (size_t)result, (size_t)result < asked }, ra_succss });
+			}, nullptr });
+#else
+		return false;
+#endif
+	}
+
+	/*
+		The function reads count bytes from the given position of the file into the buffer, without waiting for it.
+		@ Returns a future of the read's result, like the callback version.
+		--> The buffer must live until the future is ready!
+	*/
+	future<retObj<read_result>> FileHandler::readAsync(char* buffer, const size_t& count, const long& pos) noexcept
+	{
+		FileHandlerLock lock(*this, false);
+
+		auto result = std::make_shared<promise<retObj<read_result>>>();
+		future<retObj<read_result>> ready = result->get_future();
+
+		returnAns status = ra_succss;
+		if (this->file == NULL) { status = ra_fileisclosed_fail; }
+		else if (!this->canReadFile()) { status = ra_fileaccesstype_fail; }
+		else if (buffer == nullptr || pos < 0) { status = ra_outofrange_fail; }
+
+		if (status != ra_succss || !this->readAsync(buffer, count, pos, [result](retObj<read_result> read_data) { result->set_value(read_data); }))
+		{
+			result->set_value({ { 0, false }, status != ra_succss ? status : ra_unknown_fail });
+		}
+
+		return ready;
+	}
+
+	/*
+		The function reads all the slices of the file together, and submits them to the async engine at once.
+		@ Returns a future for every slice, in the same order.
+		--> The buffers must live until the futures are ready!
+	*/
+	vector<future<retObj<read_result>>> FileHandler::readAsync(const vector<async_slice>& slices) noexcept
+	{
+		FileHandlerLock lock(*this, false);
+		FileStatsTimer timer(this->io_counters.get(), statCall::read_async);
+
+		vector<future<retObj<read_result>>> ready;
+
+		try
+		{
+			ready.reserve(slices.size());
+			vector<std::shared_ptr<promise<retObj<read_result>>>> results;
+			results.reserve(slices.size());
+
+			for (size_t i = 0; i < slices.size(); i++)
+			{
+				results.push_back(std::make_shared<promise<retObj<read_result>>>());
+				ready.push_back(results.back()->get_future());
+			}
+
+			returnAns status = this->prepareFdAccess(false);
+
+#if defined(FH_POSIX_IO)
+			vector<async_request> requests;
+			requests.reserve(slices.size());
+
+			for (size_t i = 0; i < slices.size() && status == ra_succss; i++)
+			{
+				if (slices[i].buffer == nullptr || slices[i].pos < 0) { results[i]->set_value({ { 0, false }, ra_outofrange_fail }); continue; }
+
+				const size_t asked = std::min(slices[i].count, (size_t)MAX_ASYNC_REQUEST_SIZE);
+
+				requests.push_back({ asyncOp::read, fileno(this->file), slices[i].buffer, asked, slices[i].pos,
+					[asked, stats = this->io_counters, result = results[i]](long read_count)
+					{
+						if (read_count < 0) { result->set_value({ { 0, false }, ra_readfile_fail }); return; }
+						FileStats::countRead(stats.get(), (size_t)read_count);
+						result->set_value({ { (size_t)read_count, (size_t)read_count < asked }, ra_succss });
+					}, nullptr });
+			}
+
+			if (status == ra_succss && !requests.empty())
+			{
+				const size_t taken = FileAsyncEngine::getSharedEngine().submit(requests.data(), requests.size());
+
+				for (size_t i = taken; i < requests.size(); i++) { requests[i].callback(-ECANCELED); } // The requests that weren't taken still have their callbacks
+			}
+#else
+			status = ra_unknown_fail;
+#endif
+
+			if (status != ra_succss)
+			{
+				for (size_t i = 0; i < slices.size(); i++) { results[i]->set_value({ { 0, false }, status }); }
+			}
+		}
+		catch (...) {}
+
+		return ready;
+	}
+
+	/*
+		The function writes count bytes into the file, without waiting for it.
+		@ If no position is given, the data is written at the cursor of the file (or at the end of an append file).
+		@ The cursor of the file isn't moved, and the line index is updated when the write is submitted.
+		@ The callback gets the amount of bytes written, it is called from the thread of the async engine so it should be short.
+		--> The data must live until the callback is called, and ignoring isn't applied to it!
+	*/
+	bool FileHandler::writeAsync(const char* data, const size_t& count, const long& pos, function<void(retObj<size_t>)>&& callback) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::write_async);
+
+		if (data == nullptr || !callback || this->prepareFdAccess(true) != ra_succss) { return false; }
+
+#if defined(FH_POSIX_IO)
+		const bool append = this->file_access == openFileModes::append || this->file_access == openFileModes::append_p ||
+			this->file_access == openFileModes::append_b || this->file_access == openFileModes::append_bp;
+		long offset = pos;
+
+		if (append) { offset = NON_WORK; } // The system puts every write of an append file at its end
+		else if (offset < 0 && (offset = ftell(this->file)) < 0) { return false; }
+
+		const size_t asked = std::min(count, (size_t)MAX_ASYNC_REQUEST_SIZE);
+
+		if (this->line_index_enabled)
+		{
+			if (offset < 0) { this->clearLineIndex(); } // The place of an appended write is known only after it is done
+			else { this->updateLineIndex(data, asked, offset); }
+		}
+
+		this->meta_dirty = true; // The write is done later, so the metadata is checked again after it
+		this->scan_valid = false;
+
+		return FileAsyncEngine::getSharedEngine().submit({ asyncOp::write, fileno(this->file), (char*)data, asked, offset,
+			[stats = this->io_counters, callback = std::move(callback)](long result)
+			{
+				if (result < 0) { callback({ 0, ra_writefile_fail }); return; }
+				FileStats::countWrite(stats.get(), (size_t)result);
+				callback({ (size_t)result, ra_succss });
+			}, nullptr });
+#else
+		return false;
+#endif
+	}
+
+	/*
+		The function writes count bytes into the file, without waiting for it.
+		@ Returns a future of the amount of bytes written, like the callback version.
+		--> The data must live until the future is ready!
+	*/
+	future<retObj<size_t>> FileHandler::writeAsync(const char* data, const size_t& count, const long& pos) noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		auto result = std::make_shared<promise<retObj<size_t>>>();
+		future<retObj<size_t>> ready = result->get_future();
+
+		returnAns status = ra_succss;
+		if (this->file == NULL) { status = ra_fileisclosed_fail; }
+		else if (!this->canWriteFile()) { status = ra_fileaccesstype_fail; }
+		else if (data == nullptr) { status = ra_outofrange_fail; }
+
+		if (status != ra_succss || !this->writeAsync(data, count, pos, [result](retObj<size_t> write_data) { result->set_value(write_data); }))
+		{
+			result->set_value({ 0, status != ra_succss ? status : ra_unknown_fail });
+		}
+
+		return ready;
+	}
+
+	/*
+		The state of a line that is read asynchronously, it moves from one read to the next.
+	*/
+	typedef struct async_line_state
+	{
+		int fd;
+		long offset;
+		unsigned int skip_lines;
+		bool use_filter;
+		char_filter filter;
+		vector<char> chunk;
+		string line_data;
+		promise<retObj<string>> result;
+	} async_line_state;
+
+	/*
+		The function submits the next read of an asynchronous line, and scans the read data when it is done.
+	*/
+	static void _readLineChunk(const std::shared_ptr<async_line_state>& state) noexcept
+	{
+		auto finish = [](async_line_state& line_state, const returnAns& status)
+		{
+			if (status == ra_succss && line_state.use_filter)
+			{
+				line_state.line_data.resize(FileScanner::filterBytes(line_state.line_data.data(), line_state.line_data.data(), line_state.line_data.size(), line_state.filter));
+			}
+
+			line_state.result.set_value({ status == ra_succss ? std::move(line_state.line_data) : string(), status });
+		};
+
+		bool submitted = FileAsyncEngine::getSharedEngine().submit({ asyncOp::read, state->fd, state->chunk.data(), state->chunk.size(), state->offset,
+			[state, finish](long read_count)
+			{
+				if (read_count < 0) { finish(*state, ra_readfile_fail); return; }
+				if (read_count == 0) { finish(*state, state->skip_lines == 0 ? ra_succss : ra_endoffile_fail); return; } // Like getLine, the last line ends at the end of the file
+
+				const char* data = state->chunk.data();
+
+				for (size_t i = 0; i < (size_t)read_count;)
+				{
+					size_t stop = i + FileScanner::findLineStop(data + i, (size_t)read_count - i);
+
+					if (state->skip_lines == 0) { state->line_data.append(data + i, stop - i); }
+					if (stop == (size_t)read_count) { break; }
+
+					const char ch = data[stop];
+					i = stop + 1;
+
+					if (ch == '\0') { finish(*state, state->skip_lines == 0 ? ra_succss : ra_endoffile_fail); return; }
+
+					if (ch == '\n')
+					{
+						if (state->skip_lines == 0) { finish(*state, ra_succss); return; }
+						state->skip_lines--;
+					}
+				}
+
+				state->offset += read_count;
+
+				try { if (state->chunk.size() < LINE_INDEX_READ_CHUNK) { state->chunk.resize(state->chunk.size() * 2); } }
+				catch (...) {}
+
+				_readLineChunk(state);
+			}, nullptr });
+
+		if (!submitted) { finish(*state, ra_unknown_fail); }
+	}
+
+	/*
+		The function gets a line out of the file without waiting for it, by its number and start position like in getLine.
+		@ Without a start position the line index is used if there is one, else the line is counted from the beginning of the file.
+		@ The file is read in growing chunks, one asynchronous read after the other until the line ends.
+		--> The object must stay opened until the future is ready!
+	*/
+	future<retObj<string>> FileHandler::readLineAsync(unsigned int numline, const long& pos) noexcept
+	{
+		FileHandlerLock lock(*this);
+		FileStatsTimer timer(this->io_counters.get(), statCall::read_line_async);
+
+		std::shared_ptr<async_line_state> state;
+
+		try { state = std::make_shared<async_line_state>(); }
+		catch (...)
+		{
+			promise<retObj<string>> failed;
+			failed.set_value({ "", ra_unknown_fail });
+			return failed.get_future();
+		}
+
+		future<retObj<string>> ready = state->result.get_future();
+
+		returnAns status = this->prepareFdAccess(false);
+		if (status != ra_succss) { state->result.set_value({ "", status }); return ready; }
+
+#if defined(FH_POSIX_IO)
+		long start = 0;
+
+		if (pos >= 0) { start = pos; }
+		else if (this->line_index_enabled) { start = this->seekLineIndex(numline); }
+
+		state->fd = fileno(this->file);
+		state->offset = start;
+		state->skip_lines = numline;
+		state->use_filter = !this->clearCharsCanUse;
+		if (state->use_filter) { state->filter = this->getCharFilter(); }
+
+		try { state->chunk.resize(LINE_SCAN_FIRST_CHUNK); }
+		catch (...) { state->result.set_value({ "", ra_unknown_fail }); return ready; }
+
+		_readLineChunk(state);
+#endif
+
+		return ready;
+	}
+
+	//pair<bool, char> FileHandler::operator[](const int index)
+	//{
+	//	return pair<bool, char>();
+	//}
+	//
+	//pair<bool, string> FileHandler::substr(const int index, const int len)
+	//{
+	//	return pair<bool, string>();
+	//}
+
+	/*
+		The function rewinds the file one step by the cursor.
+		--> This function is slow and should'nt be used a lot!
+	*/
+	bool FileHandler::rewindFileOneStep() noexcept
+	{
+		FileHandlerLock lock(*this);
+
+		if (this->file != NULL)
+		{
+			this->syncWriteBehind();
+			return !this->seekFile(this->last_file_place, SEEK_SET);
+		}
+
+		return false;
+	}
+
+	/*
+		The function checks if the cursor at the end of the file.
+	*/
+	bool FileHandler::isEndOfFile() const noexcept { if (file != NULL) { return feof(this->file); } return false; }
+
+	/*
+		The function checks if the file is opened.
+	*/
+	bool FileHandler::isFileOpened() const noexcept { return file != NULL; }
+
+	bool FileHandler::isThreadSafe() const noexcept
+	{
+		return this->thread_safe;
+	}
+
+	/*
+		The function returns the counters of the lock of the thread safe mode.
+		@ Many waits compared to the amount of locks means the threads fight over the object, and positional
+			readers (readAt, readAsync) should be used since they share the lock.
+	*/
+	lock_stats FileHandler::getLockStats() const noexcept
+	{
+		return { this->lock_shared_count.load(std::memory_order_relaxed), this->lock_exclusive_count.load(std::memory_order_relaxed),
+			this->lock_shared_waits.load(std::memory_order_relaxed), this->lock_exclusive_waits.load(std::memory_order_relaxed),
+			this->lock_wait_ns.load(std::memory_order_relaxed) };
+	}
+
+	/*
+		The function resets the counters of the lock of the thread safe mode.
+	*/
+	void FileHandler::resetLockStats() noexcept
+	{
+		this->lock_shared_count = 0;
+		this->lock_exclusive_count = 0;
+		this->lock_shared_waits = 0;
+		this->lock_exclusive_waits = 0;
+		this->lock_wait_ns = 0;
+	}
+
+	/*
+		The function returns the I/O counters of the handler: bytes, calls, seeks, flushes, system calls, lock waits and latencies.
+		@ The counters are kept from the first opened file, closing the file (or opening another) doesn't reset them.
+	*/
+	io_stats FileHandler::getIOStats() const noexcept
+	{
+		io_stats stats = io_stats();
+		if (this->io_counters != nullptr) { stats = this->io_counters->snapshot(); }
+		stats.lock_waits = this->lock_shared_waits.load(std::memory_order_relaxed) + this->lock_exclusive_waits.load(std::memory_order_relaxed);
+		stats.lock_wait_ns = this->lock_wait_ns.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	/*
+		The function resets the I/O counters of the handler (and the counters of its lock).
+	*/
+	void FileHandler::resetIOStats() noexcept
+	{
+		if (this->io_counters != nullptr) { this->io_counters->reset(); }
+		this->resetLockStats();
+	}
+
+	/*
+		The function returns the I/O counters of all the handlers of the process together.
+		@ It is a static function.
+	*/
+	io_stats FileHandler::getGlobalIOStats() noexcept
+	{
+		return FileStats::getGlobalStats();
+	}
+
+	/*
+		The function resets the I/O counters of all the handlers of the process.
+		@ It is a static function.
+	*/
+	void FileHandler::resetGlobalIOStats() noexcept
+	{
+		FileStats::resetGlobalStats();
+	}
+
+	/*
+		The function sets the observer that gets the operations of the handler (open, read, write, seek, flush, lock waits and worker tasks).
+		@ nullptr stops the tracing, a new handler gets the global observer (see FileObserver::setGlobalObserver).
+		--> The observer must live as long as the handler uses it!
+	*/
+	void FileHandler::setObserver(FileObserver* observer) noexcept
+	{
+		FileHandlerLock lock(*this);
+		this->observer = observer;
+	}
+
+	/*
+		The function returns the observer of the handler, or nullptr if nothing traces it.
+	*/
+	FileObserver* FileHandler::getObserver() const noexcept
+	{
+		return this->getTracer();
+	}
+
+	/*
+		The function checks if the file exists.
+		@ On POSIX it is one stat, without opening the file (errno tells why a file wasn't found).
 	*/
-	retObj<string> FileHandler::getLine(unsigned int numline, const int& pos, unsigned int buff_size, const bool& auto_rewind, const bool& flush_file) noexcept
+	bool FileHandler::fileExists(const std::string& f_path) noexcept
 	{
-		if (this->file != NULL)
+#if defined(FH_POSIX_IO)
+		struct stat file_stat;
+		return stat(f_path.c_str(), &file_stat) == 0 && !S_ISDIR(file_stat.st_mode);
+#else
+		FILE* fl = NULL;
+		if ((fl = fopen(f_path.c_str(), "rb")) != NULL)
 		{
-			if (this->file_access == openFileModes::read || this->file_access == openFileModes::read_p ||
-				this->file_access == openFileModes::write_p || this->file_access == openFileModes::append_p ||
-				this->file_access == openFileModes::read_b || this->file_access == openFileModes::read_bp ||
-				this->file_access == openFileModes::write_bp || this->file_access == openFileModes::append_bp)
-			{
-				this->last_move = READ_OP;
-
-				if (flush_file && this->buffer_type != bufferType::non_buffer) { fflush(this->file); }
-
-				if (buff_size < MIN_BUFFER_GETLINE_SIZE || buff_size > MAX_BUFFER_GETLINE_SIZE) { buff_size = DFLT_BUFF_GLINE_SIZE; }
-
-				if (pos >= 0)
-				{
-					this->moveCursorInFile(filePosSet::start_file, pos);
-				}
-				else
-				{
-					this->moveCursorInFile(filePosSet::start_file);
-				}
-
-				if (feof(this->file)) { return { "", ra_succss }; }
-
-				char tmp = 0;
-				char* data = new char[buff_size + 1]();
-				unsigned int ccount = 0, buffcount = 1;
+			fclose(fl); return true;
+		}
 
-				while (!feof(this->file))
-				{
-					tmp = fgetc(this->file);
-					if (tmp == EOF || tmp == '\0' || (numline <= 0 && tmp == '\n')) break;
-					if (tmp == '\n') numline--;
-					if (tmp == '\r') continue;
-					if (numline <= 0 && tmp != '\n') data[ccount++] = tmp;
-					if (ccount > buff_size * buffcount)
-					{
-						char* ndata = new char[buff_size * (++buffcount) + 1]();
-						memcpy(ndata, data, buff_size * (buffcount - 1) + 1);
-						delete data;
-						data = ndata;
-					}
-				}
+		return false;
+#endif
+	}
 
-				this->rewindFileOneStep();
+	/*
+		The last lock the current thread took, every lock points to the one taken before it.
+	*/
+	static thread_local const FileHandlerLock* _held_locks = nullptr;
 
-				if ((tmp == EOF || tmp == '\0') && numline > 0)  return { "", ra_endoffile_fail };
+	/*
+		The function takes the lock of the handler if it is in the thread safe mode, and the thread doesn't hold it already.
+		@ It tries to take the lock first, and only if it is taken by others it counts the wait and its time.
+		@ Asking for the lock alone while holding only its shared part is a bug of the caller, it is asserted in debug builds.
+	*/
+	FileHandlerLock::FileHandlerLock(FileHandler& handler, const bool exclusive) noexcept : handler(&handler), outer(_held_locks), locked(false), exclusive(exclusive)
+	{
+		if (!handler.thread_safe) { return; }
 
-				if (!this->clearCharsCanUse)
-				{
-					char* ndata = new char[ccount + 1]();
+		for (const FileHandlerLock* held = _held_locks; held != nullptr; held = held->outer)
+		{
+			if (held->handler != &handler) { continue; }
 
-					for (unsigned int i = 0, j = 0; i < ccount; i++)
-					{
-						const char ch = data[i];
-						if (this->charsCanUse[(int)ch])
-						{
-							ndata[j] = ch;
-							j++;
-						}
-					}
+			assert(held->exclusive || !exclusive); // The shared lock can't be upgraded
+			return;
+		}
 
-					delete data;
-					data = ndata;
-				}
+		if (exclusive ? !handler.handler_mutex.try_lock() : !handler.handler_mutex.try_lock_shared())
+		{
+			auto wait_start = std::chrono::steady_clock::now();
 
-				string str = data;
-				delete data;
-				data = nullptr;
+			{
+				FileTraceScope trace(handler.getTracer(), traceOp::lock, nullptr); // The path may be changed by the thread that has the lock
 
-				return { str, ra_succss };
+				if (exclusive) { handler.handler_mutex.lock(); }
+				else { handler.handler_mutex.lock_shared(); }
 			}
+
+			auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wait_start);
+			(exclusive ? handler.lock_exclusive_waits : handler.lock_shared_waits).fetch_add(1, std::memory_order_relaxed);
+			handler.lock_wait_ns.fetch_add((unsigned long long)waited.count(), std::memory_order_relaxed);
+			FileStats::countLockWait(handler.io_counters.get(), (unsigned long long)waited.count());
 		}
 
-		return { "", ra_fileisclosed_fail };
+		(exclusive ? handler.lock_exclusive_count : handler.lock_shared_count).fetch_add(1, std::memory_order_relaxed);
+
+		this->locked = true;
+		_held_locks = this;
 	}
 
 	/*
-		The function gets  out of a file.
-		@ This file returns error if during the getting line, the file met \0 of EOF operators and the wanted line wasn't reached yet.
+		The function releases the lock if it was taken.
 	*/
-	void FileHandler::getLineMultiThreaded(retObj<map<pair<unsigned int, int>, retObj<string>>>& retObject, const vector<pair<unsigned int, int>>& lines_pos, unsigned int buff_size, const bool& auto_rewind, const bool& flush_file)
+	FileHandlerLock::~FileHandlerLock()
 	{
-		if (this->file != NULL)
-		{
-			if (!this->thread_safe) { retObject = { {}, ra_notthreadsafe_fail }; return; }
-			if (lines_pos.size() <= 0) { retObject = { {}, ra_succss }; return; }
-			
-			future<retObj<string>>* ftr = new future<retObj<string>>[lines_pos.size()];
-			thread** thds = new thread*[lines_pos.size()];
-
-			for (int i = 0; i < lines_pos.size(); i++)
-			{
-				promise<retObj<string>> p;
-				ftr[i] = p.get_future();
-				thds[i] = new thread(&FileHandler::getLineWithPromise, this, std::move(p), lines_pos[i].first, lines_pos[i].second, buff_size, std::cref(auto_rewind), std::cref(flush_file));
-			}
+		if (!this->locked) { return; }
 
-			for (int i = 0; i < lines_pos.size(); i++)
-			{
-				retObject.obj.insert(pair<pair<unsigned int, int>, retObj<string>>(pair<unsigned int, int>(lines_pos[i].first, lines_pos[i].second), ftr[i].get()));
-			}
+		_held_locks = this->outer;
 
-			for (int i = 0; i < lines_pos.size(); i++)
-			{
-				thds[i]->join();
-				delete thds[i];
-				thds[i] = nullptr;
-			}
+		if (this->exclusive) { this->handler->handler_mutex.unlock(); }
+		else { this->handler->handler_mutex.unlock_shared(); }
+	}
 
-			delete[] ftr;
-			delete[] thds;
+	/*
+		The function constructs a line reader that starts at the given position of the file (or at its cursor if pos is NON_WORK).
+	*/
+	FileLineReader::FileLineReader(FileHandler& handler, const long& pos) noexcept : handler(&handler), data_begin(0), data_end(0), ended(false), status(ra_succss)
+	{
+		FileHandlerLock lock(handler);
 
-			ftr = nullptr;
-			thds = nullptr;
+		if (handler.file == NULL) { this->handler = nullptr; this->status = ra_fileisclosed_fail; return; }
+		if (!handler.canReadFile()) { this->handler = nullptr; this->status = ra_fileaccesstype_fail; return; }
 
-			retObject.statusObj = ra_succss;
+		handler.last_move = READ_OP;
+		handler.syncWriteBehind();
 
-			return;
-		}
+		if (pos >= 0) { handler.moveCursorInFile(filePosSet::start_file, pos); }
+		if (!handler.clearCharsCanUse) { handler.getCharFilter(); }
 
-		retObject = { {},  ra_fileisclosed_fail };
+		this->buffer.resize(LINE_INDEX_READ_CHUNK);
 	}
 
 	/*
-		The function is closing a file and the buffer if opened.
-	*/
-	bool FileHandler::closeFile() noexcept { if (this->file_buffer != NULL) { delete[] this->file_buffer; this->file_buffer = NULL; this->file_buffer_size = 0; } file_path = "";  file_name = ""; extension = ""; thread_safe = false; if (this->file != NULL) { fclose(this->file); this->file = NULL; return true; } return false; }
-
-	/*
-		The function deletes the function from the computer.
+		The function moves the reader, the moved reader stops reading.
 	*/
-	bool FileHandler::removeFile() noexcept { closeFile(); return !remove(this->file_path.c_str()); }
+	FileLineReader::FileLineReader(FileLineReader&& other) noexcept : handler(other.handler), buffer(std::move(other.buffer)), data_begin(other.data_begin),
+		data_end(other.data_end), ended(other.ended), line(other.line), status(other.status)
+	{
+		other.handler = nullptr;
+	}
 
 	/*
-		The function flushed the buffer if existst and if in writing mode, else just return true.
+		The function gives back to the file the data that was read but not used, so the cursor is right after the last line given.
 	*/
-	bool FileHandler::flushFile() noexcept
+	FileLineReader::~FileLineReader()
 	{
-		if (this->buffer_type == bufferType::non_buffer) { return true; }
-
-		if (this->file != NULL && (this->file_access == openFileModes::write || this->file_access == openFileModes::write_b ||
-			this->file_access == openFileModes::append || this->file_access == openFileModes::append_b || this->last_move == WRITE_OP))
+		if (this->handler != nullptr && this->handler->file != NULL && this->data_end > this->data_begin)
 		{
-			return !fflush(this->file);
+			FileHandlerLock lock(*this->handler);
+			this->handler->seekFile(-(long)(this->data_end - this->data_begin), SEEK_CUR);
 		}
-
-		return false;
 	}
 
 	/*
-		The function changes the file buffer type and size.
+		The function reads the next line of the file.
+		@ Returns false when there are no more lines.
 	*/
-	bool FileHandler::changeFileBuffer(const bufferType& buff_type, size_t buff_size) noexcept
+	bool FileLineReader::next() noexcept
 	{
-		if (file != NULL)
+		if (this->handler == nullptr) { return false; }
+
+		FileHandlerLock lock(*this->handler); // Every line is taken alone, so other threads can use the file between the lines
+		FileStatsTimer timer(this->handler->io_counters.get(), statCall::line_reader);
+		if (this->handler->file == NULL) { this->handler = nullptr; this->status = ra_fileisclosed_fail; return false; }
+
+		size_t scan_from = this->data_begin;
+		bool has_carriage = false;
+
+		while (true)
 		{
-			if (buff_size > MAX_BUFFER_SIZE)
-			{
-				buff_size = MAX_BUFFER_SIZE;
-			}
-			else if (buff_size < MIN_BUFFER_SIZE)
-			{
-				buff_size = MIN_BUFFER_SIZE;
-			}
+			size_t stop = scan_from;
 
-			if (this->file_buffer == NULL && buff_type != bufferType::non_buffer) // Buffer allocation check
+			while (stop < this->data_end)
 			{
-				this->file_buffer = new char[buff_size];
-				this->file_buffer_size = buff_size * sizeof(char);
+				stop += FileScanner::findLineStop(this->buffer.data() + stop, this->data_end - stop);
+				if (stop == this->data_end || this->buffer[stop] != '\r') { break; }
 
-				if (this->file_buffer == NULL) // Secondary checking that the allocation/reallocation worked
-				{
-					fclose(this->file);
-					this->file = NULL;
-					this->file_buffer_size = 0;
-					return false;
-				}
+				has_carriage = true;
+				stop++;
 			}
-			else if (buff_type != bufferType::non_buffer)
+
+			if (stop < this->data_end || (this->ended && this->data_begin < this->data_end))
 			{
-				delete[] this->file_buffer;
-				this->file_buffer = new char[buff_size];
-				this->file_buffer_size = buff_size * sizeof(char);
+				char* line_data = this->buffer.data() + this->data_begin;
+				size_t line_size = stop - this->data_begin;
 
-				if (this->file_buffer == NULL) // Secondary checking that the allocation/reallocation worked
+				this->data_begin = std::min(stop + 1, this->data_end);
+
+				if (has_carriage) { line_size = std::remove(line_data, line_data + line_size, '\r') - line_data; }
+				if (!this->handler->clearCharsCanUse)
 				{
-					fclose(this->file);
-					this->file = NULL;
-					this->file_buffer_size = 0;
-					return false;
+					size_t raw_size = line_size;
+					line_size = FileScanner::filterBytes(line_data, line_data, line_size, this->handler->char_filter_data);
+					FileStats::countFiltered(this->handler->io_counters.get(), raw_size - line_size);
 				}
-			}
-			else if (this->file_buffer != NULL)
-			{
-				delete[] this->file_buffer;
-				this->file_buffer = NULL;
-				this->file_buffer_size = 0;
-			}
 
-			switch (buff_type)
-			{
-			case bufferType::non_buffer: { setvbuf(this->file, this->file_buffer, _IONBF, buff_size);  break; }
-			case bufferType::line_buffer: { setvbuf(this->file, this->file_buffer, _IOLBF, buff_size);  break; }
-			case bufferType::full_buffer: { setvbuf(this->file, this->file_buffer, _IOFBF, buff_size); break; }
-			default: { setvbuf(this->file, this->file_buffer, DEFUALT_BUFFER_NAME, buff_size); }
+				this->line = string_view(line_data, line_size);
+
+				return true;
 			}
 
-			return true;
-		}
+			if (this->ended) { this->line = string_view(); return false; }
 
-		return false;
-	}
+			size_t partial = this->data_end - this->data_begin; // The start of a line that goes on in the next block
 
-	/*
-		The function gets the file's state.
-	*/
-	file_data FileHandler::getFileState() noexcept
-	{
-		unsigned int file_len = 0;
-		unsigned int buffer_type_number = 0;
-		string buffer_type;
+			if (this->data_begin > 0) { memmove(this->buffer.data(), this->buffer.data() + this->data_begin, partial); }
+			if (partial == this->buffer.size()) { this->buffer.resize(this->buffer.size() * 2); }
 
-		switch (this->buffer_type)
-		{
-		case bufferType::non_buffer: { buffer_type = "No Buffering"; buffer_type_number = _IONBF; break; }
-		case bufferType::line_buffer: { buffer_type = "Line Buffering"; buffer_type_number = _IOLBF;  break; }
-		case bufferType::full_buffer: { buffer_type = "Full Buffering"; buffer_type_number = _IOFBF; break; }
-		default:
-		{
-			buffer_type = DEFUALT_BUFFER_NAME_TXT;
-			buffer_type_number = DEFUALT_BUFFER_NAME;
-		}
-		}
+			this->data_begin = 0;
+			this->data_end = partial;
+			scan_from = partial;
 
-		return { this->file_path, this->file_name, this->extension, this->file_buffer,  buffer_type_number, buffer_type,
-							getFileStreamType(this->file_access), getFilesLength(), this->file_buffer_size, this->last_move };
+			size_t wanted = this->buffer.size() - this->data_end;
+			const long read_start = this->handler->adaptive_buffer ? ftell(this->handler->file) : NON_WORK;
+			size_t read_count = fread(this->buffer.data() + this->data_end, sizeof(char), wanted, this->handler->file);
+			FileStats::countRead(this->handler->io_counters.get(), read_count);
+			this->handler->trackAccess(read_start, read_start + (long)read_count);
+
+			this->data_end += read_count;
+
+			if (read_count < wanted)
+			{
+				if (ferror(this->handler->file)) { this->status = ra_readfile_fail; clearerr(this->handler->file); }
+				this->ended = true;
+			}
+		}
 	}
 
 	/*
-		The function move's the cursor around the file.
-		--> This function is slow and should'nt be used a lot!
+		The function constructs a FileRangeReader object, nothing is read until the first line is asked.
 	*/
-	bool FileHandler::moveCursorInFile(const filePosSet& pos_set, int offset) noexcept
+	FileRangeReader::FileRangeReader(FileHandler& handler, const line_range& range, size_t block_size) noexcept : handler(&handler), next_offset(range.start),
+		end(range.end), data_begin(0), data_end(0), ended(false), status(ra_succss)
 	{
-		if (file == NULL)
-			return false;
-
-		int curser_pos = 0;
-
-		this->last_file_place = ftell(this->file);
-
-		switch (pos_set)
-		{
-		case filePosSet::start_file: { curser_pos = SEEK_SET; break; }
-		case filePosSet::current_file: { curser_pos = SEEK_CUR; break; }
-		case filePosSet::end_file: { curser_pos = SEEK_END; break; }
-		default:
-			curser_pos = SEEK_SET;
-		}
-
-		return !fseek(this->file, (long)offset, curser_pos);
+		try { this->buffer.resize(std::max<size_t>(block_size, LINE_SCAN_FIRST_CHUNK)); }
+		catch (...) { this->handler = nullptr; this->status = ra_unknown_fail; }
 	}
 
 	/*
-		Sets the file's ignoring data.
-		--> The ignoring is set both to reading and writing options!
+		The function reads the next line of the range.
+		@ Returns false when there are no more lines, or if reading failed (see getStatus).
 	*/
-	bool FileHandler::setIgnoring(const ignore_data& ignoring) noexcept
+	bool FileRangeReader::next(string_view& line) noexcept
 	{
-		if (this->file == NULL) { return false; }
+		if (this->handler == nullptr) { return false; }
 
-		if (!ignoring.ignore_signle_chars.empty()) { this->clearCharsCanUse = false; }
+		size_t scan_from = this->data_begin;
+		bool has_carriage = false;
 
-		for (int i = 0; i < ignoring.ignore_signle_chars.size(); i++)
+		while (true)
 		{
-			this->charsCanUse[ignoring.ignore_signle_chars[i]] = false;
-		}
+			size_t stop = scan_from;
 
-		for (int i = 0; i < ignoring.ignore_range_chars.size(); i++)
-		{
-			const pair<char, char>& range_data = ignoring.ignore_range_chars[i];
+			while (stop < this->data_end)
+			{
+				stop += FileScanner::findLineStop(this->buffer.data() + stop, this->data_end - stop);
+				if (stop == this->data_end || this->buffer[stop] != '\r') { break; }
 
-			if (range_data.first <= range_data.second)
+				has_carriage = true;
+				stop++;
+			}
+
+			if (stop < this->data_end || (this->ended && this->data_begin < this->data_end))
 			{
-				this->clearCharsCanUse = false;
+				char* line_data = this->buffer.data() + this->data_begin;
+				size_t line_size = stop - this->data_begin;
+
+				this->data_begin = std::min(stop + 1, this->data_end);
 
-				for (int j = range_data.first; j <= range_data.second; j++)
+				if (has_carriage) { line_size = std::remove(line_data, line_data + line_size, '\r') - line_data; }
+				if (!this->handler->clearCharsCanUse)
 				{
-					this->charsCanUse[j] = false;
+					size_t raw_size = line_size;
+					line_size = FileScanner::filterBytes(line_data, line_data, line_size, this->handler->char_filter_data);
+					FileStats::countFiltered(this->handler->io_counters.get(), raw_size - line_size);
 				}
+
+				line = string_view(line_data, line_size);
+
+				return true;
 			}
-		}
 
-		return true;
+			if (this->ended) { line = string_view(); return false; }
+
+			size_t partial = this->data_end - this->data_begin; // The start of a line that goes on in the next block
+
+			if (this->data_begin > 0) { memmove(this->buffer.data(), this->buffer.data() + this->data_begin, partial); }
+
+			if (partial == this->buffer.size())
+			{
+				try { this->buffer.resize(this->buffer.size() * 2); }
+				catch (...) { this->status = ra_unknown_fail; this->handler = nullptr; return false; }
+			}
+
+			this->data_begin = 0;
+			this->data_end = partial;
+			scan_from = partial;
+
+			size_t wanted = std::min(this->buffer.size() - this->data_end, (size_t)std::max(0L, this->end - this->next_offset));
+			long read_count = wanted > 0 ? this->handler->preadFile(this->buffer.data() + this->data_end, wanted, this->next_offset) : 0;
+
+			if (read_count < 0) { this->status = ra_readfile_fail; read_count = 0; }
+
+			this->data_end += (size_t)read_count;
+			this->next_offset += read_count;
+
+			if ((size_t)read_count < wanted || this->next_offset >= this->end) { this->ended = true; }
+		}
 	}
 
 	/*
-		Clears the file's ignoring data.
-		--> The ignoring is cleared both to reading and writing options!
+		The function adds a piece to the batch, the piece is kept as a view.
 	*/
-	bool FileHandler::clearIngoring() noexcept
+	WriteBatch& WriteBatch::operator<<(string_view data)
 	{
-		if (this->file == NULL) { return false; }
-
-		for (int i = 0; i < MAX_CHAR_CAPACITY; i++)
-		{
-			this->charsCanUse[i] = true;
-		}
+		if (data.empty()) { return *this; }
 
-		this->clearCharsCanUse = true;
+		this->pieces.push_back(data);
+		this->size += data.size();
 
-		return true;
+		return *this;
 	}
 
-	//pair<bool, char> FileHandler::operator[](const int index)
-	//{
-	//	return pair<bool, char>();
-	//}
-	//
-	//pair<bool, string> FileHandler::substr(const int index, const int len)
-	//{
-	//	return pair<bool, string>();
-	//}
-
 	/*
-		The function rewinds the file one step by the cursor.
-		--> This function is slow and should'nt be used a lot!
+		The function adds a temporary string to the batch, the batch keeps the string until it is written.
 	*/
-	bool FileHandler::rewindFileOneStep() noexcept
+	WriteBatch& WriteBatch::operator<<(string&& data)
 	{
-		if (this->file != NULL)
-		{
-			return !fseek(this->file, this->last_file_place, SEEK_SET);
-		}
+		if (data.empty()) { return *this; }
 
-		return false;
+		this->owned.push_back(std::move(data));
+		return *this << string_view(this->owned.back());
 	}
 
 	/*
-		The function checks if the cursor at the end of the file.
+		The function adds a single char to the batch.
 	*/
-	bool FileHandler::isEndOfFile() const noexcept { if (file != NULL) { return feof(this->file); } return false; }
+	WriteBatch& WriteBatch::operator<<(const char data)
+	{
+		this->owned.push_back(string(1, data));
+		return *this << string_view(this->owned.back());
+	}
 
 	/*
-		The function checks if the file is opened.
+		The function writes all the pieces in the batch into the file, and empties the batch.
 	*/
-	bool FileHandler::isFileOpened() const noexcept { return file != NULL; }
-
-	bool FileHandler::isThreadSafe() const noexcept
+	bool WriteBatch::submit() noexcept
 	{
-		return this->thread_safe;
+		if (this->pieces.empty()) { return true; }
+
+		bool val = this->handler->writeBatch(this->pieces);
+		this->clear();
+
+		return val;
 	}
 
 	/*
-		The function checks if the file exists.
+		The function empties the batch without writing it.
 	*/
-	bool FileHandler::fileExists(const std::string& f_path) noexcept
+	void WriteBatch::clear() noexcept
 	{
-		FILE* fl = NULL;
-		if ((fl = fopen(f_path.c_str(), "rb")) != NULL)
-		{
-			fclose(fl); return true;
-		}
-
-		return false;
+		this->pieces.clear();
+		this->owned.clear();
+		this->size = 0;
 	}
-}
\ No newline at end of file
+}
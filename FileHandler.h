@@ -2,26 +2,52 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <algorithm>
 #include <vector>
 #include <map>
+#include <deque>
 #include <exception>
 #include <thread>
 #include <future>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <condition_variable>
+#include <string_view>
+#include <span>
+#include <cstddef>
+#include <type_traits>
+#include <iterator>
+#include <chrono>
+#include <memory>
+
+#include "FileScanner.h"
+#include "FileAsyncEngine.h"
+#include "FileWorkerPool.h"
+#include "FileStats.h"
+#include "FileTrace.h"
+#include "FileCodec.h"
 
 using std::string;
 using std::ostream;
 using std::pair;
 using std::vector;
 using std::map;
+using std::deque;
 using std::thread;
 using std::mutex;
 using std::lock_guard;
+using std::shared_mutex;
+using std::unique_lock;
+using std::condition_variable;
 using std::promise;
 using std::future;
+using std::string_view;
+using std::span;
+using std::function;
 
 #define DEFUALT_MODE				"rb"
 #define DEFUALT_MODE_ENUM			openFileModes::read_b
@@ -29,7 +55,7 @@ using std::future;
 #define DEFUALT_BUFFER_NAME			_IOFBF
 #define DEFUALT_BUFFER_NAME_TXT		"Full Buffering"
 #define DEFUALT_BUFFER_SIZE			2048
-#define MAX_BUFFER_SIZE				16384
+#define MAX_BUFFER_SIZE				8388608
 #define MIN_BUFFER_SIZE				128
 #define MAX_BUFFER_GETLINE_SIZE		1024
 #define MIN_BUFFER_GETLINE_SIZE		1
@@ -39,6 +65,23 @@ using std::future;
 #define NON_WORK					-1
 #define DFLT_BUFF_GLINE_SIZE		16
 #define MAX_CHAR_CAPACITY			256
+#define DFLT_LINE_INDEX_STEP		128
+#define LINE_INDEX_READ_CHUNK		65536
+#define LINE_SCAN_FIRST_CHUNK		4096
+#define DFLT_LINE_SCAN_CHUNK		256
+#define LINE_INDEX_SIDECAR_EXT		".lidx"
+#define LINE_INDEX_MAGIC			"FHLIDX01"
+#define WRITE_BATCH_IOV_MAX			64
+#define DFLT_WRITE_BEHIND_MARK		4194304
+#define MAX_ADAPTIVE_BUFFER_SIZE	4194304
+#define ADAPTIVE_BUFFER_STREAK		4
+#define DFLT_META_TTL_MS			0
+#define DIRECT_IO_ALIGN				4096
+#define DIRECT_IO_CHUNK_SIZE		1048576
+#define DFLT_RANGE_BLOCK_SIZE		1048576
+#define MIN_LINE_RANGE_SIZE			1048576
+#define LINE_RANGES_PER_WORKER		4
+#define FIND_BLOCK_SIZE				262144
 
 #define OS_KW_CONST
 #if defined(__unix__) || defined(__unix) || defined(__linux__)
@@ -53,13 +96,17 @@ using std::future;
 #endif
 
 
-namespace FileObj 
-{
 #if defined(OS_LINUX) || defined(OS_MAC)
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#elif defined(OS_WIN)
+#include <windows.h>
+#endif
 
+namespace FileObj 
+{
+#if defined(OS_LINUX) || defined(OS_MAC)
 	static inline time_t _getFileLastModificationTime(const char* fpath)
 	{
 		struct stat obj {};
@@ -67,7 +114,6 @@ namespace FileObj
 	}
 
 #elif defined(OS_WIN)
-#include <windows.h>
 	static inline FILETIME _getFileLastModificationTime(const char* fpath)
 	{
 		HANDLE file = CreateFileA(fpath, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
@@ -107,13 +153,29 @@ namespace FileObj
 		write_p("w+") ->	write/update: Create an empty file and open it for update (both for input and output). If a file with the same name already exists its contents are discarded and the file is treated as a new empty file.
 		append_p("a+") ->	append/update: Open a file for update (both for input and output) with all output operations writing data at the end of the file. Repositioning operations (fseek, fsetpos, rewind) affects the next input operations, but output operations move the position back to the end of file. The file is created if it does not exist.
 
+		read_m("rb") ->	read/mapped: Open file for input operations and map it into the memory, so the view functions return string_view into the mapping without copying. The file must exist.
+						The size of the file is checked before every view, so a file that was truncated is mapped again. A view that was returned
+						before the file was truncated by someone else may still point past its new end, and touching it raises SIGBUS!
+		read_d("rb") ->	read/direct: Open file for input operations that go around the page cache (O_DIRECT), for big streaming reads that shouldn't evict the data of others. The file must exist.
+		write_d("wb") ->	write/direct: Create an empty file for output operations that go around the page cache (O_DIRECT), for big streaming writes.
+						In the direct modes the bulk functions (readInto, readFromFile, readAt, getLines, writeToFile, writeBatch, writeAt) go around the cache,
+						unaligned starts and ends are handled inside. If the file system can't do it, the file is used through the cache and the used data is dropped from it.
+		read_z("rb") ->	read/compressed: Open a gzip or zstd file and decompress it on the fly while it is read (see setCompression). The file must exist.
+		write_z("wb") ->	write/compressed: Create an empty file and compress the data written into it on the fly.
+		append_z("ab") ->	append/compressed: Open file for output at the end of a file, the data is compressed into a new gzip member or zstd frame.
+						In the compressed modes the stream functions (readInto, readFromFile, getLine, the line readers, operator>>, writeToFile, writeBatch, operator<<)
+						work on the plain data, and the positional and descriptor functions (readAt, writeAt, getLines, find, scanStats, the async and mapped
+						functions) fail with ra_fileaccesstype_fail. A seek back decompresses the file again from its start, and the length is the compressed one.
+
 		The 'b' addition just means the file will be treated in a binary form.
 	*/
 	enum class openFileModes
 	{
 		read, read_b, read_p, read_bp,
 		write, write_b, write_p, write_bp,
-		append, append_b, append_p, append_bp
+		append, append_b, append_p, append_bp,
+		read_m, read_d, write_d,
+		read_z, write_z, append_z
 	};
 
 
@@ -140,6 +202,20 @@ namespace FileObj
 		start_file, current_file, end_file
 	};
 
+	/*
+		This sets the expected way of accessing the file, so the system can prepare the data for it.
+		normal --> No special treatment.
+		sequential --> The data will be read from the beginning to the end, so read ahead aggressively.
+		random --> The data will be read in a random order, so don't read ahead.
+		willneed --> The data will be needed soon, so start reading it now.
+		dontneed --> The data won't be needed soon, so it can be dropped from the memory.
+		once --> The data will be read once from the beginning to the end, so read ahead but don't keep it.
+	*/
+	enum class accessHint
+	{
+		normal, sequential, random, willneed, dontneed, once
+	};
+
 	/*
 		This is the enum of the return values.
 	*/
@@ -166,15 +242,91 @@ namespace FileObj
 		const string& extension;
 		const char* const file_buffer;
 		const unsigned int buffer_type_number;
-		const string& buffer_type;
-		const string& file_access;
+		const string buffer_type;
+		const string file_access;
 		const long file_len;
 		const unsigned int buffer_size;
 		const unsigned char last_move;
+		const io_stats io; // The I/O counters of the handler
 
 		friend ostream& operator<<(ostream& os, const file_data& data);
 	} file_data;
 
+	typedef struct read_result // Result of a bulk read
+	{
+		size_t count; // Amount of bytes put in the buffer
+		bool end_of_file; // The end of the file was reached during the read
+	} read_result;
+
+	typedef struct async_slice // One part of a batched asynchronous read
+	{
+		char* buffer;
+		size_t count;
+		long pos;
+	} async_slice;
+
+	typedef struct line_range // A part of a file that starts at the start of a line and ends right after the end of a line
+	{
+		long start;
+		long end;
+	} line_range;
+
+	typedef struct parallel_options // How a file is split between the workers
+	{
+		size_t ranges = 0; // 0 gives every worker LINE_RANGES_PER_WORKER ranges, so a slow range doesn't hold the others
+		size_t min_range_size = MIN_LINE_RANGE_SIZE; // Small files are split into less ranges
+		bool ordered = false; // Reduces the partial results in the order of the file, instead of as they are done
+	} parallel_options;
+
+	typedef struct find_options // Where and how find and findAll search
+	{
+		long start = 0; // The searched bytes are [start, end)
+		long end = NON_WORK; // NON_WORK is the end of the file
+		bool regex = false; // The patterns are ECMAScript regexes that are matched against every line, instead of bytes to find
+		size_t max_matches = 0; // 0 is no limit
+		parallel_options parallel = parallel_options(); // ordered is ignored, the matches are always given in the order of the file
+	} find_options;
+
+	typedef struct find_match // One place where a pattern was found
+	{
+		long offset; // Of the first byte of the match in the file
+		size_t length;
+		unsigned long line; // The line of the match, counted from 0 like in getLine (only '\n' ends a line)
+		unsigned int pattern; // The place of the matched pattern in the given patterns
+	} find_match;
+
+	typedef struct scan_stats // Byte statistics of a whole file, see scanStats
+	{
+		long size;
+		unsigned long long lines; // Lines as '\n' splits them, a last line without '\n' is counted too
+		unsigned long long new_lines; // Amount of '\n'
+		unsigned long long crlf_pairs; // Amount of "\r\n"
+		unsigned long long nul_bytes; // getLine and getLines stop at the first '\0', so with any the lines after it can't be gotten
+		size_t longest_line; // In bytes, without its '\n' ('\r' is counted)
+	} scan_stats;
+
+	struct find_plan;
+	struct find_piece;
+
+	typedef struct file_meta // Metadata of a file
+	{
+		long size; // Length of the file in bytes
+		time_t mtime; // Last modification time, in seconds
+		long mtime_ns; // The nanoseconds part of the last modification time
+		size_t block_size; // The preferred I/O block size
+		unsigned long long inode;
+		unsigned long long device;
+	} file_meta;
+
+	typedef struct lock_stats // Counters of the lock of the thread safe mode
+	{
+		unsigned long long shared_locks; // Amount of times the lock was taken by readers
+		unsigned long long exclusive_locks; // Amount of times the lock was taken by writers
+		unsigned long long shared_waits; // Amount of times a reader had to wait for the lock
+		unsigned long long exclusive_waits; // Amount of times a writer had to wait for the lock
+		unsigned long long wait_ns; // The total time spent waiting for the lock, in nanoseconds
+	} lock_stats;
+
 	typedef struct ignore_data // For setting which chars to ignore
 	{
 		vector<char> ignore_signle_chars; // For ignoring only single chars
@@ -182,8 +334,166 @@ namespace FileObj
 
 	} ignore_data;
 
+	class FileHandler;
+
+	/*
+		Takes the lock of a file handler for one call, only if the handler is in the thread safe mode.
+		@ Readers that don't use the cursor of the file share the lock, everything else takes it alone.
+		@ A call made from inside another call of the same handler on the same thread doesn't lock again, the locks a thread
+			holds are chained on its stack so calls that go between handlers (A -> B -> A) are known too.
+		--> A thread that holds only the shared lock of a handler can't take it alone (the lock can't be upgraded)!
+	*/
+	class FileHandlerLock
+	{
+	private:
+		FileHandler* handler;
+		const FileHandlerLock* outer; // The lock this thread took before this one
+		bool locked;
+		bool exclusive;
+
+	public:
+		FileHandlerLock(FileHandler& handler, const bool exclusive = true) noexcept;
+		~FileHandlerLock();
+
+		FileHandlerLock(const FileHandlerLock& other) = delete;
+		FileHandlerLock& operator=(const FileHandlerLock& other) = delete;
+	};
+
+	/*
+		Reads the lines of a file one after the other into one buffer that is reused, and gives them as views into it.
+		@ A line ends on '\n' or '\0' (like in operator>>), '\r' is removed and the ignoring table of the file is applied.
+		@ The buffer grows for lines longer than it, so there is no limit to the line's length.
+		--> The view of a line is valid only until the next line is read!
+		--> When the reader is destroyed, the cursor of the file is moved back to right after the last line given.
+	*/
+	class FileLineReader
+	{
+	private:
+		FileHandler* handler;
+		vector<char> buffer;
+		size_t data_begin;
+		size_t data_end;
+		bool ended;
+		string_view line;
+		unsigned int status;
+
+	public:
+		FileLineReader(FileHandler& handler, const long& pos = 0) noexcept;
+		~FileLineReader();
+
+		FileLineReader(const FileLineReader& other) = delete;
+		FileLineReader(FileLineReader&& other) noexcept;
+		FileLineReader& operator=(const FileLineReader& other) = delete;
+		FileLineReader& operator=(FileLineReader&& other) = delete;
+
+		bool next() noexcept;
+		string_view getLine() const noexcept { return this->line; }
+		unsigned int getStatus() const noexcept { return this->status; }
+	};
+
+	/*
+		A range of the lines of a file, for using in a range-based for loop.
+	*/
+	class LineRange
+	{
+	private:
+		FileLineReader reader;
+
+	public:
+		class iterator
+		{
+		private:
+			FileLineReader* reader;
+
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = string_view;
+			using difference_type = std::ptrdiff_t;
+
+			iterator(FileLineReader* reader = nullptr) noexcept : reader(reader) {}
+
+			string_view operator*() const noexcept { return this->reader->getLine(); }
+			iterator& operator++() noexcept { if (!this->reader->next()) { this->reader = nullptr; } return *this; }
+			void operator++(int) noexcept { ++(*this); }
+			bool operator==(std::default_sentinel_t) const noexcept { return this->reader == nullptr; }
+		};
+
+		LineRange(FileHandler& handler, const long& pos = 0) noexcept : reader(handler, pos) {}
+
+		iterator begin() noexcept { return this->reader.next() ? iterator(&this->reader) : iterator(); }
+		std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+		unsigned int getStatus() const noexcept { return this->reader.getStatus(); }
+	};
+
+	/*
+		Reads the lines of one range of a file as views, without using the cursor of the file, so many ranges can be read at once.
+		@ Lines end like in FileLineReader, '\r' is removed and the ignoring table of the file is applied.
+		--> It doesn't lock the handler, it is used inside a call that has the lock (like mapReduceLines).
+		--> The view of a line is valid only until the next line is read!
+	*/
+	class FileRangeReader
+	{
+	private:
+		FileHandler* handler;
+		vector<char> buffer;
+		long next_offset;
+		long end;
+		size_t data_begin;
+		size_t data_end;
+		bool ended;
+		unsigned int status;
+
+	public:
+		FileRangeReader(FileHandler& handler, const line_range& range, size_t block_size = DFLT_RANGE_BLOCK_SIZE) noexcept;
+
+		FileRangeReader(const FileRangeReader& other) = delete;
+		FileRangeReader& operator=(const FileRangeReader& other) = delete;
+
+		bool next(string_view& line) noexcept;
+		unsigned int getStatus() const noexcept { return this->status; }
+	};
+
+	/*
+		Collects pieces of data to write into a file, and writes them all together (one system call when possible).
+		@ Temporary strings are kept by the batch, other pieces are kept as views so their data must live until the batch is written!
+		--> What is left in the batch is written when it is destroyed.
+	*/
+	class WriteBatch
+	{
+	private:
+		FileHandler* handler;
+		vector<string_view> pieces;
+		deque<string> owned;
+		size_t size;
+
+	public:
+		WriteBatch(FileHandler& handler) noexcept : handler(&handler), size(0) {}
+		~WriteBatch() { this->submit(); }
+
+		WriteBatch(const WriteBatch& other) = delete;
+		WriteBatch(WriteBatch&& other) = delete;
+		WriteBatch& operator=(const WriteBatch& other) = delete;
+		WriteBatch& operator=(WriteBatch&& other) = delete;
+
+		WriteBatch& operator<< (string_view data);
+		WriteBatch& operator<< (const char* data) { return *this << string_view(data == nullptr ? "" : data); }
+		WriteBatch& operator<< (const string& data) { return *this << string_view(data); }
+		WriteBatch& operator<< (string&& data);
+		WriteBatch& operator<< (const char data);
+
+		bool submit() noexcept;
+		void clear() noexcept;
+		size_t getSize() const noexcept { return this->size; }
+		size_t getCount() const noexcept { return this->pieces.size(); }
+	};
+
 	class FileHandler
 	{
+		friend class FileLineReader;
+		friend class FileRangeReader;
+		friend class FileHandlerLock;
+		friend class FileHandleCache;
+
 	private:
 		string file_path;
 		string file_name;
@@ -196,29 +506,140 @@ namespace FileObj
 
 		bool thread_safe;
 		mutex file_mutex;
+		shared_mutex handler_mutex; // Used only in the thread safe mode, see FileHandlerLock
+		std::atomic<unsigned long long> lock_shared_count;
+		std::atomic<unsigned long long> lock_exclusive_count;
+		std::atomic<unsigned long long> lock_shared_waits;
+		std::atomic<unsigned long long> lock_exclusive_waits;
+		std::atomic<unsigned long long> lock_wait_ns;
+		std::shared_ptr<FileStats> io_counters; // Made when a file is first opened, async calls keep it until they end
+		std::atomic<FileObserver*> observer; // Gets the traced operations, nullptr when nothing traces the handler
 		bufferType buffer_type;
 		openFileModes file_access;
 		unsigned char last_move;
 		long last_file_place;
 
+		bool line_index_enabled;
+		bool line_index_sidecar;
+		bool line_index_stopped; // The index met a '\0' which ends every line scan, so it can't grow anymore
+		unsigned int line_index_step;
+		unsigned long line_index_lines; // Amount of '\n' inside the indexed part
+		long line_index_end; // Amount of bytes covered by the index
+		vector<long> line_index_offsets; // line_index_offsets[k] is the start of the line (k * line_index_step)
+
+		accessHint access_hint;
+		bool adaptive_buffer;
+		size_t adaptive_base_size; // The block size of the file, the buffer never gets smaller than it
+		long adaptive_next_pos; // Where the next read starts if the reads are sequential
+		unsigned int adaptive_seq_streak;
+		unsigned int adaptive_rand_streak;
+
+		file_meta meta_cache;
+		bool meta_valid;
+		bool meta_dirty; // Written in a way whose end isn't known (write behind, async), so the cache must be checked again
+		bool meta_written; // Written since the last check, so the size is known but the modification time isn't
+		unsigned int meta_ttl_ms; // For how long the cache is trusted against changes made by others
+		std::chrono::steady_clock::time_point meta_checked;
+
+		scan_stats scan_cache; // The last scanStats of the file, valid while the file is as it was in scan_meta
+		file_meta scan_meta;
+		bool scan_valid;
+
+		int direct_fd; // Opened with O_DIRECT in the direct modes, the stream still keeps the cursor
+		size_t direct_align;
+		long drop_start; // The last range written in a direct mode without O_DIRECT, dropped from the cache after the next one
+		long drop_end;
+
+		FileCodec* codec; // The stream of the compressed modes, owned by the file (fclose frees it)
+		codec_options codec_settings;
+
+		char* map_data;
+		size_t map_size;
+		size_t map_cursor;
+		accessHint map_hint;
+
+		vector<char> line_chunk;
+
+		char_filter char_filter_data;
+		bool char_filter_dirty;
+		vector<char> filter_buffer;
+
+		bool behind_enabled;
+		bool behind_busy; // The flusher is writing behind_back
+		bool behind_stop;
+		bool behind_failed; // A background write failed, it is reported by the next flush
+		size_t behind_high_water; // Writers wait while more than this amount of bytes is pending
+		size_t behind_pending;
+		vector<char> behind_front; // Filled by the writers
+		vector<char> behind_back; // Written by the flusher
+		mutex behind_mutex;
+		condition_variable behind_cv;
+		condition_variable behind_done_cv;
+		thread behind_thread;
+
 		string getFileStreamType(const openFileModes& file_mode) const noexcept;
-		void getLineWithPromise(promise<retObj<string>>&& retVal, unsigned int numline = 0, const int pos = NON_WORK, unsigned int buff_size = DFLT_BUFF_GLINE_SIZE, const bool& auto_rewind = true, const bool& flush_file = false) noexcept;
+		int scanLine(string& line_data, unsigned int& skip_lines, const bool& keep_new_line) noexcept;
+		void filterData(string& data) noexcept;
+		size_t filterToBuffer(const char* data, size_t size) noexcept;
+		const char_filter& getCharFilter() noexcept;
+		long preadFile(char* buffer, size_t count, long offset) noexcept;
+		long pwriteFile(const char* data, size_t count, long offset) noexcept;
+		void scanLinesAt(long start, const pair<unsigned int, size_t>* lines, size_t count, vector<retObj<string>>& lines_data) noexcept;
+		void scanLineIndex(const char* data, size_t size) noexcept;
+		bool extendLineIndex() noexcept;
+		void updateLineIndex(const char* data, size_t size, long write_start = NON_WORK) noexcept;
+		bool writePieces(const string_view* pieces, size_t count, size_t total) noexcept;
+		bool writeData(const char* data, size_t size) noexcept;
+		bool queueWriteBehind(const string_view* pieces, size_t count, size_t total) noexcept;
+		bool syncWriteBehind() noexcept;
+		void writeBehindLoop() noexcept;
+		long seekLineIndex(unsigned int& numline) noexcept;
+		void resetLineIndex() noexcept;
+		bool canReadFile() const noexcept;
+		bool canWriteFile() const noexcept;
+		bool mapFile() noexcept;
+		void unmapFile() noexcept;
+		bool remapFile(size_t needed_size) noexcept;
+		bool checkMapSize() noexcept;
+		returnAns prepareFdAccess(const bool& for_write) noexcept;
+		bool resizeFileBuffer(const bufferType& buff_type, size_t buff_size) noexcept;
+		void trackAccess(long start, long end) noexcept;
+		void openDirect(const string& path) noexcept;
+		void closeDirect() noexcept;
+		long directRead(char* buffer, size_t count, long offset) noexcept;
+		long directWrite(const char* data, size_t count, long offset) noexcept;
+		bool writeDirectAtCursor(const char* data, size_t size) noexcept;
+		void dropCachedRange(long start, long end, const bool& written) noexcept;
+		bool refreshMeta() noexcept;
+		bool isScanCurrent() noexcept;
+		void noteWrite(long end = NON_WORK) noexcept;
+		bool countLineEnds(long start, long end, unsigned long& count) noexcept;
+		void findInRange(const find_plan& plan, long start, long end, find_piece& piece) noexcept;
+
+		bool takeFrom(FileHandler& other) noexcept;
+		int seekFile(long offset, int origin) noexcept;
+		int getFileFd() const noexcept;
+		FileObserver* getTracer() const noexcept { return this->observer.load(std::memory_order_relaxed); } // Read without the lock by lock waits
+		int flushStream() noexcept;
+
+		static char* allocFileBuffer(size_t buff_size) noexcept;
+		static void freeFileBuffer(char* buffer, size_t buff_size) noexcept;
 
 	public:
 		FileHandler() noexcept;
 		FileHandler(const string& path, const openFileModes& file_mode = DEFUALT_MODE_ENUM, const bool thread_safe = false, const bufferType& buff_type = DEFUALT_BUFFER, size_t buff_size = DEFUALT_BUFFER_SIZE);
 
-		~FileHandler() { if (file != NULL) { fclose(file); file = NULL; } if (file_buffer != NULL) { delete[] file_buffer; file_buffer = NULL; this->file_buffer_size = 0; } }
+		~FileHandler() { this->closeFile(); }
 
 		FileHandler(const FileHandler& other) = delete;
-		FileHandler(FileHandler&& other) = delete;
+		FileHandler(FileHandler&& other) noexcept;
 		FileHandler& operator=(const FileHandler& other) = delete;
-		FileHandler& operator=(FileHandler&& other) = delete;
+		FileHandler& operator=(FileHandler&& other) noexcept;
 
 		FileHandler& operator<< (const char* str);
 		FileHandler& operator<< (const string& str);
 		FileHandler& operator<< (string&& str);
-		FileHandler& operator>> (char* str);
+		[[deprecated("The size of str isn't known, use operator>>(string&)")]] FileHandler& operator>> (char* str);
 		FileHandler& operator>> (string& str);
 		bool& operator[](const unsigned int index);
 		char const* const* const operator()() const noexcept;
@@ -226,42 +647,172 @@ namespace FileObj
 		bool openFile(const string& f_name, const openFileModes& file_mode = DEFUALT_MODE_ENUM, const bool thread_safe = false,
 			const bufferType& buff_type = DEFUALT_BUFFER, size_t buff_size = DEFUALT_BUFFER_SIZE) noexcept;
 		bool writeToFile(const string& data, const int& pos = NON_WORK, const bool& auto_rewind = false, const bool& flush_file = false) noexcept;
+		bool writeBatch(const string_view* pieces, size_t count, const int& pos = NON_WORK, const bool& auto_rewind = false, const bool& flush_file = false) noexcept;
+		bool writeBatch(const vector<string_view>& pieces, const int& pos = NON_WORK, const bool& auto_rewind = false, const bool& flush_file = false) noexcept
+		{
+			return this->writeBatch(pieces.data(), pieces.size(), pos, auto_rewind, flush_file);
+		}
+		retObj<read_result> readInto(char* buffer, const size_t& count, const long& pos = NON_WORK, const bool& auto_rewind = true, const bool& flush_file = false) noexcept;
+		retObj<read_result> readInto(span<std::byte> buffer, const long& pos = NON_WORK, const bool& auto_rewind = true, const bool& flush_file = false) noexcept
+		{
+			return this->readInto((char*)buffer.data(), buffer.size(), pos, auto_rewind, flush_file);
+		}
+		template <class C> requires (!std::is_array_v<C>) // Arrays decay to the (buffer, count) version, so readInto(arr, 10) reads 10 bytes
+		retObj<read_result> readInto(C& container, const long& pos = NON_WORK, const bool& auto_rewind = true, const bool& flush_file = false) noexcept // Fills a pre-sized container
+		{
+			return this->readInto(std::as_writable_bytes(span(container)), pos, auto_rewind, flush_file);
+		}
+		retObj<read_result> readAt(const long& offset, char* buffer, const size_t& count) noexcept;
+		retObj<read_result> readAt(const long& offset, span<std::byte> buffer) noexcept
+		{
+			return this->readAt(offset, (char*)buffer.data(), buffer.size());
+		}
+		retObj<size_t> writeAt(const long& offset, const char* data, const size_t& count) noexcept;
+		retObj<size_t> writeAt(const long& offset, string_view data) noexcept { return this->writeAt(offset, data.data(), data.size()); }
 		retObj<string> readFromFile(const size_t& count = 1, const int& pos = NON_WORK, const bool& auto_rewind = true, const bool& flush_file = false) noexcept; // Returns 
 		retObj<string> getLine(unsigned int numline = 0, const int& pos = NON_WORK, unsigned int buff_size = DFLT_BUFF_GLINE_SIZE, const bool& auto_rewind = true, const bool& flush_file = false) noexcept;
+		retObj<vector<retObj<string>>> getLines(const vector<pair<unsigned int, int>>& lines_pos, const bool& flush_file = false) noexcept;
+		LineRange lines(const long& pos = 0) noexcept { return LineRange(*this, pos); }
+		template <class F>
+		retObj<size_t> forEachLine(F&& callback, const long& pos = 0) // The callback gets a string_view, and can return false to stop
+		{
+			FileLineReader reader(*this, pos);
+			size_t count = 0;
+
+			while (reader.next())
+			{
+				count++;
+
+				if constexpr (std::is_same_v<std::invoke_result_t<F, string_view>, bool>)
+				{
+					if (!callback(reader.getLine())) { break; }
+				}
+				else
+				{
+					callback(reader.getLine());
+				}
+			}
+
+			return { count, reader.getStatus() };
+		}
+		retObj<vector<line_range>> splitLineRanges(size_t count, size_t min_range_size = MIN_LINE_RANGE_SIZE) noexcept;
+
+		/*
+			The function splits the file into ranges of lines, runs map_line over the lines of every range on the shared worker pool,
+			and reduces the partial result of every range into the total.
+			@ reduce is called one partial at a time, in the order of the file if options.ordered is set.
+			--> In the thread safe mode the handler stays locked until all the workers are done, so map_line and reduce must not call
+				the functions of this handler (they run on other threads, which would wait for the lock forever)!
+		*/
+		template <class T, class M, class R>
+		retObj<T> mapReduceLines(M&& map_line, R&& reduce, T init = T(), const parallel_options& options = parallel_options()) // map_line(T& partial, string_view line), reduce(T& total, T&& partial)
+		{
+			FileHandlerLock lock(*this);
+
+			FileWorkerPool& pool = FileWorkerPool::getSharedPool();
+			retObj<vector<line_range>> ranges = this->splitLineRanges(options.ranges > 0 ? options.ranges : (size_t)pool.getWorkersCount() * LINE_RANGES_PER_WORKER, options.min_range_size);
+			if (ranges.statusObj != ra_succss) { return { init, ranges.statusObj }; }
+
+			T total = init;
+			vector<T> partials(options.ordered ? ranges.obj.size() : 0, init);
+			std::atomic<unsigned int> status{ ra_succss };
+			mutex total_mutex;
+
+			pool.runTasks(ranges.obj.size(), [&](size_t range) // The functors' exceptions are thrown to the caller
+				{
+					FileTraceScope trace(this->getTracer(), traceOp::task, &this->file_path, ranges.obj[range].start, (size_t)(ranges.obj[range].end - ranges.obj[range].start));
+					FileRangeReader reader(*this, ranges.obj[range]);
+					T partial = init;
+					string_view line;
+
+					while (reader.next(line)) { map_line(partial, line); }
+					if (reader.getStatus() != ra_succss) { status = reader.getStatus(); }
+
+					if (options.ordered) { partials[range] = std::move(partial); return; }
+
+					lock_guard<mutex> total_lock(total_mutex);
+					reduce(total, std::move(partial));
+				});
+
+			for (T& partial : partials) { reduce(total, std::move(partial)); }
+
+			return { std::move(total), status.load() };
+		}
+		retObj<size_t> find(const vector<string>& patterns, const function<bool(const find_match&)>& callback, const find_options& options = find_options()) noexcept;
+		retObj<vector<find_match>> findAll(const vector<string>& patterns, const find_options& options = find_options()) noexcept;
+		retObj<vector<find_match>> findAll(const string& pattern, const find_options& options = find_options()) noexcept;
 		void getLineMultiThreaded(retObj<map<pair<unsigned int, int>, retObj<string>>>& retObject, const vector<pair<unsigned int, int>>& lines_pos = vector<pair<unsigned int, int>>(), unsigned int buff_size = DFLT_BUFF_GLINE_SIZE, const bool& auto_rewind = true, const bool& flush_file = false);
 		bool closeFile() noexcept;
 		bool removeFile() noexcept;
 		bool flushFile() noexcept; // Safe flush
 		bool changeFileBuffer(const bufferType& buff_type = DEFUALT_BUFFER, size_t buff_size = DEFUALT_BUFFER_SIZE) noexcept;
-		bool moveCursorInFile(const filePosSet& pos_set, int offset = 0) noexcept;
+		bool moveCursorInFile(const filePosSet& pos_set, long offset = 0) noexcept;
 		bool setIgnoring(const ignore_data& ignoring) noexcept;
 		bool clearIngoring() noexcept;
+		bool buildLineIndex(unsigned int step = DFLT_LINE_INDEX_STEP, const bool& use_sidecar = false) noexcept;
+		bool loadLineIndex() noexcept;
+		bool saveLineIndex() noexcept;
+		bool clearLineIndex() noexcept;
+		bool hasLineIndex() const noexcept;
+		retObj<string_view> viewFromFile(const size_t& count = 1, const long& pos = NON_WORK) noexcept;
+		retObj<string_view> getLineView(unsigned int numline = 0, const long& pos = NON_WORK) noexcept;
+		bool adviseMap(const accessHint& hint) noexcept;
+		bool setAccessHint(const accessHint& hint, long offset = 0, long length = 0) noexcept;
+		accessHint getAccessHint() const noexcept;
+		bool setAdaptiveBuffer(const bool& enable) noexcept;
+		bool isAdaptiveBuffer() const noexcept;
+		bool isFileMapped() const noexcept;
+		bool isDirectIO() const noexcept;
+		bool setCompression(const codec_options& options) noexcept;
+		bool isCompressed() const noexcept;
+		future<retObj<read_result>> readAsync(char* buffer, const size_t& count, const long& pos) noexcept;
+		bool readAsync(char* buffer, const size_t& count, const long& pos, function<void(retObj<read_result>)>&& callback) noexcept;
+		vector<future<retObj<read_result>>> readAsync(const vector<async_slice>& slices) noexcept;
+		future<retObj<size_t>> writeAsync(const char* data, const size_t& count, const long& pos = NON_WORK) noexcept;
+		bool writeAsync(const char* data, const size_t& count, const long& pos, function<void(retObj<size_t>)>&& callback) noexcept;
+		future<retObj<string>> readLineAsync(unsigned int numline = 0, const long& pos = NON_WORK) noexcept;
 
 		file_data getFileState() noexcept;
 		long getFilesLength() noexcept;
+		retObj<file_meta> getFileMeta(const bool& refresh = false) noexcept;
+		retObj<scan_stats> scanStats(const bool& refresh = false, const parallel_options& options = parallel_options()) noexcept;
+		retObj<unsigned long long> countLines(const bool& refresh = false) noexcept;
+		void setMetaTtl(unsigned int ttl_ms) noexcept;
 		bool rewindFileOneStep() noexcept;
 		bool isEndOfFile() const noexcept;
 		bool isFileOpened() const noexcept;
 		bool isThreadSafe() const noexcept;
+		lock_stats getLockStats() const noexcept;
+		void resetLockStats() noexcept;
+		io_stats getIOStats() const noexcept;
+		void resetIOStats() noexcept;
+		void setObserver(FileObserver* observer) noexcept;
+		FileObserver* getObserver() const noexcept;
+		bool setWriteBehind(const bool& enable, size_t high_water_mark = DFLT_WRITE_BEHIND_MARK) noexcept;
+		bool isWriteBehind() const noexcept;
 
 		static bool fileExists(const std::string& f_path) noexcept;
 		static void fixPath(string& path) noexcept;
+		static vector<retObj<file_meta>> statFiles(const vector<string>& paths) noexcept;
+		static io_stats getGlobalIOStats() noexcept;
+		static void resetGlobalIOStats() noexcept;
 		static string getFileName(const string& path) noexcept;
 		static string getFileExtenstion(const string& path) noexcept;
 		static retObj<time_t> getFileTime(const string& path) OS_KW_CONST
 		{
 #if defined(OS_LINUX) || defined(OS_MAC)
 			time_t timeOfFile = _getFileLastModificationTime(path.c_str());
-			return (timeOfFile) ? {.obj = timeOfFile, .errorObj = -1, .success = true} : {.obj = 0, .errorObj = 0, .success = false };
+			if (!timeOfFile) return { 0, ra_updatetimefile_fail };
+			return { timeOfFile, ra_succss };
 #elif defined(OS_WIN)
 			FILETIME timeOfFile = _getFileLastModificationTime(path.c_str());
-			if (timeOfFile.dwHighDateTime == 0 && timeOfFile.dwLowDateTime == 0) return { .obj = 0, ra_unknown_fail };
+			if (timeOfFile.dwHighDateTime == 0 && timeOfFile.dwLowDateTime == 0) return { 0, ra_unknown_fail };
 			ULARGE_INTEGER ulint;
 			ulint.LowPart = timeOfFile.dwLowDateTime;
 			ulint.HighPart = timeOfFile.dwHighDateTime;
-			return { .obj = (time_t)(ulint.QuadPart / 10000000ULL - 11644473600ULL), ra_succss };
+			return { (time_t)(ulint.QuadPart / 10000000ULL - 11644473600ULL), ra_succss };
 #else
-			return { .obj = 0, ra_unknown_fail };
+			return { 0, ra_unknown_fail };
 #endif
 		}
 	};
@@ -0,0 +1,597 @@
+#include "FileScanner.h"
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(FH_SCANNER_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(FH_SCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FH_SCANNER_AVX2
+#define FH_TARGET_AVX2 __attribute__((target("avx2")))
+#define FH_TARGET_SSSE3 __attribute__((target("ssse3")))
+#elif defined(FH_SCANNER_X86)
+#define FH_TARGET_SSSE3
+#endif
+
+namespace FileObj
+{
+	/*
+		The kernels behind the FileScanner functions, one set for every instruction set.
+	*/
+	struct scanner_kernels
+	{
+		size_t(*find_line_stop)(const char*, size_t) noexcept;
+		size_t(*filter_bytes)(char*, const char*, size_t, const char_filter&) noexcept;
+		size_t(*find_pair)(const char*, size_t, char, char, size_t) noexcept;
+		size_t(*count_byte)(const char*, size_t, char) noexcept;
+		void(*scan_bytes)(const char*, size_t, byte_counts&) noexcept;
+		const char* name;
+	};
+
+	/*
+		The shuffles that pack the kept bytes of 8 bytes to their start, by the mask of the kept bytes.
+	*/
+	struct compact_table
+	{
+		unsigned char shuffle[256][8];
+		unsigned char count[256];
+	};
+
+	static const compact_table& _getCompactTable() noexcept
+	{
+		static const compact_table table = []() -> compact_table
+		{
+			compact_table new_table {};
+
+			for (unsigned int mask = 0; mask < 256; mask++)
+			{
+				unsigned char count = 0;
+
+				for (unsigned char bit = 0; bit < 8; bit++)
+				{
+					if ((mask >> bit) & 1) { new_table.shuffle[mask][count++] = bit; }
+				}
+
+				new_table.count[mask] = count;
+				for (unsigned char rest = count; rest < 8; rest++) { new_table.shuffle[mask][rest] = 0x80; }
+			}
+
+			return new_table;
+		}();
+
+		return table;
+	}
+
+	static inline unsigned int _countTrailingZeros(unsigned int mask) noexcept
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index = 0;
+		_BitScanForward(&index, mask);
+		return (unsigned int)index;
+#else
+		return (unsigned int)__builtin_ctz(mask);
+#endif
+	}
+
+	static inline unsigned int _countBits(unsigned int mask) noexcept
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		return (unsigned int)__popcnt(mask);
+#else
+		return (unsigned int)__builtin_popcount(mask);
+#endif
+	}
+
+	static inline bool _isLineStop(const char ch) noexcept { return ch == '\n' || ch == '\r' || ch == '\0'; }
+
+	static size_t _findLineStopScalar(const char* data, size_t size) noexcept
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			if (_isLineStop(data[i])) { return i; }
+		}
+
+		return size;
+	}
+
+	static size_t _filterBytesScalar(char* dst, const char* src, size_t size, const char_filter& filter) noexcept
+	{
+		size_t out = 0;
+
+		for (size_t i = 0; i < size; i++) // Branchless: every byte is written and the place moves only if it is allowed
+		{
+			const char ch = src[i];
+			dst[out] = ch;
+			out += filter.allowed[(unsigned char)ch];
+		}
+
+		return out;
+	}
+
+	static size_t _findPairScalar(const char* data, size_t size, const char first, const char last, size_t distance) noexcept
+	{
+		for (size_t i = 0; i + distance < size; i++)
+		{
+			if (data[i] == first && data[i + distance] == last) { return i; }
+		}
+
+		return size;
+	}
+
+	static size_t _countByteScalar(const char* data, size_t size, const char ch) noexcept
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < size; i++) { count += data[i] == ch; }
+
+		return count;
+	}
+
+	static inline void _noteNewLine(byte_counts& counts, size_t pos, size_t& line_start) noexcept
+	{
+		if (counts.new_lines == 0) { counts.first_line = pos; }
+		else { counts.longest_line = std::max(counts.longest_line, pos - line_start); }
+
+		line_start = pos + 1;
+		counts.new_lines++;
+	}
+
+	/*
+		Scans the bytes from place i to the end, the vector kernels use it for the bytes after their last block.
+	*/
+	static void _scanBytesFrom(const char* data, size_t size, size_t i, byte_counts& counts, size_t& line_start) noexcept
+	{
+		for (; i < size; i++)
+		{
+			const char ch = data[i];
+
+			if (ch == '\n') { _noteNewLine(counts, i, line_start); }
+			else if (ch == '\0') { counts.nul_bytes++; }
+			else if (ch == '\r' && i + 1 < size && data[i + 1] == '\n') { counts.crlf_pairs++; }
+		}
+	}
+
+	static inline void _endScan(const char* data, size_t size, byte_counts& counts, size_t line_start) noexcept
+	{
+		counts.size = size;
+		if (counts.new_lines == 0) { counts.first_line = size; }
+		counts.last_line = size - line_start;
+		counts.first_char = size > 0 ? data[0] : '\0';
+		counts.last_char = size > 0 ? data[size - 1] : '\0';
+	}
+
+#if !defined(FH_SCANNER_X86)
+	static void _scanBytesScalar(const char* data, size_t size, byte_counts& counts) noexcept
+	{
+		size_t line_start = 0;
+		counts = byte_counts();
+
+		_scanBytesFrom(data, size, 0, counts, line_start);
+		_endScan(data, size, counts, line_start);
+	}
+#endif
+
+#if defined(FH_SCANNER_X86)
+	static size_t _findLineStopSSE2(const char* data, size_t size) noexcept
+	{
+		const __m128i new_line = _mm_set1_epi8('\n');
+		const __m128i carriage = _mm_set1_epi8('\r');
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+			const __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, new_line), _mm_cmpeq_epi8(block, carriage)), _mm_cmpeq_epi8(block, zero));
+			const unsigned int mask = (unsigned int)_mm_movemask_epi8(found);
+
+			if (mask) { return i + _countTrailingZeros(mask); }
+		}
+
+		return i + _findLineStopScalar(data + i, size - i);
+	}
+
+	/*
+		Compares every block with the first byte, and the block distance bytes after it with the last byte,
+			so only the places that have both are checked by the caller.
+	*/
+	static size_t _findPairSSE2(const char* data, size_t size, const char first, const char last, size_t distance) noexcept
+	{
+		const __m128i first_set = _mm_set1_epi8(first);
+		const __m128i last_set = _mm_set1_epi8(last);
+		size_t i = 0;
+
+		for (; i + distance + 16 <= size; i += 16)
+		{
+			const __m128i first_block = _mm_loadu_si128((const __m128i*)(data + i));
+			const __m128i last_block = _mm_loadu_si128((const __m128i*)(data + i + distance));
+			const unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_block, first_set), _mm_cmpeq_epi8(last_block, last_set)));
+
+			if (mask) { return i + _countTrailingZeros(mask); }
+		}
+
+		return i + _findPairScalar(data + i, size - i, first, last, distance);
+	}
+
+	/*
+		Every found byte subtracts -1 from its lane, and the lanes are summed before any of them can pass 255.
+	*/
+	static size_t _countByteSSE2(const char* data, size_t size, const char ch) noexcept
+	{
+		const __m128i ch_set = _mm_set1_epi8(ch);
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0, count = 0;
+
+		while (i + 16 <= size)
+		{
+			__m128i lanes = _mm_setzero_si128();
+			const size_t rounds = std::min<size_t>(255, (size - i) / 16);
+
+			for (size_t r = 0; r < rounds; r++, i += 16)
+			{
+				lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i)), ch_set));
+			}
+
+			const __m128i sums = _mm_sad_epu8(lanes, zero);
+			count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+		}
+
+		return count + _countByteScalar(data + i, size - i, ch);
+	}
+
+	/*
+		The pairs are found by comparing the block with '\r' and the block one byte after it with '\n',
+			the length of the lines is taken only at the found '\n', so most blocks cost a few compares and counts.
+	*/
+	static void _scanBytesSSE2(const char* data, size_t size, byte_counts& counts) noexcept
+	{
+		const __m128i new_line = _mm_set1_epi8('\n');
+		const __m128i carriage = _mm_set1_epi8('\r');
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0, line_start = 0;
+		counts = byte_counts();
+
+		for (; i + 17 <= size; i += 16)
+		{
+			const __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+			const __m128i next_block = _mm_loadu_si128((const __m128i*)(data + i + 1));
+			unsigned int lines_mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, new_line));
+
+			counts.nul_bytes += _countBits((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)));
+			counts.crlf_pairs += _countBits((unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block, carriage), _mm_cmpeq_epi8(next_block, new_line))));
+
+			for (; lines_mask; lines_mask &= lines_mask - 1) { _noteNewLine(counts, i + _countTrailingZeros(lines_mask), line_start); }
+		}
+
+		_scanBytesFrom(data, size, i, counts, line_start);
+		_endScan(data, size, counts, line_start);
+	}
+
+	/*
+		Packs the kept bytes of the block to the start of out and returns their amount.
+		--> Up to 16 bytes are written to out, so it must be at most at the block's place when filtering in place.
+	*/
+	FH_TARGET_SSSE3 static inline size_t _compactBlockSSSE3(char* out, const __m128i block, const unsigned int keep, const compact_table& table) noexcept
+	{
+		if (keep == 0xFFFF) { _mm_storeu_si128((__m128i*)out, block); return 16; }
+		if (keep == 0) { return 0; }
+
+		const unsigned int low = keep & 0xFF, high = keep >> 8;
+
+		_mm_storel_epi64((__m128i*)out, _mm_shuffle_epi8(block, _mm_loadl_epi64((const __m128i*)table.shuffle[low])));
+		const size_t count = table.count[low];
+		_mm_storel_epi64((__m128i*)(out + count), _mm_shuffle_epi8(_mm_srli_si128(block, 8), _mm_loadl_epi64((const __m128i*)table.shuffle[high])));
+
+		return count + table.count[high];
+	}
+
+	FH_TARGET_SSSE3 static size_t _filterBytesSSSE3(char* dst, const char* src, size_t size, const char_filter& filter) noexcept
+	{
+		const compact_table& table = _getCompactTable();
+		__m128i low[FILTER_MAX_RANGES], width[FILTER_MAX_RANGES];
+
+		for (unsigned int r = 0; r < filter.count; r++)
+		{
+			low[r] = _mm_set1_epi8((char)filter.low[r]);
+			width[r] = _mm_set1_epi8((char)(filter.high[r] - filter.low[r]));
+		}
+
+		size_t i = 0, out = 0;
+
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i block = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i drop = _mm_setzero_si128();
+
+			for (unsigned int r = 0; r < filter.count; r++) // (byte - low) <= (high - low) as unsigned means the byte is in the range
+			{
+				const __m128i diff = _mm_sub_epi8(block, low[r]);
+				drop = _mm_or_si128(drop, _mm_cmpeq_epi8(_mm_min_epu8(diff, width[r]), diff));
+			}
+
+			out += _compactBlockSSSE3(dst + out, block, ~(unsigned int)_mm_movemask_epi8(drop) & 0xFFFF, table);
+		}
+
+		return out + _filterBytesScalar(dst + out, src + i, size - i, filter);
+	}
+#endif
+
+#if defined(FH_SCANNER_AVX2)
+	FH_TARGET_AVX2 static size_t _findLineStopAVX2(const char* data, size_t size) noexcept
+	{
+		const __m256i new_line = _mm256_set1_epi8('\n');
+		const __m256i carriage = _mm256_set1_epi8('\r');
+		const __m256i zero = _mm256_setzero_si256();
+		size_t i = 0;
+
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i block = _mm256_loadu_si256((const __m256i*)(data + i));
+			const __m256i found = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, new_line), _mm256_cmpeq_epi8(block, carriage)), _mm256_cmpeq_epi8(block, zero));
+			const unsigned int mask = (unsigned int)_mm256_movemask_epi8(found);
+
+			if (mask) { return i + _countTrailingZeros(mask); }
+		}
+
+		return i + _findLineStopSSE2(data + i, size - i);
+	}
+
+	FH_TARGET_AVX2 static size_t _findPairAVX2(const char* data, size_t size, const char first, const char last, size_t distance) noexcept
+	{
+		const __m256i first_set = _mm256_set1_epi8(first);
+		const __m256i last_set = _mm256_set1_epi8(last);
+		size_t i = 0;
+
+		for (; i + distance + 32 <= size; i += 32)
+		{
+			const __m256i first_block = _mm256_loadu_si256((const __m256i*)(data + i));
+			const __m256i last_block = _mm256_loadu_si256((const __m256i*)(data + i + distance));
+			const unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first_block, first_set), _mm256_cmpeq_epi8(last_block, last_set)));
+
+			if (mask) { return i + _countTrailingZeros(mask); }
+		}
+
+		return i + _findPairSSE2(data + i, size - i, first, last, distance);
+	}
+
+	FH_TARGET_AVX2 static size_t _countByteAVX2(const char* data, size_t size, const char ch) noexcept
+	{
+		const __m256i ch_set = _mm256_set1_epi8(ch);
+		const __m256i zero = _mm256_setzero_si256();
+		size_t i = 0, count = 0;
+
+		while (i + 32 <= size)
+		{
+			__m256i lanes = _mm256_setzero_si256();
+			const size_t rounds = std::min<size_t>(255, (size - i) / 32);
+
+			for (size_t r = 0; r < rounds; r++, i += 32)
+			{
+				lanes = _mm256_sub_epi8(lanes, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), ch_set));
+			}
+
+			const __m256i wide_sums = _mm256_sad_epu8(lanes, zero);
+			const __m128i sums = _mm_add_epi64(_mm256_castsi256_si128(wide_sums), _mm256_extracti128_si256(wide_sums, 1));
+			count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+		}
+
+		return count + _countByteSSE2(data + i, size - i, ch);
+	}
+
+	FH_TARGET_AVX2 static void _scanBytesAVX2(const char* data, size_t size, byte_counts& counts) noexcept
+	{
+		const __m256i new_line = _mm256_set1_epi8('\n');
+		const __m256i carriage = _mm256_set1_epi8('\r');
+		const __m256i zero = _mm256_setzero_si256();
+		size_t i = 0, line_start = 0;
+		counts = byte_counts();
+
+		for (; i + 33 <= size; i += 32)
+		{
+			const __m256i block = _mm256_loadu_si256((const __m256i*)(data + i));
+			const __m256i next_block = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+			unsigned int lines_mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, new_line));
+
+			counts.nul_bytes += _countBits((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, zero)));
+			counts.crlf_pairs += _countBits((unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(block, carriage), _mm256_cmpeq_epi8(next_block, new_line))));
+
+			for (; lines_mask; lines_mask &= lines_mask - 1) { _noteNewLine(counts, i + _countTrailingZeros(lines_mask), line_start); }
+		}
+
+		_scanBytesFrom(data, size, i, counts, line_start);
+		_endScan(data, size, counts, line_start);
+	}
+
+	FH_TARGET_AVX2 static size_t _filterBytesAVX2(char* dst, const char* src, size_t size, const char_filter& filter) noexcept
+	{
+		const compact_table& table = _getCompactTable();
+		__m256i low[FILTER_MAX_RANGES], width[FILTER_MAX_RANGES];
+
+		for (unsigned int r = 0; r < filter.count; r++)
+		{
+			low[r] = _mm256_set1_epi8((char)filter.low[r]);
+			width[r] = _mm256_set1_epi8((char)(filter.high[r] - filter.low[r]));
+		}
+
+		size_t i = 0, out = 0;
+
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i block = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i drop = _mm256_setzero_si256();
+
+			for (unsigned int r = 0; r < filter.count; r++)
+			{
+				const __m256i diff = _mm256_sub_epi8(block, low[r]);
+				drop = _mm256_or_si256(drop, _mm256_cmpeq_epi8(_mm256_min_epu8(diff, width[r]), diff));
+			}
+
+			const unsigned int keep = ~(unsigned int)_mm256_movemask_epi8(drop);
+
+			if (keep == 0xFFFFFFFF) { _mm256_storeu_si256((__m256i*)(dst + out), block); out += 32; continue; }
+
+			out += _compactBlockSSSE3(dst + out, _mm256_castsi256_si128(block), keep & 0xFFFF, table);
+			out += _compactBlockSSSE3(dst + out, _mm256_extracti128_si256(block, 1), keep >> 16, table);
+		}
+
+		return out + _filterBytesSSSE3(dst + out, src + i, size - i, filter);
+	}
+#endif
+
+	/*
+		The function picks the kernels by the CPU, it is done only once.
+	*/
+	static const scanner_kernels& _getKernels() noexcept
+	{
+		static const scanner_kernels kernels = []() -> scanner_kernels
+		{
+#if defined(FH_SCANNER_AVX2)
+			if (__builtin_cpu_supports("avx2")) { return { _findLineStopAVX2, _filterBytesAVX2, _findPairAVX2, _countByteAVX2, _scanBytesAVX2, "avx2" }; }
+			if (__builtin_cpu_supports("ssse3")) { return { _findLineStopSSE2, _filterBytesSSSE3, _findPairSSE2, _countByteSSE2, _scanBytesSSE2, "ssse3" }; }
+#elif defined(FH_SCANNER_X86) && defined(_MSC_VER)
+			int cpu_info[4] = { 0 };
+			__cpuid(cpu_info, 1);
+			if (cpu_info[2] & (1 << 9)) { return { _findLineStopSSE2, _filterBytesSSSE3, _findPairSSE2, _countByteSSE2, _scanBytesSSE2, "ssse3" }; }
+#endif
+#if defined(FH_SCANNER_X86)
+			return { _findLineStopSSE2, _filterBytesScalar, _findPairSSE2, _countByteSSE2, _scanBytesSSE2, "sse2" };
+#else
+			return { _findLineStopScalar, _filterBytesScalar, _findPairScalar, _countByteScalar, _scanBytesScalar, "scalar" };
+#endif
+		}();
+
+		return kernels;
+	}
+
+	/*
+		The function finds the first '\n', '\r' or '\0' in the data.
+		@ Returns the place of the found char or size if there is none.
+		@ It is a static function.
+	*/
+	size_t FileScanner::findLineStop(const char* data, size_t size) noexcept
+	{
+		return _getKernels().find_line_stop(data, size);
+	}
+
+	/*
+		The function compiles the table of the allowed bytes into the ranges of bytes to drop.
+		@ If there are more than FILTER_MAX_RANGES ranges, the filter uses the table byte by byte.
+		@ It is a static function.
+	*/
+	void FileScanner::compileFilter(char_filter& filter, const bool* allowed) noexcept
+	{
+		filter.count = 0;
+		filter.use_table = false;
+		filter.allowed = allowed;
+
+		for (unsigned int ch = 0; ch < 256; ch++)
+		{
+			if (allowed[ch]) { continue; }
+
+			unsigned int last = ch;
+			while (last + 1 < 256 && !allowed[last + 1]) { last++; }
+
+			if (filter.count == FILTER_MAX_RANGES) { filter.use_table = true; return; }
+
+			filter.low[filter.count] = (unsigned char)ch;
+			filter.high[filter.count] = (unsigned char)last;
+			filter.count++;
+			ch = last;
+		}
+	}
+
+	/*
+		The function copies the allowed bytes of src to dst, and returns their amount.
+		@ dst can be src to filter in place, else it must have place for size bytes.
+		@ It is a static function.
+	*/
+	size_t FileScanner::filterBytes(char* dst, const char* src, size_t size, const char_filter& filter) noexcept
+	{
+		if (filter.count == 0)
+		{
+			if (dst != src) { memmove(dst, src, size); }
+			return size;
+		}
+
+		if (filter.use_table) { return _filterBytesScalar(dst, src, size, filter); }
+
+		return _getKernels().filter_bytes(dst, src, size, filter);
+	}
+
+	/*
+		The function finds the first place where first is, and last is distance bytes after it (both inside the data).
+		@ Checking two bytes of a pattern (its first and last) drops almost every place that doesn't match it, so only few places are compared fully.
+		@ Returns the found place or size if there is none.
+		@ It is a static function.
+	*/
+	size_t FileScanner::findPair(const char* data, size_t size, const char first, const char last, size_t distance) noexcept
+	{
+		return _getKernels().find_pair(data, size, first, last, distance);
+	}
+
+	/*
+		The function returns the amount of times the byte is in the data.
+		@ It is a static function.
+	*/
+	size_t FileScanner::countByte(const char* data, size_t size, const char ch) noexcept
+	{
+		return _getKernels().count_byte(data, size, ch);
+	}
+
+	/*
+		The function counts the line ends, "\r\n" pairs and '\0' of the data, and finds its longest line.
+		@ counts is filled only with this data, parts of a file are joined with mergeCounts.
+		@ It is a static function.
+	*/
+	void FileScanner::scanBytes(const char* data, size_t size, byte_counts& counts) noexcept
+	{
+		_getKernels().scan_bytes(data, size, counts);
+	}
+
+	/*
+		The function adds the counts of the part that comes right after the counted part, the line that goes on between them is joined.
+		@ It is a static function.
+	*/
+	void FileScanner::mergeCounts(byte_counts& counts, const byte_counts& next) noexcept
+	{
+		if (next.size == 0) { return; }
+		if (counts.size == 0) { counts = next; return; }
+
+		counts.crlf_pairs += next.crlf_pairs + (counts.last_char == '\r' && next.first_char == '\n');
+		counts.nul_bytes += next.nul_bytes;
+
+		if (next.new_lines == 0)
+		{
+			if (counts.new_lines == 0) { counts.first_line += next.size; }
+			counts.last_line += next.size;
+		}
+		else
+		{
+			const size_t joined = counts.last_line + next.first_line; // The line that goes on between the parts
+
+			if (counts.new_lines == 0) { counts.first_line = joined; }
+			else { counts.longest_line = std::max(counts.longest_line, joined); }
+
+			counts.longest_line = std::max(counts.longest_line, next.longest_line);
+			counts.last_line = next.last_line;
+		}
+
+		counts.new_lines += next.new_lines;
+		counts.size += next.size;
+		counts.last_char = next.last_char;
+	}
+
+	/*
+		The function returns the name of the instruction set that the kernels use ("avx2", "sse2" or "scalar").
+		@ It is a static function.
+	*/
+	const char* FileScanner::getKernelName() noexcept
+	{
+		return _getKernels().name;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FH_SCANNER_X86
+#endif
+
+#define FILTER_MAX_RANGES			8
+
+namespace FileObj
+{
+	typedef struct char_filter // A compiled ignoring table
+	{
+		unsigned char low[FILTER_MAX_RANGES]; // The ranges of bytes to drop, both sides included
+		unsigned char high[FILTER_MAX_RANGES];
+		unsigned int count; // Amount of ranges, 0 means nothing is dropped
+		bool use_table; // Too many ranges for the vector kernels, so the table is used byte by byte
+		const bool* allowed; // The table of the allowed bytes (MAX_CHAR_CAPACITY places)
+	} char_filter;
+
+	typedef struct byte_counts // What scanBytes found in a part of a file, parts that follow each other are joined by mergeCounts
+	{
+		size_t size;
+		size_t new_lines; // Amount of '\n'
+		size_t crlf_pairs; // Amount of '\r' right before '\n'
+		size_t nul_bytes;
+		size_t first_line; // Bytes before the first '\n', all the bytes if there is none (its start may be in the part before)
+		size_t longest_line; // The longest line between two '\n' of the part, without the '\n'
+		size_t last_line; // Bytes after the last '\n' (its end may be in the part after)
+		char first_char;
+		char last_char;
+	} byte_counts;
+
+	/*
+		Block scanning and filtering kernels for the file handlers.
+		@ Every kernel has SSE2 and AVX2 versions that are picked once at run time by the CPU's support,
+			and a simple byte by byte version for other CPUs.
+		@ The filter kernels need SSSE3 for the compaction, so on SSE2 only CPUs they use the table version.
+		--> AVX2 is used only when building with GCC or Clang.
+	*/
+	class FileScanner
+	{
+	public:
+		static size_t findLineStop(const char* data, size_t size) noexcept;
+		static void compileFilter(char_filter& filter, const bool* allowed) noexcept;
+		static size_t filterBytes(char* dst, const char* src, size_t size, const char_filter& filter) noexcept;
+		static size_t findPair(const char* data, size_t size, const char first, const char last, size_t distance) noexcept;
+		static size_t countByte(const char* data, size_t size, const char ch) noexcept;
+		static void scanBytes(const char* data, size_t size, byte_counts& counts) noexcept;
+		static void mergeCounts(byte_counts& counts, const byte_counts& next) noexcept;
+		static const char* getKernelName() noexcept;
+	};
+}
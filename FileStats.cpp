@@ -0,0 +1,422 @@
+#include "FileStats.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+
+#define STATS_RELAXED				std::memory_order_relaxed
+
+namespace FileObj
+{
+	static const char* const _call_names[(size_t)statCall::count] = { "readInto", "readFromFile", "getLine", "getLines", "readAt", "view",
+		"writeToFile", "writeBatch", "writeAt", "flushFile", "readAsync", "writeAsync", "readLineAsync", "FileLineReader", "find", "scanStats" };
+	static const char* const _latency_names[(size_t)statLatency::count] = { "Read", "Write", "GetLine", "Flush" };
+
+	/*
+		The function returns the kind of latency a call is kept in, or statLatency::count if its latency isn't kept.
+		@ Calls that are made of other counted calls (like readFromFile of readInto) aren't kept, so nothing is timed twice.
+	*/
+	static inline statLatency _getCallLatency(const statCall& call) noexcept
+	{
+		switch (call)
+		{
+		case statCall::read_into: case statCall::read_at: { return statLatency::read; }
+		case statCall::write_to_file: case statCall::write_batch: case statCall::write_at: { return statLatency::write; }
+		case statCall::get_line: { return statLatency::get_line; }
+		case statCall::flush: { return statLatency::flush; }
+		default: { return statLatency::count; }
+		}
+	}
+
+	static inline void _addStats(io_stats& to, const io_stats& from) noexcept
+	{
+		to.bytes_read += from.bytes_read;
+		to.bytes_written += from.bytes_written;
+		to.bytes_filtered += from.bytes_filtered;
+		for (size_t i = 0; i < (size_t)statCall::count; i++) { to.calls[i] += from.calls[i]; }
+		to.seeks += from.seeks;
+		to.flushes += from.flushes;
+		to.syscalls += from.syscalls;
+		to.lock_waits += from.lock_waits;
+		to.lock_wait_ns += from.lock_wait_ns;
+
+		for (size_t kind = 0; kind < (size_t)statLatency::count; kind++)
+		{
+			for (size_t i = 0; i < STATS_HIST_BUCKETS; i++) { to.latencies[kind].buckets[i] += from.latencies[kind].buckets[i]; }
+			to.latencies[kind].count += from.latencies[kind].count;
+			to.latencies[kind].total_ns += from.latencies[kind].total_ns;
+			to.latencies[kind].max_ns = std::max(to.latencies[kind].max_ns, from.latencies[kind].max_ns);
+		}
+	}
+
+	/*
+		The counters of all the threads, the global counters are their sum.
+		@ It is never destroyed, so threads that end at the exit of the program can still give their counters back.
+	*/
+	struct stats_registry
+	{
+		mutex registry_mutex;
+		vector<FileStats*> live; // The counters of the running threads
+		io_stats retired = {}; // The counters of the threads that ended
+		FileStats closed; // Counts what comes after the counters of a thread are gone
+	};
+
+	static stats_registry& _getRegistry() noexcept
+	{
+		static stats_registry* registry = new stats_registry();
+		return *registry;
+	}
+
+	/*
+		The counters of one thread, they are put in the registry while the thread runs.
+	*/
+	struct thread_stats_slot
+	{
+		FileStats stats;
+		bool registered = false;
+
+		thread_stats_slot() noexcept;
+		~thread_stats_slot();
+	};
+
+	static thread_local thread_stats_slot _thread_stats;
+	static thread_local bool _thread_stats_closed = false; // Handlers destroyed at the exit of the thread may come after the slot
+
+	thread_stats_slot::thread_stats_slot() noexcept
+	{
+		try
+		{
+			stats_registry& registry = _getRegistry();
+			lock_guard<mutex> lock(registry.registry_mutex);
+
+			registry.live.push_back(&this->stats);
+			this->registered = true;
+		}
+		catch (...) {}
+	}
+
+	thread_stats_slot::~thread_stats_slot()
+	{
+		_thread_stats_closed = true;
+
+		stats_registry& registry = _getRegistry();
+		lock_guard<mutex> lock(registry.registry_mutex);
+
+		this->stats.addTo(registry.retired);
+		if (this->registered) { std::erase(registry.live, &this->stats); }
+	}
+
+	/*
+		The function returns the upper bound of the latencies that the value percent of the calls didn't pass.
+	*/
+	unsigned long long latency_histogram::percentile(double percent) const noexcept
+	{
+		if (this->count == 0) { return 0; }
+
+		percent = std::clamp(percent, 0.0, 100.0);
+		const unsigned long long wanted = std::max(1ULL, (unsigned long long)std::ceil(percent / 100.0 * (double)this->count));
+		unsigned long long seen = 0;
+
+		for (unsigned int bucket = 0; bucket < STATS_HIST_BUCKETS; bucket++)
+		{
+			seen += this->buckets[bucket];
+			if (seen >= wanted) { return std::min(FileStats::getBucketLimit(bucket), this->max_ns); }
+		}
+
+		return this->max_ns;
+	}
+
+	/*
+		The function returns the average latency.
+	*/
+	unsigned long long latency_histogram::mean() const noexcept { return this->count == 0 ? 0 : this->total_ns / this->count; }
+
+	ostream& operator<<(ostream& os, const io_stats& stats)
+	{
+		os << "\t-- I/O: " << stats.bytes_read << " bytes read, " << stats.bytes_written << " bytes written, " << stats.bytes_filtered << " bytes ignored" <<
+			"\n\t-- Seeks: " << stats.seeks << " - Flushes: " << stats.flushes << " - System calls: " << stats.syscalls <<
+			"\n\t-- Lock waits: " << stats.lock_waits << " (" << stats.lock_wait_ns / 1000 << " us)" << "\n\t-- Calls:";
+
+		bool any_call = false;
+
+		for (size_t i = 0; i < (size_t)statCall::count; i++)
+		{
+			if (stats.calls[i] == 0) { continue; }
+
+			os << " " << _call_names[i] << "=" << stats.calls[i];
+			any_call = true;
+		}
+
+		if (!any_call) { os << " None"; }
+		os << std::endl;
+
+		for (size_t kind = 0; kind < (size_t)statLatency::count; kind++)
+		{
+			const latency_histogram& histogram = stats.latencies[kind];
+			if (histogram.count == 0) { continue; }
+
+			os << "\t-- " << _latency_names[kind] << " latency (us): count=" << histogram.count << " mean=" << histogram.mean() / 1000.0 <<
+				" p50=" << histogram.percentile(50) / 1000.0 << " p99=" << histogram.percentile(99) / 1000.0 <<
+				" p99.9=" << histogram.percentile(99.9) / 1000.0 << " max=" << histogram.max_ns / 1000.0 << std::endl;
+		}
+
+		return os;
+	}
+
+	/*
+		The function constructs the counters, all at 0.
+	*/
+	FileStats::FileStats() noexcept { this->reset(); }
+
+	/*
+		The function adds the counters into the given snapshot.
+	*/
+	void FileStats::addTo(io_stats& stats) const noexcept
+	{
+		io_stats own = {};
+
+		own.bytes_read = this->bytes_read.load(STATS_RELAXED);
+		own.bytes_written = this->bytes_written.load(STATS_RELAXED);
+		own.bytes_filtered = this->bytes_filtered.load(STATS_RELAXED);
+		for (size_t i = 0; i < (size_t)statCall::count; i++) { own.calls[i] = this->calls[i].load(STATS_RELAXED); }
+		own.seeks = this->seeks.load(STATS_RELAXED);
+		own.flushes = this->flushes.load(STATS_RELAXED);
+		own.syscalls = this->syscalls.load(STATS_RELAXED);
+		own.lock_waits = this->lock_waits.load(STATS_RELAXED);
+		own.lock_wait_ns = this->lock_wait_ns.load(STATS_RELAXED);
+
+		for (size_t kind = 0; kind < (size_t)statLatency::count; kind++)
+		{
+			for (size_t i = 0; i < STATS_HIST_BUCKETS; i++) { own.latencies[kind].buckets[i] = this->hist_buckets[kind][i].load(STATS_RELAXED); }
+			own.latencies[kind].count = this->hist_count[kind].load(STATS_RELAXED);
+			own.latencies[kind].total_ns = this->hist_total_ns[kind].load(STATS_RELAXED);
+			own.latencies[kind].max_ns = this->hist_max_ns[kind].load(STATS_RELAXED);
+		}
+
+		_addStats(stats, own);
+	}
+
+	/*
+		The function puts one latency in its histogram.
+	*/
+	void FileStats::addLatency(const statLatency& kind, unsigned long long ns) noexcept
+	{
+		const size_t index = (size_t)kind;
+
+		this->hist_buckets[index][getBucket(ns)].fetch_add(1, STATS_RELAXED);
+		this->hist_count[index].fetch_add(1, STATS_RELAXED);
+		this->hist_total_ns[index].fetch_add(ns, STATS_RELAXED);
+
+		unsigned long long curr_max = this->hist_max_ns[index].load(STATS_RELAXED);
+		while (ns > curr_max && !this->hist_max_ns[index].compare_exchange_weak(curr_max, ns, STATS_RELAXED)) {}
+	}
+
+	/*
+		The function returns the counters of the calling thread.
+		@ It is a static function.
+	*/
+	FileStats& FileStats::getThreadStats() noexcept
+	{
+		if (_thread_stats_closed) { return _getRegistry().closed; }
+		return _thread_stats.stats;
+	}
+
+	/*
+		The function takes a snapshot of the counters.
+	*/
+	io_stats FileStats::snapshot() const noexcept
+	{
+		io_stats stats = {};
+		this->addTo(stats);
+
+		return stats;
+	}
+
+	/*
+		The function sets all the counters back to 0.
+	*/
+	void FileStats::reset() noexcept
+	{
+		this->bytes_read.store(0, STATS_RELAXED);
+		this->bytes_written.store(0, STATS_RELAXED);
+		this->bytes_filtered.store(0, STATS_RELAXED);
+		for (auto& call : this->calls) { call.store(0, STATS_RELAXED); }
+		this->seeks.store(0, STATS_RELAXED);
+		this->flushes.store(0, STATS_RELAXED);
+		this->syscalls.store(0, STATS_RELAXED);
+		this->lock_waits.store(0, STATS_RELAXED);
+		this->lock_wait_ns.store(0, STATS_RELAXED);
+
+		for (size_t kind = 0; kind < (size_t)statLatency::count; kind++)
+		{
+			for (auto& bucket : this->hist_buckets[kind]) { bucket.store(0, STATS_RELAXED); }
+			this->hist_count[kind].store(0, STATS_RELAXED);
+			this->hist_total_ns[kind].store(0, STATS_RELAXED);
+			this->hist_max_ns[kind].store(0, STATS_RELAXED);
+		}
+	}
+
+	/*
+		The function counts one call and its latency, in the given counters (if there are) and in the counters of the thread.
+		@ It is a static function.
+	*/
+	void FileStats::countCall(FileStats* stats, const statCall& call, unsigned long long ns) noexcept
+	{
+		const statLatency kind = _getCallLatency(call);
+		FileStats& thread_stats = getThreadStats();
+
+		if (stats != nullptr)
+		{
+			stats->calls[(size_t)call].fetch_add(1, STATS_RELAXED);
+			if (kind != statLatency::count) { stats->addLatency(kind, ns); }
+		}
+
+		thread_stats.calls[(size_t)call].fetch_add(1, STATS_RELAXED);
+		if (kind != statLatency::count) { thread_stats.addLatency(kind, ns); }
+	}
+
+	/*
+		The function counts bytes that were read.
+		@ It is a static function.
+	*/
+	void FileStats::countRead(FileStats* stats, size_t bytes) noexcept
+	{
+		if (stats != nullptr) { stats->bytes_read.fetch_add(bytes, STATS_RELAXED); }
+		getThreadStats().bytes_read.fetch_add(bytes, STATS_RELAXED);
+	}
+
+	/*
+		The function counts bytes that were written.
+		@ It is a static function.
+	*/
+	void FileStats::countWrite(FileStats* stats, size_t bytes) noexcept
+	{
+		if (stats != nullptr) { stats->bytes_written.fetch_add(bytes, STATS_RELAXED); }
+		getThreadStats().bytes_written.fetch_add(bytes, STATS_RELAXED);
+	}
+
+	/*
+		The function counts bytes that the ignoring table dropped.
+		@ It is a static function.
+	*/
+	void FileStats::countFiltered(FileStats* stats, size_t bytes) noexcept
+	{
+		if (bytes == 0) { return; }
+
+		if (stats != nullptr) { stats->bytes_filtered.fetch_add(bytes, STATS_RELAXED); }
+		getThreadStats().bytes_filtered.fetch_add(bytes, STATS_RELAXED);
+	}
+
+	/*
+		The function counts one seek of the stream.
+		@ It is a static function.
+	*/
+	void FileStats::countSeek(FileStats* stats) noexcept
+	{
+		if (stats != nullptr) { stats->seeks.fetch_add(1, STATS_RELAXED); }
+		getThreadStats().seeks.fetch_add(1, STATS_RELAXED);
+	}
+
+	/*
+		The function counts one flush of the stream.
+		@ It is a static function.
+	*/
+	void FileStats::countFlush(FileStats* stats) noexcept
+	{
+		if (stats != nullptr) { stats->flushes.fetch_add(1, STATS_RELAXED); }
+		getThreadStats().flushes.fetch_add(1, STATS_RELAXED);
+	}
+
+	/*
+		The function counts system calls.
+		@ It is a static function.
+	*/
+	void FileStats::countSyscall(FileStats* stats, unsigned int amount) noexcept
+	{
+		if (stats != nullptr) { stats->syscalls.fetch_add(amount, STATS_RELAXED); }
+		getThreadStats().syscalls.fetch_add(amount, STATS_RELAXED);
+	}
+
+	/*
+		The function counts one wait for the lock of a handler.
+		@ It is a static function.
+	*/
+	void FileStats::countLockWait(FileStats* stats, unsigned long long ns) noexcept
+	{
+		if (stats != nullptr)
+		{
+			stats->lock_waits.fetch_add(1, STATS_RELAXED);
+			stats->lock_wait_ns.fetch_add(ns, STATS_RELAXED);
+		}
+
+		FileStats& thread_stats = getThreadStats();
+		thread_stats.lock_waits.fetch_add(1, STATS_RELAXED);
+		thread_stats.lock_wait_ns.fetch_add(ns, STATS_RELAXED);
+	}
+
+	/*
+		The function returns the sum of the counters of all the threads, the ones running and the ones that ended.
+		@ It is a static function.
+	*/
+	io_stats FileStats::getGlobalStats() noexcept
+	{
+		stats_registry& registry = _getRegistry();
+		lock_guard<mutex> lock(registry.registry_mutex);
+
+		io_stats stats = registry.retired;
+
+		for (const FileStats* thread_stats : registry.live) { thread_stats->addTo(stats); }
+		registry.closed.addTo(stats);
+
+		return stats;
+	}
+
+	/*
+		The function sets the counters of all the threads back to 0.
+		@ It is a static function.
+	*/
+	void FileStats::resetGlobalStats() noexcept
+	{
+		stats_registry& registry = _getRegistry();
+		lock_guard<mutex> lock(registry.registry_mutex);
+
+		registry.retired = {};
+
+		for (FileStats* thread_stats : registry.live) { thread_stats->reset(); }
+		registry.closed.reset();
+	}
+
+	/*
+		The function returns the bucket of a latency: values below 2^STATS_HIST_SUB_BITS have their own buckets, and every
+			power of 2 above is split into 2^STATS_HIST_SUB_BITS buckets.
+		@ It is a static function.
+	*/
+	unsigned int FileStats::getBucket(unsigned long long ns) noexcept
+	{
+		constexpr unsigned long long sub_buckets = 1ULL << STATS_HIST_SUB_BITS;
+
+		if (ns < sub_buckets) { return (unsigned int)ns; }
+
+		const unsigned int shift = (unsigned int)std::bit_width(ns) - 1 - STATS_HIST_SUB_BITS;
+		if (shift >= STATS_HIST_MAGNITUDES) { return STATS_HIST_BUCKETS - 1; }
+
+		return ((shift + 1) << STATS_HIST_SUB_BITS) + (unsigned int)((ns >> shift) & (sub_buckets - 1));
+	}
+
+	/*
+		The function returns the biggest latency that is put in the bucket.
+		@ It is a static function.
+	*/
+	unsigned long long FileStats::getBucketLimit(unsigned int bucket) noexcept
+	{
+		constexpr unsigned long long sub_buckets = 1ULL << STATS_HIST_SUB_BITS;
+
+		if (bucket < sub_buckets) { return bucket; }
+
+		const unsigned int shift = (bucket >> STATS_HIST_SUB_BITS) - 1;
+		const unsigned long long lower = (sub_buckets + (bucket & (sub_buckets - 1))) << shift;
+
+		return lower + (1ULL << shift) - 1;
+	}
+}
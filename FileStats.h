@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+using std::ostream;
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+
+#define STATS_HIST_SUB_BITS			3 // 8 buckets for every power of 2, so a value is known within 12.5%
+#define STATS_HIST_MAGNITUDES		40 // Up to 2^40 ns (about 18 minutes), longer calls are put in the last bucket
+#define STATS_HIST_BUCKETS			((STATS_HIST_MAGNITUDES + 1) << STATS_HIST_SUB_BITS)
+
+namespace FileObj
+{
+	/*
+		The calls of a file handler that are counted.
+	*/
+	enum class statCall
+	{
+		read_into, read_from_file, get_line, get_lines, read_at, view,
+		write_to_file, write_batch, write_at, flush,
+		read_async, write_async, read_line_async, line_reader, find, scan_stats,
+		count // The amount of the calls, not a call
+	};
+
+	/*
+		The kinds of calls whose latency is kept in a histogram.
+	*/
+	enum class statLatency
+	{
+		read, write, get_line, flush,
+		count // The amount of the kinds, not a kind
+	};
+
+	typedef struct latency_histogram // Log-linear histogram of latencies (like HDR histograms), in nanoseconds
+	{
+		unsigned long long buckets[STATS_HIST_BUCKETS];
+		unsigned long long count;
+		unsigned long long total_ns;
+		unsigned long long max_ns;
+
+		unsigned long long percentile(double percent) const noexcept; // The upper bound of the bucket of the percentile
+		unsigned long long mean() const noexcept;
+	} latency_histogram;
+
+	typedef struct io_stats // A snapshot of the counters of a handler, or of all the handlers
+	{
+		unsigned long long bytes_read;
+		unsigned long long bytes_written;
+		unsigned long long bytes_filtered; // Bytes dropped by the ignoring table
+		unsigned long long calls[(size_t)statCall::count]; // By statCall
+		unsigned long long seeks;
+		unsigned long long flushes;
+		unsigned long long syscalls; // System calls made by the handler itself (the reads and writes of the stream aren't seen)
+		unsigned long long lock_waits;
+		unsigned long long lock_wait_ns;
+		latency_histogram latencies[(size_t)statLatency::count]; // By statLatency
+
+		friend ostream& operator<<(ostream& os, const io_stats& stats);
+	} io_stats;
+
+	/*
+		Always-on counters of file I/O: bytes, calls, seeks, flushes, system calls, lock waits and latency histograms.
+		@ Every handler has its own counters, and everything is also counted in the counters of the calling thread,
+			which are summed together into the global counters. So the global counters are never shared between threads.
+		@ The counters are relaxed atomics, a snapshot taken while others count isn't one exact point in time.
+	*/
+	class FileStats
+	{
+	private:
+		std::atomic<unsigned long long> bytes_read;
+		std::atomic<unsigned long long> bytes_written;
+		std::atomic<unsigned long long> bytes_filtered;
+		std::atomic<unsigned long long> calls[(size_t)statCall::count];
+		std::atomic<unsigned long long> seeks;
+		std::atomic<unsigned long long> flushes;
+		std::atomic<unsigned long long> syscalls;
+		std::atomic<unsigned long long> lock_waits;
+		std::atomic<unsigned long long> lock_wait_ns;
+		std::atomic<unsigned long long> hist_buckets[(size_t)statLatency::count][STATS_HIST_BUCKETS];
+		std::atomic<unsigned long long> hist_count[(size_t)statLatency::count];
+		std::atomic<unsigned long long> hist_total_ns[(size_t)statLatency::count];
+		std::atomic<unsigned long long> hist_max_ns[(size_t)statLatency::count];
+
+		friend struct thread_stats_slot;
+
+		void addTo(io_stats& stats) const noexcept;
+		void addLatency(const statLatency& kind, unsigned long long ns) noexcept;
+
+		static FileStats& getThreadStats() noexcept;
+
+	public:
+		FileStats() noexcept;
+
+		FileStats(const FileStats& other) = delete;
+		FileStats(FileStats&& other) = delete;
+		FileStats& operator=(const FileStats& other) = delete;
+		FileStats& operator=(FileStats&& other) = delete;
+
+		io_stats snapshot() const noexcept;
+		void reset() noexcept;
+
+		static void countCall(FileStats* stats, const statCall& call, unsigned long long ns) noexcept;
+		static void countRead(FileStats* stats, size_t bytes) noexcept;
+		static void countWrite(FileStats* stats, size_t bytes) noexcept;
+		static void countFiltered(FileStats* stats, size_t bytes) noexcept;
+		static void countSeek(FileStats* stats) noexcept;
+		static void countFlush(FileStats* stats) noexcept;
+		static void countSyscall(FileStats* stats, unsigned int amount = 1) noexcept;
+		static void countLockWait(FileStats* stats, unsigned long long ns) noexcept;
+
+		static io_stats getGlobalStats() noexcept;
+		static void resetGlobalStats() noexcept;
+		static unsigned int getBucket(unsigned long long ns) noexcept;
+		static unsigned long long getBucketLimit(unsigned int bucket) noexcept;
+	};
+
+	/*
+		Times one call of a handler, and counts it with its latency when it ends.
+	*/
+	class FileStatsTimer
+	{
+	private:
+		FileStats* stats;
+		statCall call;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		FileStatsTimer(FileStats* stats, const statCall& call) noexcept : stats(stats), call(call), start(std::chrono::steady_clock::now()) {}
+		~FileStatsTimer() { FileStats::countCall(this->stats, this->call, (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start).count()); }
+
+		FileStatsTimer(const FileStatsTimer& other) = delete;
+		FileStatsTimer& operator=(const FileStatsTimer& other) = delete;
+	};
+}
@@ -0,0 +1,346 @@
+#include "FileTrace.h"
+
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <new>
+
+#if defined(__unix__) || defined(__unix) || defined(__linux__) || defined(__APPLE__) || defined(__MACH__)
+#include <unistd.h>
+#define TRACE_GET_PID()				((long)getpid())
+#else
+#define TRACE_GET_PID()				1L
+#endif
+
+namespace FileObj
+{
+	static const char* const _op_names[(size_t)traceOp::count] = { "open", "read", "write", "seek", "flush", "lock", "task" };
+
+	static std::atomic<FileObserver*> _global_observer{ nullptr };
+	static std::atomic<unsigned int> _next_thread_id{ 1 };
+	static std::atomic<unsigned long long> _next_sink_serial{ 1 };
+
+	/*
+		The sink the current thread wrote into last, and its buffer there, so only a thread's first event in a sink looks for its buffer.
+	*/
+	static thread_local unsigned long long _cached_sink_serial = 0;
+	static thread_local void* _cached_sink_buffer = nullptr;
+
+	static inline unsigned long long _getTraceTime() noexcept
+	{
+		return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/*
+		The function writes the string as a JSON string.
+	*/
+	static void _writeJsonString(std::ostream& os, const string& str)
+	{
+		os << '"';
+
+		for (char ch : str)
+		{
+			if (ch == '"' || ch == '\\') { os << '\\' << ch; }
+			else if ((unsigned char)ch < 0x20) { char code[8]; snprintf(code, sizeof(code), "\\u%04x", (unsigned char)ch); os << code; }
+			else { os << ch; }
+		}
+
+		os << '"';
+	}
+
+	/*
+		The function sets the observer that every handler gets when it is made, nullptr stops the tracing of new handlers.
+		--> Handlers that were already made keep their observer, it is changed with FileHandler::setObserver.
+		@ It is a static function.
+	*/
+	void FileObserver::setGlobalObserver(FileObserver* observer) noexcept
+	{
+		_global_observer.store(observer, std::memory_order_release);
+	}
+
+	/*
+		The function returns the observer that every handler gets when it is made.
+		@ It is a static function.
+	*/
+	FileObserver* FileObserver::getGlobalObserver() noexcept
+	{
+		return _global_observer.load(std::memory_order_acquire);
+	}
+
+	/*
+		The function returns the number of the current thread, threads are numbered from 1 by the order of their first traced event.
+		@ It is a static function.
+	*/
+	unsigned int FileObserver::getThreadId() noexcept
+	{
+		static thread_local unsigned int thread_id = _next_thread_id.fetch_add(1, std::memory_order_relaxed);
+		return thread_id;
+	}
+
+	/*
+		The function returns the name of the operation.
+		@ It is a static function.
+	*/
+	const char* FileObserver::getOpName(const traceOp& op) noexcept
+	{
+		return (size_t)op < (size_t)traceOp::count ? _op_names[(size_t)op] : "unknown";
+	}
+
+	/*
+		The function fills the event and tells the observer the operation began.
+		--> Kept out of the header, so the code without an observer stays small.
+	*/
+	void FileTraceScope::begin(const traceOp& op, const string* path, long offset, size_t size) noexcept
+	{
+		this->event = { op, path, offset, size, FileObserver::getThreadId(), _getTraceTime(), 0 };
+		this->observer->onBegin(this->event);
+	}
+
+	/*
+		The function tells the observer the operation ended.
+	*/
+	void FileTraceScope::end() noexcept
+	{
+		this->event.end_ns = _getTraceTime();
+		this->observer->onEnd(this->event);
+	}
+
+	/*
+		The function constructs a FileTraceSink object, the times of the events are written from the time it was made.
+	*/
+	FileTraceSink::FileTraceSink(size_t max_events) noexcept : serial(_next_sink_serial.fetch_add(1, std::memory_order_relaxed)), origin_ns(_getTraceTime()),
+		max_events(max_events), dropped(0)
+	{
+		try { this->paths.push_back(""); } // Id 0 is no path
+		catch (...) {}
+	}
+
+	/*
+		The function destructs the FileTraceSink object, and frees the buffers of all the threads.
+	*/
+	FileTraceSink::~FileTraceSink()
+	{
+		for (std::unique_ptr<thread_buffer>& buffer : this->buffers)
+		{
+			trace_chunk* chunk = buffer->head;
+
+			while (chunk != nullptr)
+			{
+				trace_chunk* next = chunk->next.load(std::memory_order_relaxed);
+				delete chunk;
+				chunk = next;
+			}
+		}
+	}
+
+	/*
+		The function returns the buffer of the current thread in the sink, and makes it on the thread's first event.
+		@ Returns nullptr if there is no memory for it.
+	*/
+	FileTraceSink::thread_buffer* FileTraceSink::getThreadBuffer() noexcept
+	{
+		if (_cached_sink_serial == this->serial) { return (thread_buffer*)_cached_sink_buffer; }
+
+		const unsigned int thread_id = FileObserver::getThreadId();
+		thread_buffer* found = nullptr;
+
+		{
+			lock_guard<mutex> lock(this->buffers_mutex);
+
+			for (std::unique_ptr<thread_buffer>& buffer : this->buffers)
+			{
+				if (buffer->thread_id == thread_id) { found = buffer.get(); break; }
+			}
+
+			if (found == nullptr)
+			{
+				try
+				{
+					std::unique_ptr<thread_buffer> buffer(new thread_buffer{ nullptr, nullptr, 0, thread_id, "", 0 });
+					buffer->head = buffer->tail = new trace_chunk(); // The first block is made here, so writeTrace sees it under the lock
+					buffer->head->used = 0;
+					buffer->head->next = nullptr;
+
+					found = buffer.get();
+					this->buffers.push_back(std::move(buffer));
+				}
+				catch (...) { return nullptr; }
+			}
+		}
+
+		_cached_sink_serial = this->serial;
+		_cached_sink_buffer = found;
+
+		return found;
+	}
+
+	/*
+		The function returns the id of the path in the sink.
+		@ The id of the thread's last path is kept in its buffer, so the shared table is locked only when a thread moves to another file.
+	*/
+	unsigned int FileTraceSink::getPathId(thread_buffer& buffer, const string* path) noexcept
+	{
+		if (path == nullptr || path->empty()) { return 0; }
+		if (buffer.last_path_id != 0 && buffer.last_path == *path) { return buffer.last_path_id; }
+
+		try
+		{
+			unsigned int path_id = 0;
+
+			{
+				lock_guard<mutex> lock(this->paths_mutex);
+
+				auto place = this->path_ids.find(*path);
+
+				if (place != this->path_ids.end()) { path_id = place->second; }
+				else
+				{
+					path_id = (unsigned int)this->paths.size();
+					this->paths.push_back(*path);
+					this->path_ids.emplace(*path, path_id);
+				}
+			}
+
+			buffer.last_path = *path;
+			buffer.last_path_id = path_id;
+
+			return path_id;
+		}
+		catch (...) { return 0; }
+	}
+
+	/*
+		The function does nothing, the sink writes every operation when it ends.
+	*/
+	void FileTraceSink::onBegin(const trace_event& event) noexcept
+	{
+		(void)event;
+	}
+
+	/*
+		The function adds the ended operation into the buffer of the current thread.
+		@ The record is written first and only then counted as used, so writeTrace never reads a record that is being written.
+	*/
+	void FileTraceSink::onEnd(const trace_event& event) noexcept
+	{
+		thread_buffer* buffer = this->getThreadBuffer();
+		if (buffer == nullptr || buffer->events >= this->max_events) { this->dropped.fetch_add(1, std::memory_order_relaxed); return; }
+
+		trace_chunk* chunk = buffer->tail;
+		size_t used = chunk->used.load(std::memory_order_relaxed);
+
+		if (used == TRACE_CHUNK_EVENTS)
+		{
+			trace_chunk* next = new (std::nothrow) trace_chunk();
+			if (next == nullptr) { this->dropped.fetch_add(1, std::memory_order_relaxed); return; }
+
+			next->used.store(0, std::memory_order_relaxed);
+			next->next.store(nullptr, std::memory_order_relaxed);
+			chunk->next.store(next, std::memory_order_release);
+
+			buffer->tail = chunk = next;
+			used = 0;
+		}
+
+		chunk->records[used] = { event.start_ns, event.end_ns - event.start_ns, event.offset, event.size, this->getPathId(*buffer, event.path), event.thread_id, event.op };
+		chunk->used.store(used + 1, std::memory_order_release);
+		buffer->events++;
+	}
+
+	/*
+		The function writes all the operations kept until now as Chrome trace-event JSON into the stream.
+		@ The records are copied first, so the threads that trace aren't stopped while the JSON is written.
+	*/
+	bool FileTraceSink::writeTrace(std::ostream& os) noexcept
+	{
+		try
+		{
+			vector<trace_record> records;
+
+			{
+				lock_guard<mutex> lock(this->buffers_mutex);
+
+				for (std::unique_ptr<thread_buffer>& buffer : this->buffers)
+				{
+					for (trace_chunk* chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire))
+					{
+						const size_t used = chunk->used.load(std::memory_order_acquire);
+						records.insert(records.end(), chunk->records, chunk->records + used);
+					}
+				}
+			}
+
+			vector<string> paths_copy;
+
+			{
+				lock_guard<mutex> lock(this->paths_mutex); // Taken after the records, so every path id in them is known
+				paths_copy = this->paths;
+			}
+
+			const long pid = TRACE_GET_PID();
+			char times[64];
+
+			os << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":" << this->getDroppedCount() << "},\"traceEvents\":[";
+
+			for (size_t i = 0; i < records.size(); i++)
+			{
+				const trace_record& record = records[i];
+				const unsigned long long start = record.start_ns > this->origin_ns ? record.start_ns - this->origin_ns : 0;
+
+				snprintf(times, sizeof(times), "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu", start / 1000, start % 1000, record.duration_ns / 1000, record.duration_ns % 1000);
+
+				os << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << FileObserver::getOpName(record.op) << "\",\"cat\":\"file\",\"ph\":\"X\"," << times <<
+					",\"pid\":" << pid << ",\"tid\":" << record.thread_id << ",\"args\":{\"path\":";
+				_writeJsonString(os, record.path_id < paths_copy.size() ? paths_copy[record.path_id] : string());
+				os << ",\"offset\":" << record.offset << ",\"size\":" << record.size << "}}";
+			}
+
+			os << "\n]}\n";
+
+			return (bool)os;
+		}
+		catch (...) { return false; }
+	}
+
+	/*
+		The function writes all the operations kept until now as Chrome trace-event JSON into the file at the path.
+	*/
+	bool FileTraceSink::writeTrace(const string& path) noexcept
+	{
+		try
+		{
+			std::ofstream out(path, std::ios::out | std::ios::trunc);
+			if (!out) { return false; }
+
+			return this->writeTrace(out) && (bool)out.flush();
+		}
+		catch (...) { return false; }
+	}
+
+	/*
+		The function returns the amount of operations kept until now.
+	*/
+	size_t FileTraceSink::getEventCount() noexcept
+	{
+		lock_guard<mutex> lock(this->buffers_mutex);
+		size_t count = 0;
+
+		for (std::unique_ptr<thread_buffer>& buffer : this->buffers)
+		{
+			for (trace_chunk* chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire))
+			{
+				count += chunk->used.load(std::memory_order_acquire);
+			}
+		}
+
+		return count;
+	}
+
+	/*
+		The function returns the amount of operations that weren't kept, since a thread reached the most events or there was no memory.
+	*/
+	unsigned long long FileTraceSink::getDroppedCount() const noexcept
+	{
+		return this->dropped.load(std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+using std::string;
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+
+#define TRACE_CHUNK_EVENTS			1024 // Events in every block of a thread's buffer
+#define DFLT_TRACE_MAX_EVENTS		1048576 // Events kept for every thread, later events are dropped and counted
+#define TRACE_NO_OFFSET				-1
+
+namespace FileObj
+{
+	/*
+		The operations of a file handler that are traced.
+		open --> Opening a file.
+		read / write --> A read or a write call (size is the bytes asked, and the bytes done when it ends).
+		seek / flush --> Moving the cursor of the stream, or flushing its buffer.
+		lock --> Waiting for the lock of a thread safe handler (only when it was taken by others).
+		task --> A task of a worker thread, like a pass over the file of getLines (size is the amount of lines of the task).
+	*/
+	enum class traceOp
+	{
+		open, read, write, seek, flush, lock, task,
+		count // The amount of the operations, not an operation
+	};
+
+	typedef struct trace_event // One traced operation, as the observer gets it
+	{
+		traceOp op;
+		const string* path; // nullptr if the operation has no file, valid only inside the callback
+		long offset; // TRACE_NO_OFFSET if the operation is at the cursor of the file
+		size_t size;
+		unsigned int thread_id; // A small number of the thread, see FileObserver::getThreadId
+		unsigned long long start_ns; // steady_clock time
+		unsigned long long end_ns; // 0 in onBegin
+	} trace_event;
+
+	/*
+		Gets a callback when every traced operation of a file handler begins and ends.
+		@ The callbacks are called on the thread of the operation, inside the lock of the handler, so they should be short.
+		--> The observer must live as long as the handlers that use it!
+	*/
+	class FileObserver
+	{
+	public:
+		virtual ~FileObserver() = default;
+
+		virtual void onBegin(const trace_event& event) noexcept = 0;
+		virtual void onEnd(const trace_event& event) noexcept = 0;
+
+		static void setGlobalObserver(FileObserver* observer) noexcept;
+		static FileObserver* getGlobalObserver() noexcept;
+		static unsigned int getThreadId() noexcept;
+		static const char* getOpName(const traceOp& op) noexcept;
+	};
+
+	/*
+		Traces one operation, if there is an observer.
+		@ Without an observer the only cost is one check of the pointer in the constructor and in the destructor.
+	*/
+	class FileTraceScope
+	{
+	private:
+		FileObserver* observer;
+		trace_event event;
+
+		void begin(const traceOp& op, const string* path, long offset, size_t size) noexcept;
+		void end() noexcept;
+
+	public:
+		FileTraceScope(FileObserver* observer, const traceOp& op, const string* path, long offset = TRACE_NO_OFFSET, size_t size = 0) noexcept : observer(observer)
+		{
+			if (observer != nullptr) [[unlikely]] { this->begin(op, path, offset, size); }
+		}
+		~FileTraceScope() { if (this->observer != nullptr) [[unlikely]] { this->end(); } }
+
+		FileTraceScope(const FileTraceScope& other) = delete;
+		FileTraceScope& operator=(const FileTraceScope& other) = delete;
+
+		void setSize(size_t size) noexcept { this->event.size = size; } // The bytes that were done, given to onEnd
+	};
+
+	/*
+		An observer that keeps the traced operations, and writes them as Chrome trace-event JSON (opened by chrome://tracing and Perfetto).
+		@ Every thread writes into its own buffer without locking, only the first event of a thread in the sink takes a lock.
+		@ Every operation is written as one complete ("X") event with its file, offset and size.
+		--> The sink must live as long as the handlers that use it, writeTrace can be called while they run.
+	*/
+	class FileTraceSink : public FileObserver
+	{
+	private:
+		typedef struct trace_record
+		{
+			unsigned long long start_ns;
+			unsigned long long duration_ns;
+			long offset;
+			size_t size;
+			unsigned int path_id;
+			unsigned int thread_id;
+			traceOp op;
+		} trace_record;
+
+		typedef struct trace_chunk
+		{
+			trace_record records[TRACE_CHUNK_EVENTS];
+			std::atomic<size_t> used; // Written by the owner thread only, read by writeTrace
+			std::atomic<trace_chunk*> next;
+		} trace_chunk;
+
+		typedef struct thread_buffer // Used only by its thread, except for reading the written records
+		{
+			trace_chunk* head;
+			trace_chunk* tail;
+			size_t events;
+			unsigned int thread_id;
+			string last_path; // The path of the last event, most events of a thread are on the same file
+			unsigned int last_path_id;
+		} thread_buffer;
+
+		const unsigned long long serial; // Tells the sinks apart for the threads' caches, even at the same address
+		const unsigned long long origin_ns;
+		const size_t max_events;
+		std::atomic<unsigned long long> dropped;
+		vector<std::unique_ptr<thread_buffer>> buffers;
+		mutex buffers_mutex;
+		vector<string> paths; // By id, 0 is no path
+		std::unordered_map<string, unsigned int> path_ids;
+		mutex paths_mutex;
+
+		thread_buffer* getThreadBuffer() noexcept;
+		unsigned int getPathId(thread_buffer& buffer, const string* path) noexcept;
+
+	public:
+		FileTraceSink(size_t max_events = DFLT_TRACE_MAX_EVENTS) noexcept;
+		~FileTraceSink();
+
+		FileTraceSink(const FileTraceSink& other) = delete;
+		FileTraceSink(FileTraceSink&& other) = delete;
+		FileTraceSink& operator=(const FileTraceSink& other) = delete;
+		FileTraceSink& operator=(FileTraceSink&& other) = delete;
+
+		void onBegin(const trace_event& event) noexcept override;
+		void onEnd(const trace_event& event) noexcept override;
+
+		bool writeTrace(const string& path) noexcept;
+		bool writeTrace(std::ostream& os) noexcept;
+		size_t getEventCount() noexcept;
+		unsigned long long getDroppedCount() const noexcept;
+	};
+}
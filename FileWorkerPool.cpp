@@ -0,0 +1,162 @@
+#include "FileWorkerPool.h"
+
+#include <atomic>
+#include <memory>
+
+namespace FileObj
+{
+	/*
+		The function constructs the pool and starts its workers.
+		@ If no amount of workers is given, one worker is started for every hardware thread.
+	*/
+	FileWorkerPool::FileWorkerPool(unsigned int workers_count) : stopping(false)
+	{
+		if (workers_count == 0) { workers_count = thread::hardware_concurrency(); }
+		if (workers_count == 0) { workers_count = 1; }
+
+		this->workers.reserve(workers_count);
+
+		for (unsigned int i = 0; i < workers_count; i++)
+		{
+			this->workers.emplace_back(&FileWorkerPool::workerLoop, this);
+		}
+	}
+
+	/*
+		The function stops the workers after they finish all the tasks that were already given.
+	*/
+	FileWorkerPool::~FileWorkerPool()
+	{
+		{
+			unique_lock<mutex> lock(this->tasks_mutex);
+			this->stopping = true;
+		}
+
+		this->tasks_cv.notify_all();
+
+		for (thread& worker : this->workers)
+		{
+			if (worker.joinable()) { worker.join(); }
+		}
+	}
+
+	/*
+		The function is the loop of every worker, it runs tasks until the pool is stopped.
+	*/
+	void FileWorkerPool::workerLoop() noexcept
+	{
+		while (true)
+		{
+			function<void()> task;
+
+			{
+				unique_lock<mutex> lock(this->tasks_mutex);
+				this->tasks_cv.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+
+				if (this->tasks.empty()) { return; }
+
+				task = std::move(this->tasks.front());
+				this->tasks.pop_front();
+			}
+
+			try { task(); }
+			catch (...) {} // A task that throws can't be allowed to kill the worker
+		}
+	}
+
+	/*
+		The function adds a task to the pool, which will be run by the first free worker.
+	*/
+	bool FileWorkerPool::addTask(function<void()>&& task) noexcept
+	{
+		if (!task) { return false; }
+
+		try
+		{
+			unique_lock<mutex> lock(this->tasks_mutex);
+			if (this->stopping) { return false; }
+			this->tasks.push_back(std::move(task));
+		}
+		catch (...) { return false; }
+
+		this->tasks_cv.notify_one();
+
+		return true;
+	}
+
+	/*
+		The function runs task(0) ... task(count - 1) on the pool and waits for all of them to end.
+		@ The calling thread works on the tasks too, so calling it from inside a task can't get stuck.
+		--> The first exception thrown by a task is thrown again here after all the tasks ended.
+	*/
+	void FileWorkerPool::runTasks(size_t count, const function<void(size_t)>& task)
+	{
+		if (count == 0) { return; }
+		if (count == 1) { task(0); return; }
+
+		struct batch_data
+		{
+			std::atomic<size_t> next{ 0 };
+			std::atomic<size_t> done{ 0 };
+			size_t count = 0;
+			const function<void(size_t)>* task = nullptr;
+			std::exception_ptr error;
+			mutex batch_mutex;
+			condition_variable batch_cv;
+		};
+
+		auto batch = std::make_shared<batch_data>();
+		batch->count = count;
+		batch->task = &task;
+
+		auto work = [](const std::shared_ptr<batch_data>& data)
+		{
+			size_t index = 0;
+
+			while ((index = data->next.fetch_add(1)) < data->count)
+			{
+				try { (*data->task)(index); }
+				catch (...)
+				{
+					unique_lock<mutex> lock(data->batch_mutex);
+					if (!data->error) { data->error = std::current_exception(); }
+				}
+
+				if (data->done.fetch_add(1) + 1 == data->count)
+				{
+					unique_lock<mutex> lock(data->batch_mutex);
+					data->batch_cv.notify_all();
+				}
+			}
+		};
+
+		size_t helpers = std::min(count - 1, this->workers.size());
+
+		for (size_t i = 0; i < helpers; i++)
+		{
+			this->addTask([batch, work]() { work(batch); });
+		}
+
+		work(batch);
+
+		unique_lock<mutex> lock(batch->batch_mutex);
+		batch->batch_cv.wait(lock, [&batch]() { return batch->done.load() == batch->count; });
+
+		if (batch->error) { std::rethrow_exception(batch->error); }
+	}
+
+	/*
+		The function returns the amount of workers in the pool.
+	*/
+	unsigned int FileWorkerPool::getWorkersCount() const noexcept { return (unsigned int)this->workers.size(); }
+
+	/*
+		The function returns the pool that is shared by all the file handlers.
+		@ It is a static function.
+	*/
+	FileWorkerPool& FileWorkerPool::getSharedPool()
+	{
+		static FileWorkerPool shared_pool;
+		return shared_pool;
+	}
+}
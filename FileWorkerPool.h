@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using std::vector;
+using std::deque;
+using std::function;
+using std::thread;
+using std::mutex;
+using std::unique_lock;
+using std::condition_variable;
+
+namespace FileObj
+{
+	/*
+		A fixed group of worker threads that runs the tasks given to it.
+		@ The same pool is meant to be shared between all the file handlers (see getSharedPool), so
+			no thread is created per request.
+	*/
+	class FileWorkerPool
+	{
+	private:
+		vector<thread> workers;
+		deque<function<void()>> tasks;
+		mutex tasks_mutex;
+		condition_variable tasks_cv;
+		bool stopping;
+
+		void workerLoop() noexcept;
+
+	public:
+		FileWorkerPool(unsigned int workers_count = 0);
+		~FileWorkerPool();
+
+		FileWorkerPool(const FileWorkerPool& other) = delete;
+		FileWorkerPool(FileWorkerPool&& other) = delete;
+		FileWorkerPool& operator=(const FileWorkerPool& other) = delete;
+		FileWorkerPool& operator=(FileWorkerPool&& other) = delete;
+
+		bool addTask(function<void()>&& task) noexcept;
+		void runTasks(size_t count, const function<void(size_t)>& task);
+		unsigned int getWorkersCount() const noexcept;
+
+		static FileWorkerPool& getSharedPool();
+	};
+}
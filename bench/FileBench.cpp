@@ -0,0 +1,748 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <memory>
+
+#include "FileHandler.h"
+
+using std::string;
+using std::vector;
+using std::ostream;
+using FileObj::FileHandler;
+using FileObj::FileHandlerException;
+using FileObj::openFileModes;
+using FileObj::bufferType;
+using FileObj::retObj;
+using FileObj::ra_succss;
+
+#define BENCH_DFLT_FILE_MB			16
+#define BENCH_DFLT_LINE_MIN			8
+#define BENCH_DFLT_LINE_MAX			160
+#define BENCH_DFLT_OPS				20000
+#define BENCH_DFLT_BATCH			64
+#define BENCH_DFLT_SEED				1234
+#define BENCH_READ_CHUNK			4096
+#define BENCH_MAP_REDUCE_PASSES		5
+#define BENCH_DFLT_BUFFERS			{ 512, 4096, 65536 }
+
+namespace FileBench
+{
+	/*
+		How the lengths of the lines of the generated file are spread between the shortest and the longest line.
+		fixed --> Every line is as long as the longest line.
+		uniform --> Every length between the two is as likely.
+		exp --> Most lines are short and few are long (like logs), the mean is a quarter of the way.
+	*/
+	enum class lineDist
+	{
+		fixed, uniform, exp
+	};
+
+	typedef struct bench_config // The options of a run
+	{
+		string dir;
+		size_t file_mb;
+		size_t line_min;
+		size_t line_max;
+		lineDist dist;
+		size_t ops; // Most operations of every benchmark (the sequential reads stop at the end of the file)
+		size_t batch; // Lines asked in every getLineMultiThreaded call
+		vector<size_t> buffer_sizes;
+		unsigned int seed;
+		string label; // Kept in the output to tell runs apart, like the commit that was measured
+		string out_path;
+		string only; // Runs only the benchmarks whose name has it
+		string trace_path; // Traces every operation into a Chrome trace-event file
+	} bench_config;
+
+	typedef struct bench_file // The generated file
+	{
+		string path;
+		size_t size;
+		vector<long> offsets; // The start of every line, and the end of the file last
+		vector<string> sample_lines; // Lines that are written by the write benchmarks
+	} bench_file;
+
+	typedef struct bench_result // The measures of one benchmark with one buffer
+	{
+		string name;
+		string buffer_type;
+		size_t buffer_size;
+		size_t ops;
+		size_t bytes;
+		double seconds;
+		double p50_us;
+		double p99_us;
+		bool ok;
+	} bench_result;
+
+	/*
+		Keeps the latency of every operation of a benchmark, and the total time of all of them.
+	*/
+	class LatencyRecorder
+	{
+	private:
+		vector<unsigned long long> samples;
+		std::chrono::steady_clock::time_point op_start;
+		std::chrono::steady_clock::time_point run_start;
+		double run_seconds;
+
+	public:
+		LatencyRecorder(size_t expected) : run_seconds(0) { this->samples.reserve(expected); this->run_start = std::chrono::steady_clock::now(); }
+
+		void start() noexcept { this->op_start = std::chrono::steady_clock::now(); }
+		void stop()
+		{
+			this->samples.push_back((unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->op_start).count());
+		}
+		void end() noexcept { this->run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->run_start).count(); }
+
+		size_t count() const noexcept { return this->samples.size(); }
+		double seconds() const noexcept { return this->run_seconds; }
+		double percentileUs(double percent)
+		{
+			if (this->samples.empty()) { return 0; }
+
+			size_t place = std::min(this->samples.size() - 1, (size_t)(percent / 100.0 * (double)this->samples.size()));
+			std::nth_element(this->samples.begin(), this->samples.begin() + place, this->samples.end());
+
+			return (double)this->samples[place] / 1000.0;
+		}
+	};
+
+	/*
+		The function returns the name of the buffer type, as it is written in the output.
+	*/
+	static const char* getBufferName(const bufferType& buff_type) noexcept
+	{
+		switch (buff_type)
+		{
+		case bufferType::non_buffer: { return "non_buffer"; }
+		case bufferType::line_buffer: { return "line_buffer"; }
+		case bufferType::full_buffer: { return "full_buffer"; }
+		}
+
+		return "unknown";
+	}
+
+	/*
+		The function returns the name of the line lengths spread, as it is written in the output.
+	*/
+	static const char* getDistName(const lineDist& dist) noexcept
+	{
+		switch (dist)
+		{
+		case lineDist::fixed: { return "fixed"; }
+		case lineDist::uniform: { return "uniform"; }
+		case lineDist::exp: { return "exp"; }
+		}
+
+		return "unknown";
+	}
+
+	/*
+		The function writes the string as a JSON string.
+	*/
+	static void writeJsonString(ostream& os, const string& str)
+	{
+		os << '"';
+
+		for (char ch : str)
+		{
+			switch (ch)
+			{
+			case '"': { os << "\\\""; break; }
+			case '\\': { os << "\\\\"; break; }
+			case '\n': { os << "\\n"; break; }
+			case '\t': { os << "\\t"; break; }
+			default:
+			{
+				if ((unsigned char)ch < 0x20) { char code[8]; snprintf(code, sizeof(code), "\\u%04x", (unsigned char)ch); os << code; }
+				else { os << ch; }
+			}
+			}
+		}
+
+		os << '"';
+	}
+
+	/*
+		The function generates the file of the benchmarks, with random printable lines that are spread by the config.
+		@ The file is written without FileHandler, so the generation doesn't depend on the code that is measured.
+	*/
+	static bool generateFile(const bench_config& config, bench_file& file)
+	{
+		std::mt19937_64 rng(config.seed);
+		std::uniform_int_distribution<size_t> uniform_len(config.line_min, config.line_max);
+		std::exponential_distribution<double> exp_len(4.0 / (double)std::max<size_t>(1, config.line_max - config.line_min));
+		std::uniform_int_distribution<int> char_pick(0, 62);
+		static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+
+		FILE* out = fopen(file.path.c_str(), "wb");
+		if (out == NULL) { return false; }
+
+		const size_t wanted = config.file_mb * 1024 * 1024;
+		string line;
+		file.size = 0;
+		file.offsets.clear();
+		file.sample_lines.clear();
+
+		while (file.size < wanted)
+		{
+			size_t len = config.line_max;
+			if (config.dist == lineDist::uniform) { len = uniform_len(rng); }
+			else if (config.dist == lineDist::exp) { len = std::min(config.line_max, config.line_min + (size_t)exp_len(rng)); }
+
+			line.resize(len + 1);
+			for (size_t i = 0; i < len; i++) { line[i] = chars[char_pick(rng)]; }
+			line[len] = '\n';
+
+			if (fwrite(line.data(), sizeof(char), line.size(), out) != line.size()) { fclose(out); return false; }
+
+			file.offsets.push_back((long)file.size);
+			file.size += line.size();
+			if (file.sample_lines.size() < 4096) { file.sample_lines.push_back(line); }
+		}
+
+		file.offsets.push_back((long)file.size);
+
+		return fclose(out) == 0;
+	}
+
+	/*
+		The function makes the result of a benchmark from its recorded latencies.
+	*/
+	static bench_result makeResult(const string& name, const bufferType& buff_type, size_t buff_size, LatencyRecorder& recorder, size_t bytes, bool ok)
+	{
+		return { name, getBufferName(buff_type), buff_type == bufferType::non_buffer ? 0 : buff_size, recorder.count(), bytes,
+			recorder.seconds(), recorder.percentileUs(50), recorder.percentileUs(99), ok };
+	}
+
+	/*
+		The function runs all the benchmarks with one buffer type and size, and adds their results.
+	*/
+	static void runBuffer(const bench_config& config, const bench_file& file, const bufferType& buff_type, size_t buff_size, vector<bench_result>& results)
+	{
+		const size_t lines = file.offsets.size() - 1;
+		const string write_path = file.path + ".out";
+		std::mt19937_64 rng(config.seed + buff_size);
+		std::uniform_int_distribution<unsigned int> line_pick(0, (unsigned int)lines - 1);
+
+		auto wanted = [&](const char* name) { return config.only.empty() || string(name).find(config.only) != string::npos; };
+		auto report = [&](const bench_result& result)
+		{
+			std::cerr << result.name << " [" << result.buffer_type << " " << result.buffer_size << "]: " << result.ops << " ops in " << result.seconds << " s" << std::endl;
+			results.push_back(result);
+		};
+
+		if (wanted("getline_seq")) // getLine of every line by its position, like reading the file line after line
+		{
+			FileHandler handler(file.path, openFileModes::read_b, false, buff_type, buff_size);
+			LatencyRecorder recorder(std::min(config.ops, lines));
+			size_t bytes = 0;
+			bool ok = true;
+
+			for (size_t i = 0; i < lines && i < config.ops && ok; i++)
+			{
+				recorder.start();
+				retObj<string> line = handler.getLine(0, (int)file.offsets[i]);
+				recorder.stop();
+
+				ok = line.statusObj == ra_succss;
+				bytes += line.obj.size() + 1;
+			}
+
+			recorder.end();
+			report(makeResult("getline_seq", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("getline_rand")) // getLine of random lines by their number, through the line index
+		{
+			FileHandler handler(file.path, openFileModes::read_b, false, buff_type, buff_size);
+			bool ok = handler.buildLineIndex();
+			LatencyRecorder recorder(config.ops);
+			size_t bytes = 0;
+
+			for (size_t i = 0; i < config.ops && ok; i++)
+			{
+				unsigned int numline = line_pick(rng);
+
+				recorder.start();
+				retObj<string> line = handler.getLine(numline);
+				recorder.stop();
+
+				ok = line.statusObj == ra_succss;
+				bytes += line.obj.size() + 1;
+			}
+
+			recorder.end();
+			report(makeResult("getline_rand", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("stream_in")) // operator>> line after line from the start of the file
+		{
+			FileHandler handler(file.path, openFileModes::read_b, false, buff_type, buff_size);
+			LatencyRecorder recorder(std::min(config.ops, lines));
+			string line;
+			size_t bytes = 0;
+			bool ok = true;
+
+			try
+			{
+				for (size_t i = 0; i < lines && i < config.ops; i++)
+				{
+					line.clear();
+
+					recorder.start();
+					handler >> line;
+					recorder.stop();
+
+					bytes += line.size();
+				}
+			}
+			catch (const FileHandlerException&) { ok = false; }
+
+			recorder.end();
+			report(makeResult("stream_in", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("read_chunks")) // readFromFile of the whole file in chunks
+		{
+			FileHandler handler(file.path, openFileModes::read_b, false, buff_type, buff_size);
+			LatencyRecorder recorder(file.size / BENCH_READ_CHUNK + 1);
+			size_t bytes = 0;
+			bool ok = true;
+
+			while (bytes < file.size && ok)
+			{
+				recorder.start();
+				retObj<string> data = handler.readFromFile(BENCH_READ_CHUNK, NON_WORK, false);
+				recorder.stop();
+
+				ok = data.statusObj == ra_succss && !data.obj.empty();
+				bytes += std::min(data.obj.size(), file.size - bytes);
+			}
+
+			recorder.end();
+			report(makeResult("read_chunks", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("read_chunks_ignore")) // Like read_chunks, with the digits and the spaces ignored
+		{
+			FileHandler handler(file.path, openFileModes::read_b, false, buff_type, buff_size);
+			FileObj::ignore_data ignoring;
+			ignoring.ignore_signle_chars.push_back(' ');
+			ignoring.ignore_range_chars.push_back({ '0', '9' });
+			bool ok = handler.setIgnoring(ignoring);
+			LatencyRecorder recorder(file.size / BENCH_READ_CHUNK + 1);
+			size_t bytes = 0;
+
+			for (size_t i = 0; i * BENCH_READ_CHUNK < file.size && ok; i++)
+			{
+				recorder.start();
+				retObj<string> data = handler.readFromFile(BENCH_READ_CHUNK, NON_WORK, false);
+				recorder.stop();
+
+				ok = data.statusObj == ra_succss;
+				bytes += std::min((size_t)BENCH_READ_CHUNK, file.size - i * BENCH_READ_CHUNK); // The bytes read from the file, not the bytes kept
+			}
+
+			recorder.end();
+			report(makeResult("read_chunks_ignore", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("write_lines")) // writeToFile of lines into a new file, the flush at the end is counted in the time
+		{
+			bench_result result;
+
+			{
+				FileHandler handler(write_path, openFileModes::write_b, false, buff_type, buff_size);
+				LatencyRecorder recorder(config.ops);
+				size_t bytes = 0;
+				bool ok = true;
+
+				for (size_t i = 0; i < config.ops && ok; i++)
+				{
+					const string& line = file.sample_lines[i % file.sample_lines.size()];
+
+					recorder.start();
+					ok = handler.writeToFile(line);
+					recorder.stop();
+
+					bytes += line.size();
+				}
+
+				ok = handler.flushFile() && ok;
+				recorder.end();
+				result = makeResult("write_lines", buff_type, buff_size, recorder, bytes, ok);
+			}
+
+			report(result);
+		}
+
+		if (wanted("stream_out")) // operator<< of lines into a new file, the flush at the end is counted in the time
+		{
+			bench_result result;
+
+			{
+				FileHandler handler(write_path, openFileModes::write_b, false, buff_type, buff_size);
+				LatencyRecorder recorder(config.ops);
+				size_t bytes = 0;
+				bool ok = true;
+
+				try
+				{
+					for (size_t i = 0; i < config.ops; i++)
+					{
+						const string& line = file.sample_lines[i % file.sample_lines.size()];
+
+						recorder.start();
+						handler << line;
+						recorder.stop();
+
+						bytes += line.size();
+					}
+				}
+				catch (const FileHandlerException&) { ok = false; }
+
+				ok = handler.flushFile() && ok;
+				recorder.end();
+				result = makeResult("stream_out", buff_type, buff_size, recorder, bytes, ok);
+			}
+
+			report(result);
+		}
+
+		if (wanted("getline_mt")) // getLineMultiThreaded of batches of random lines, through the line index
+		{
+			FileHandler handler(file.path, openFileModes::read_b, true, buff_type, buff_size);
+			bool ok = handler.buildLineIndex();
+			const size_t calls = std::max<size_t>(1, config.ops / std::max<size_t>(1, config.batch));
+			LatencyRecorder recorder(calls);
+			vector<std::pair<unsigned int, int>> lines_pos(config.batch);
+			size_t bytes = 0;
+
+			for (size_t i = 0; i < calls && ok; i++)
+			{
+				for (std::pair<unsigned int, int>& line_pos : lines_pos) { line_pos = { line_pick(rng), NON_WORK }; }
+
+				retObj<std::map<std::pair<unsigned int, int>, retObj<string>>> lines_data;
+
+				recorder.start();
+				handler.getLineMultiThreaded(lines_data, lines_pos);
+				recorder.stop();
+
+				ok = lines_data.statusObj == ra_succss;
+				for (const auto& line : lines_data.obj) { bytes += line.second.obj.size() + 1; }
+			}
+
+			recorder.end();
+			report(makeResult("getline_mt", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("map_reduce") && buff_type == bufferType::non_buffer) // mapReduceLines counting the bytes of all the lines, it reads with pread so the buffer doesn't matter
+		{
+			FileHandler handler(file.path, openFileModes::read_b, true, buff_type, buff_size);
+			LatencyRecorder recorder(BENCH_MAP_REDUCE_PASSES);
+			size_t bytes = 0;
+			bool ok = true;
+
+			for (size_t i = 0; i < BENCH_MAP_REDUCE_PASSES && ok; i++)
+			{
+				recorder.start();
+				retObj<size_t> total = handler.mapReduceLines([](size_t& partial, string_view line) { partial += line.size() + 1; },
+					[](size_t& all, size_t&& partial) { all += partial; }, (size_t)0);
+				recorder.stop();
+
+				ok = total.statusObj == ra_succss;
+				bytes += file.size;
+			}
+
+			recorder.end();
+			report(makeResult("map_reduce", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("find") && buff_type == bufferType::non_buffer) // find of literal patterns, and of a regex on every line, over the whole file
+		{
+			for (const bool regex : { false, true })
+			{
+				FileHandler handler(file.path, openFileModes::read_b, true, buff_type, buff_size);
+				const vector<string> patterns = regex ? vector<string>{ "[0-9]{3}[a-f]" } : vector<string>{ "abc", "Zz9", "hello" };
+				FileObj::find_options options;
+				options.regex = regex;
+				LatencyRecorder recorder(BENCH_MAP_REDUCE_PASSES);
+				size_t bytes = 0;
+				bool ok = true;
+
+				for (size_t i = 0; i < BENCH_MAP_REDUCE_PASSES && ok; i++)
+				{
+					recorder.start();
+					retObj<size_t> found = handler.find(patterns, [](const FileObj::find_match&) { return true; }, options);
+					recorder.stop();
+
+					ok = found.statusObj == ra_succss;
+					bytes += file.size;
+				}
+
+				recorder.end();
+				report(makeResult(regex ? "find_regex" : "find_literal", buff_type, buff_size, recorder, bytes, ok));
+			}
+		}
+
+		if (wanted("scan_stats") && buff_type == bufferType::non_buffer) // scanStats of the whole file, scanned again every pass instead of taken from its cache
+		{
+			FileHandler handler(file.path, openFileModes::read_b, true, buff_type, buff_size);
+			LatencyRecorder recorder(BENCH_MAP_REDUCE_PASSES);
+			size_t bytes = 0;
+			bool ok = true;
+
+			for (size_t i = 0; i < BENCH_MAP_REDUCE_PASSES && ok; i++)
+			{
+				recorder.start();
+				retObj<FileObj::scan_stats> stats = handler.scanStats(true);
+				recorder.stop();
+
+				ok = stats.statusObj == ra_succss && stats.obj.new_lines == file.offsets.size() - 1;
+				bytes += file.size;
+			}
+
+			recorder.end();
+			report(makeResult("scan_stats", buff_type, buff_size, recorder, bytes, ok));
+		}
+
+		if (wanted("gzip") && buff_type == bufferType::full_buffer && FileObj::FileCodec::isAvailable(FileObj::codecType::gzip)) // writeToFile of lines into a gzip file and forEachLine over it, with the codec on the caller's thread and in the background
+		{
+			const string gzip_path = write_path + ".gz";
+
+			for (const bool background : { false, true })
+			{
+				FileObj::codec_options options;
+				options.type = FileObj::codecType::gzip;
+				options.background = background;
+
+				bench_result result;
+				size_t written = 0;
+
+				{
+					FileHandler handler;
+					LatencyRecorder recorder(config.ops);
+					bool ok = handler.setCompression(options) && handler.openFile(gzip_path, openFileModes::write_z, false, buff_type, buff_size);
+
+					for (size_t i = 0; i < config.ops && ok; i++)
+					{
+						const string& line = file.sample_lines[i % file.sample_lines.size()];
+
+						recorder.start();
+						ok = handler.writeToFile(line);
+						recorder.stop();
+
+						written += line.size();
+					}
+
+					ok = handler.closeFile() && ok; // The end of the gzip member is written by the close
+					recorder.end();
+					result = makeResult(background ? "gzip_write_bg" : "gzip_write", buff_type, buff_size, recorder, written, ok);
+				}
+
+				report(result);
+
+				FileHandler handler;
+				LatencyRecorder recorder(1);
+				bool ok = handler.setCompression(options) && handler.openFile(gzip_path, openFileModes::read_z, false, buff_type, buff_size);
+				size_t bytes = 0;
+
+				recorder.start();
+				ok = ok && handler.forEachLine([&](string_view line) { bytes += line.size() + 1; }).statusObj == ra_succss;
+				recorder.stop();
+
+				recorder.end();
+				report(makeResult(background ? "gzip_read_bg" : "gzip_read", buff_type, buff_size, recorder, bytes, ok && bytes == written));
+			}
+
+			std::error_code error;
+			std::filesystem::remove(gzip_path, error);
+		}
+
+		std::error_code error;
+		std::filesystem::remove(write_path, error);
+	}
+
+	/*
+		The function writes all the results as one JSON document.
+	*/
+	static void writeJson(ostream& os, const bench_config& config, const bench_file& file, const vector<bench_result>& results)
+	{
+		os << "{\n\t\"benchmark\": \"file_bench\",\n\t\"label\": ";
+		writeJsonString(os, config.label);
+		os << ",\n\t\"timestamp\": " << (long long)time(NULL) << ",\n\t\"config\": {" <<
+			"\"file_bytes\": " << file.size << ", \"lines\": " << file.offsets.size() - 1 <<
+			", \"line_min\": " << config.line_min << ", \"line_max\": " << config.line_max << ", \"line_dist\": \"" << getDistName(config.dist) << "\"" <<
+			", \"ops\": " << config.ops << ", \"batch\": " << config.batch << ", \"seed\": " << config.seed <<
+			", \"hardware_threads\": " << std::thread::hardware_concurrency() << "},\n\t\"results\": [";
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const bench_result& result = results[i];
+			const double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+
+			os << (i > 0 ? "," : "") << "\n\t\t{\"name\": \"" << result.name << "\", \"buffer_type\": \"" << result.buffer_type << "\", \"buffer_size\": " << result.buffer_size <<
+				", \"ops\": " << result.ops << ", \"bytes\": " << result.bytes << ", \"seconds\": " << result.seconds <<
+				", \"mb_per_s\": " << (double)result.bytes / (1024.0 * 1024.0) / seconds << ", \"ops_per_s\": " << (double)result.ops / seconds <<
+				", \"p50_us\": " << result.p50_us << ", \"p99_us\": " << result.p99_us << ", \"ok\": " << (result.ok ? "true" : "false") << "}";
+		}
+
+		os << "\n\t]\n}\n";
+	}
+
+	/*
+		The function prints how the benchmark is used.
+	*/
+	static void printUsage(const char* name)
+	{
+		std::cerr << "Usage: " << name << " [options]\n" <<
+			"  --size-mb N        Size of the generated file (default " << BENCH_DFLT_FILE_MB << ")\n" <<
+			"  --line-min N       Shortest line (default " << BENCH_DFLT_LINE_MIN << ")\n" <<
+			"  --line-max N       Longest line (default " << BENCH_DFLT_LINE_MAX << ")\n" <<
+			"  --line-dist D      fixed, uniform or exp (default uniform)\n" <<
+			"  --ops N            Most operations of every benchmark (default " << BENCH_DFLT_OPS << ")\n" <<
+			"  --batch N          Lines in every getLineMultiThreaded call (default " << BENCH_DFLT_BATCH << ")\n" <<
+			"  --buffers A,B,...  Buffer sizes of the line and full buffer types (default 512,4096,65536)\n" <<
+			"  --seed N           Seed of the generated file and the random lines\n" <<
+			"  --dir PATH         Directory of the generated files (default the temp directory)\n" <<
+			"  --label TEXT       Kept in the output, to tell runs apart\n" <<
+			"  --only NAME        Runs only the benchmarks whose name has NAME\n" <<
+			"  --out PATH         Writes the JSON into PATH instead of the standard output\n" <<
+			"  --trace PATH       Writes every operation into PATH as Chrome trace-event JSON (slows the run)\n";
+	}
+
+	/*
+		The function reads the options of the run, and returns false if one of them is wrong.
+	*/
+	static bool parseArgs(int argc, char** argv, bench_config& config)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const string arg = argv[i];
+			if (arg == "--help" || arg == "-h") { return false; }
+			if (i + 1 >= argc) { std::cerr << "Missing value for " << arg << std::endl; return false; }
+
+			const string value = argv[++i];
+
+			try
+			{
+				if (arg == "--size-mb") { config.file_mb = std::stoul(value); }
+				else if (arg == "--line-min") { config.line_min = std::stoul(value); }
+				else if (arg == "--line-max") { config.line_max = std::stoul(value); }
+				else if (arg == "--ops") { config.ops = std::stoul(value); }
+				else if (arg == "--batch") { config.batch = std::stoul(value); }
+				else if (arg == "--seed") { config.seed = (unsigned int)std::stoul(value); }
+				else if (arg == "--dir") { config.dir = value; }
+				else if (arg == "--label") { config.label = value; }
+				else if (arg == "--only") { config.only = value; }
+				else if (arg == "--out") { config.out_path = value; }
+				else if (arg == "--trace") { config.trace_path = value; }
+				else if (arg == "--line-dist")
+				{
+					if (value == "fixed") { config.dist = lineDist::fixed; }
+					else if (value == "uniform") { config.dist = lineDist::uniform; }
+					else if (value == "exp") { config.dist = lineDist::exp; }
+					else { std::cerr << "Unknown line spread: " << value << std::endl; return false; }
+				}
+				else if (arg == "--buffers")
+				{
+					config.buffer_sizes.clear();
+					std::stringstream sizes(value);
+					string size;
+
+					while (std::getline(sizes, size, ',')) { config.buffer_sizes.push_back(std::stoul(size)); }
+				}
+				else { std::cerr << "Unknown option: " << arg << std::endl; return false; }
+			}
+			catch (const std::exception&) { std::cerr << "Wrong value for " << arg << ": " << value << std::endl; return false; }
+		}
+
+		if (config.file_mb == 0 || config.line_max == 0 || config.line_min > config.line_max || config.ops == 0 || config.batch == 0)
+		{
+			std::cerr << "The sizes must be above 0, and the shortest line can't be longer than the longest" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace FileBench;
+
+	bench_config config = { "", BENCH_DFLT_FILE_MB, BENCH_DFLT_LINE_MIN, BENCH_DFLT_LINE_MAX, lineDist::uniform, BENCH_DFLT_OPS, BENCH_DFLT_BATCH,
+		BENCH_DFLT_BUFFERS, BENCH_DFLT_SEED, "", "", "", "" };
+
+	if (!parseArgs(argc, argv, config)) { printUsage(argv[0]); return 1; }
+
+	std::error_code error;
+	if (config.dir.empty()) { config.dir = std::filesystem::temp_directory_path(error).string(); }
+
+	bench_file file;
+	file.path = (std::filesystem::path(config.dir) / ("file_bench_" + std::to_string(config.seed) + ".txt")).string();
+
+	std::cerr << "Generating " << config.file_mb << " MB at " << file.path << std::endl;
+	if (!generateFile(config, file)) { std::cerr << "Couldn't generate the file" << std::endl; return 1; }
+
+	vector<bench_result> results;
+	std::unique_ptr<FileObj::FileTraceSink> sink;
+
+	if (!config.trace_path.empty())
+	{
+		sink = std::make_unique<FileObj::FileTraceSink>();
+		FileObj::FileObserver::setGlobalObserver(sink.get());
+	}
+
+	try
+	{
+		runBuffer(config, file, bufferType::non_buffer, 0, results);
+
+		for (const bufferType& buff_type : { bufferType::line_buffer, bufferType::full_buffer })
+		{
+			for (size_t buff_size : config.buffer_sizes) { runBuffer(config, file, buff_type, buff_size, results); }
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "The benchmark failed: " << e.what() << std::endl;
+		std::filesystem::remove(file.path, error);
+		return 1;
+	}
+
+	std::filesystem::remove(file.path, error);
+
+	if (sink != nullptr)
+	{
+		FileObj::FileObserver::setGlobalObserver(nullptr);
+		if (!sink->writeTrace(config.trace_path)) { std::cerr << "Couldn't write the trace into " << config.trace_path << std::endl; }
+	}
+
+	if (config.out_path.empty()) { writeJson(std::cout, config, file, results); }
+	else
+	{
+		std::ofstream out(config.out_path);
+		if (!out) { std::cerr << "Couldn't open " << config.out_path << std::endl; return 1; }
+		writeJson(out, config, file, results);
+	}
+
+	bool all_ok = true;
+	for (const bench_result& result : results) { all_ok = all_ok && result.ok; }
+
+	return all_ok ? 0 : 2;
+}